@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifndef RUMUR_API
+#define RUMUR_API __attribute__((visibility("default")))
+#endif
+
+namespace rumur {
+
+/* A region of memory nodes can be allocated from in bulk
+ *
+ * Parsing creates a large number of small nodes. Rather than requesting each of
+ * these individually from the system allocator, the parser carves them out of
+ * large blocks owned by an arena. The memory of an individual node is not
+ * reclaimed when it is destroyed. Instead, all of an arena’s blocks are
+ * released together once every node allocated from it has been destroyed.
+ */
+class RUMUR_API Arena {
+
+private:
+  std::vector<void *> blocks;
+
+  // unused space at the end of the most recent block
+  char *next = nullptr;
+  size_t remaining = 0;
+
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena();
+
+  /// get memory of the given size, aligned to the given (power of 2) boundary,
+  /// which must be no stricter than that of std::max_align_t
+  void *allocate(size_t size, size_t alignment);
+
+  /// the arena `Ptr::make` allocates from on the current thread, if any
+  static std::shared_ptr<Arena> &current();
+};
+
+/// a standard allocator that draws from an arena and keeps it alive
+template <typename T> class ArenaAllocator {
+
+  template <typename> friend class ArenaAllocator;
+
+private:
+  std::shared_ptr<Arena> arena;
+
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(std::shared_ptr<Arena> arena_)
+      : arena(std::move(arena_)) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  // memory is only released when the arena itself is destroyed
+  void deallocate(T *, size_t) {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+    return arena == other.arena;
+  }
+
+  template <typename U> bool operator!=(const ArenaAllocator<U> &other) const {
+    return arena != other.arena;
+  }
+};
+
+/// make an arena current on this thread for the lifetime of this object
+class RUMUR_API ArenaScope {
+
+private:
+  std::shared_ptr<Arena> previous;
+
+public:
+  explicit ArenaScope(std::shared_ptr<Arena> arena)
+      : previous(std::move(Arena::current())) {
+    Arena::current() = std::move(arena);
+  }
+
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+
+  ~ArenaScope() { Arena::current() = std::move(previous); }
+};
+
+} // namespace rumur
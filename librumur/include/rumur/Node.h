@@ -33,7 +33,8 @@ struct RUMUR_API_WITH_RTTI Node {
   /// Create a copy of this node. This is necessary rather than simply relying
   /// on the copy constructor because of the inheritance hierarchy. That is, an
   /// agnostic class like `Ptr` can call this to copy a node without knowing
-  /// its precise derived type and without object slicing.
+  /// its precise derived type and without object slicing. Children are held by
+  /// `Ptr` and so are shared with the original rather than copied.
   virtual Node *clone() const = 0;
 
   /// Confirm that data structure invariants hold. This function throws
@@ -3,7 +3,8 @@
 #include <cassert>
 #include <cstddef>
 #include <memory>
-#include <stdexcept>
+#include <rumur/Arena.h>
+#include <type_traits>
 #include <utility>
 
 #ifndef RUMUR_API
@@ -12,11 +13,37 @@
 
 namespace rumur {
 
-// An implementation of a managed pointer that understands *::clone()
+/* An implementation of a managed pointer that understands *::clone()
+ *
+ * Pointers have value semantics, in that mutating the target of one `Ptr`
+ * never affects another `Ptr` it was copied from or to. However, copies are
+ * cheap. A copy shares its target with the original and the target is only
+ * cloned when one of the sharers asks for mutable access to it while others
+ * still hold it (copy-on-write). Because node members are themselves `Ptr`s, a
+ * clone only copies the one node and continues to share its children, so
+ * copying and then modifying part of an AST only duplicates the path from the
+ * root to the modified node.
+ *
+ * A consequence is that a mutable reference obtained through a `Ptr` should
+ * not be retained across copying of that `Ptr`, or of any `Ptr` to a node
+ * containing the target. Writes through such a reference will be seen by all
+ * copies.
+ */
 template <typename TARGET> class RUMUR_API Ptr {
 
+  template <typename> friend class Ptr;
+
 private:
-  std::unique_ptr<TARGET> t = std::unique_ptr<TARGET>(nullptr);
+  std::shared_ptr<TARGET> t;
+
+  /// ensure we are the only holder of our target, so it can be mutated
+  void detach() {
+    // targets we only ever give out const access to never need copying
+    if (std::is_const<TARGET>::value)
+      return;
+    if (t != nullptr && t.use_count() > 1)
+      t.reset(t->clone());
+  }
 
 public:
   Ptr() = default;
@@ -25,7 +52,7 @@ public:
 
   explicit Ptr(TARGET *t_) : t(t_) {}
 
-  Ptr(const Ptr &p) : t(p.t == nullptr ? nullptr : p.t->clone()) {}
+  Ptr(const Ptr &) = default;
 
   Ptr(Ptr &&p) noexcept {
     using std::swap;
@@ -33,12 +60,11 @@ public:
   }
 
   template <typename SUBTYPE>
-  Ptr(const Ptr<SUBTYPE> &p) : t(p.get() == nullptr ? nullptr : p->clone()) {}
+  Ptr(const Ptr<SUBTYPE> &p)
+      : t(std::const_pointer_cast<typename std::remove_const<SUBTYPE>::type>(
+            p.t)) {}
 
-  Ptr &operator=(const Ptr &p) {
-    t.reset(p.t == nullptr ? nullptr : p.t->clone());
-    return *this;
-  }
+  Ptr &operator=(const Ptr &) = default;
 
   Ptr &operator=(Ptr &&p) noexcept {
     using std::swap;
@@ -47,13 +73,16 @@ public:
   }
 
   template <typename SUBTYPE> Ptr &operator=(const Ptr<SUBTYPE> &p) {
-    t.reset(p.get() == nullptr ? nullptr : p->clone());
+    t = std::const_pointer_cast<typename std::remove_const<SUBTYPE>::type>(p.t);
     return *this;
   }
 
   const TARGET *get() const { return t.get(); }
 
-  TARGET *get() { return t.get(); }
+  TARGET *get() {
+    detach();
+    return t.get();
+  }
 
   template <typename SUBTYPE> Ptr<SUBTYPE> narrow() {
 
@@ -62,13 +91,16 @@ public:
     if (subtype == nullptr)
       return Ptr<SUBTYPE>(nullptr);
 
-    // if so, steal our pointer
-    (void)t.release();
-    return Ptr<SUBTYPE>(subtype);
+    // if so, hand our reference over to the narrowed pointer
+    Ptr<SUBTYPE> narrowed;
+    narrowed.t = std::shared_ptr<SUBTYPE>(t, subtype);
+    t.reset();
+    return narrowed;
   }
 
   TARGET &operator*() {
     assert(t != nullptr && "dereferencing a null pointer");
+    detach();
     return *t;
   }
 
@@ -79,6 +111,7 @@ public:
 
   TARGET *operator->() {
     assert(t != nullptr && "dereferencing a null pointer");
+    detach();
     return t.get();
   }
 
@@ -95,14 +128,19 @@ public:
 
   bool operator!=(const TARGET *other) const { return t.get() != other; }
 
+  /// construct a new target, allocating it from the current thread’s arena
+  /// if there is one (see `Arena`)
   template <typename... Args> static Ptr<TARGET> make(Args &&...args) {
-    auto p = new TARGET(std::forward<Args>(args)...);
-    try {
-      return Ptr<TARGET>{p};
-    } catch (std::exception &) {
-      delete p;
-      throw;
+    using type = typename std::remove_const<TARGET>::type;
+    Ptr<TARGET> p;
+    const std::shared_ptr<Arena> &arena = Arena::current();
+    if (arena != nullptr) {
+      p.t = std::allocate_shared<type>(ArenaAllocator<type>(arena),
+                                       std::forward<Args>(args)...);
+    } else {
+      p.t = std::make_shared<type>(std::forward<Args>(args)...);
     }
+    return p;
   }
 };
 
@@ -9,6 +9,7 @@
 #include <rumur/except.h>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #ifndef RUMUR_API
@@ -20,9 +21,28 @@ namespace rumur {
 class RUMUR_API Symtab {
 
 private:
-  std::vector<std::unordered_map<std::string, const Node *>> scope;
+  // Every name that has been declared. Scopes are keyed by pointers into this,
+  // so that a lookup only needs to hash the name being looked up once, rather
+  // than once per open scope, and then compares pointers within each scope.
+  std::unordered_set<std::string> names;
+
+  std::vector<std::unordered_map<const std::string *, Ptr<const Node>>> scope;
+
+  /// find the canonical copy of a name, creating it if necessary
+  const std::string *intern(const std::string &name) {
+    return &*names.insert(name).first;
+  }
 
 public:
+  Symtab() = default;
+
+  // Scopes point into `names`, so a copy would refer to the original's names.
+  // Moving is fine, as it hands the same names over.
+  Symtab(const Symtab &) = delete;
+  Symtab &operator=(const Symtab &) = delete;
+  Symtab(Symtab &&) = default;
+  Symtab &operator=(Symtab &&) = default;
+
   void open_scope() { scope.emplace_back(); }
 
   void close_scope() {
@@ -32,27 +52,43 @@ public:
 
   /// make a new symbol available for lookup
   ///
-  /// It is assumed `value` will outlive `*this`, and thus can be retained
-  /// internally.
+  /// The symbol table shares `value` with the caller, as do the results of
+  /// later lookups. So `value` should be complete before it is declared.
+  /// Subsequent changes through the caller's pointer do not affect the
+  /// symbol table's copy (see `Ptr`).
   ///
   /// @param name Symbol name
   /// @param value Node this name should resolve to
-  void declare(const std::string &name, const Node *value) {
+  template <typename T>
+  void declare(const std::string &name, const Ptr<T> &value) {
     assert(!scope.empty());
     assert(value != nullptr);
-    if (scope.back().count(name) > 0)
+    const std::string *id = intern(name);
+    if (scope.back().count(id) > 0)
       throw Error("symbol \"" + name + "\" was previously declared",
                   value->loc);
-    scope.back()[name] = value;
+    scope.back()[id] = value;
   }
 
+  /// find the node a symbol resolves to
+  ///
+  /// The returned pointer shares the declared node rather than copying it, so
+  /// lookups are cheap regardless of the size of the declaration.
   template <typename U>
   Ptr<U> lookup(const std::string &name, const location &loc) const {
+    // a name that was never declared cannot be in any scope
+    auto interned = names.find(name);
+    if (interned == names.end())
+      throw Error("unknown symbol: " + name, loc);
+    const std::string *id = &*interned;
+
     for (auto it = scope.rbegin(); it != scope.rend(); it++) {
-      auto it2 = it->find(name);
+      auto it2 = it->find(id);
       if (it2 != it->end()) {
-        if (auto ret = dynamic_cast<const U *>(it2->second)) {
-          return Ptr<U>(ret->clone());
+        Ptr<const Node> n = it2->second;
+        Ptr<const U> ret = n.template narrow<const U>();
+        if (ret != nullptr) {
+          return ret;
         } else {
           break;
         }
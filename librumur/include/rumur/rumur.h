@@ -17,6 +17,7 @@ class RUMUR_API parser;
 #include "parser.yy.hh"
 #include "position.hh"
 #include <cstddef>
+#include <rumur/Arena.h>
 #include <rumur/Boolean.h>
 #include <rumur/Comment.h>
 #include <rumur/Decl.h>
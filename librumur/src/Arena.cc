@@ -0,0 +1,50 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <rumur/Arena.h>
+
+namespace rumur {
+
+// size of the blocks an arena requests from the system allocator
+static const size_t BLOCK_SIZE = 64 * 1024;
+
+Arena::~Arena() {
+  for (void *b : blocks)
+    ::operator delete(b);
+}
+
+void *Arena::allocate(size_t size, size_t alignment) {
+  assert(alignment != 0 && (alignment & (alignment - 1)) == 0 &&
+         "non-power-of-2 alignment requested");
+  assert(alignment <= alignof(std::max_align_t) &&
+         "alignment beyond what a new block is guaranteed to have");
+
+  // padding needed to align the next free byte
+  size_t padding = (alignment - reinterpret_cast<uintptr_t>(next) % alignment) %
+                   alignment;
+
+  if (next == nullptr || padding + size > remaining) {
+    // Start a new block. The system allocator’s memory is suitably aligned
+    // for any fundamental type, so no padding is needed at its start.
+    const size_t block_size = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+    blocks.reserve(blocks.size() + 1);
+    next = static_cast<char *>(::operator new(block_size));
+    blocks.push_back(next);
+    remaining = block_size;
+    padding = 0;
+  }
+
+  void *p = next + padding;
+  next += padding + size;
+  remaining -= padding + size;
+  return p;
+}
+
+std::shared_ptr<Arena> &Arena::current() {
+  static thread_local std::shared_ptr<Arena> arena;
+  return arena;
+}
+
+} // namespace rumur
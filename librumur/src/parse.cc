@@ -4,6 +4,8 @@
 #include <cstddef>
 #include <exception>
 #include <iostream>
+#include <memory>
+#include <rumur/Arena.h>
 #include <rumur/Decl.h>
 #include <rumur/Model.h>
 #include <rumur/Ptr.h>
@@ -17,6 +19,10 @@ using namespace rumur;
 template <typename T, int STARTER>
 static Ptr<T> parse_node(std::istream &input) {
 
+  // Allocate the nodes of the AST from a common arena, which will live until
+  // the last of them is destroyed
+  ArenaScope arena(std::make_shared<Arena>());
+
   // Setup the parser
   scanner s(&input);
   Ptr<Node> answer;
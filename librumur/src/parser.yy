@@ -274,13 +274,13 @@ model: nodes {
 };
 
 nodes: nodes decl {
-  $$ = $1;
+  $$ = std::move($1);
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 } | nodes procdecl {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | nodes rule semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | %empty {
 };
@@ -314,20 +314,20 @@ decl: CONST exprdecls {
     $$.push_back(rumur::Ptr<rumur::ConstDecl>::make(std::get<0>(d), std::get<1>(d), std::get<2>(d)));
   }
 } | TYPE typedecls {
-  $$ = $2;
+  $$ = std::move($2);
 } | VAR vardecls {
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 };
 
 decls: decls decl {
-  $$ = $1;
+  $$ = std::move($1);
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 } | %empty {
   /* nothing required */
 };
 
 decls_header: decls BEGIN_TOK {
-  $$ = $1;
+  $$ = std::move($1);
 } | %empty {
 };
 
@@ -345,7 +345,7 @@ else_opt: ELSE stmts {
 };
 
 elsifs: elsifs ELSIF expr THEN stmts {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back(rumur::IfClause($3, $5, rumur::location(@2.begin, @5.end)));
 } | %empty {
 };
@@ -414,7 +414,7 @@ expr: expr '?' expr ':' expr {
 } | expr '-' expr {
   $$ = rumur::Ptr<rumur::Sub>::make($1, $3, @$);
 } | '+' expr %prec '*' {
-  $$ = $2;
+  $$ = std::move($2);
   $$->loc = @$;
 } | '-' expr %prec '*' {
   $$ = rumur::Ptr<rumur::Negative>::make($2, @$);
@@ -429,11 +429,11 @@ expr: expr '?' expr ':' expr {
 } | EXISTS quantifier DO expr endexists {
     $$ = rumur::Ptr<rumur::Exists>::make(*$2, $4, @$);
 } | designator {
-  $$ = $1;
+  $$ = std::move($1);
 } | NUMBER {
   $$ = rumur::Ptr<rumur::Number>::make($1, @$);
 } | '(' expr ')' {
-  $$ = $2;
+  $$ = std::move($2);
   $$->loc = @$;
 } | ID '(' exprlist ')' {
   $$ = rumur::Ptr<rumur::FunctionCall>::make($1, $3, @$);
@@ -450,20 +450,20 @@ exprdecl: id_list_opt ':' expr {
 };
 
 exprdecls: exprdecls exprdecl semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 } | %empty {
   /* nothing required */
 };
 
 exprlist: exprlist_cont expr comma_opt {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | %empty {
 };
 
 exprlist_cont: exprlist_cont expr ',' {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | %empty {
 };
@@ -471,13 +471,13 @@ exprlist_cont: exprlist_cont expr ',' {
 function: FUNCTION | PROCEDURE;
 
 guard_opt: expr ARROW {
-  $$ = $1;
+  $$ = std::move($1);
 } | %empty {
   $$ = nullptr;
 };
 
 id_list: id_list ',' ID {
-  $$ = $1;
+  $$ = std::move($1);
   $$.emplace_back(std::make_pair($3, @3));
 } | ID {
   $$.emplace_back(std::make_pair($1, @$));
@@ -487,7 +487,7 @@ id_list: id_list ',' ID {
    * an input mdoels.
    */
 id_list_opt: id_list comma_opt {
-  $$ = $1;
+  $$ = std::move($1);
 } | %empty {
 };
 
@@ -500,7 +500,7 @@ parameter: var_opt id_list ':' typeexpr {
 };
 
 parameters: parameters parameter semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 } | %empty {
 };
@@ -526,32 +526,32 @@ quantifier: ID ':' typeexpr {
 };
 
 quantifiers: quantifiers semis quantifier {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back(*$3);
 } | quantifier {
   $$.push_back(*$1);
 };
 
 return_type: ':' typeexpr semi_opt {
-  $$ = $2;
+  $$ = std::move($2);
 } | semi_opt {
   $$ = nullptr;
 };
 
 rule: startstate {
-  $$ = $1;
+  $$ = std::move($1);
 } | simplerule {
-  $$ = $1;
+  $$ = std::move($1);
 } | property {
-  $$ = $1;
+  $$ = std::move($1);
 } | ruleset {
-  $$ = $1;
+  $$ = std::move($1);
 } | aliasrule {
-  $$ = $1;
+  $$ = std::move($1);
 };
 
 rules: rules rule semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | %empty {
 };
@@ -617,7 +617,7 @@ stmt: category STRING expr {
 };
 
 stmts: stmts_cont stmt semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | stmt semi_opt {
   $$.push_back($1);
@@ -625,27 +625,27 @@ stmts: stmts_cont stmt semi_opt {
 };
 
 stmts_cont: stmts_cont stmt semis {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | stmt semis {
   $$.push_back($1);
 };
 
 string_opt: STRING {
-  $$ = $1;
+  $$ = std::move($1);
 } | %empty {
   /* nothing required */
 };
 
 switchcases: switchcases_cont ELSE stmts {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back(rumur::SwitchCase(std::vector<Ptr<rumur::Expr>>(), $3, @$));
 } | switchcases_cont {
-  $$ = $1;
+  $$ = std::move($1);
 };
 
 switchcases_cont: switchcases_cont CASE exprlist ':' stmts {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back(rumur::SwitchCase($3, $5, @$));
 } | %empty {
   /* nothing required */
@@ -658,7 +658,7 @@ typedecl: id_list_opt ':' typeexpr {
 };
 
 typedecls: typedecls typedecl semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 } | %empty {
   /* nothing required */
@@ -687,14 +687,14 @@ typeexpr: BOOLEAN {
 };
 
 typeexprs: typeexprs_cont typeexpr comma_opt {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | %empty {
   /* nothing required */
 };
 
 typeexprs_cont: typeexprs_cont typeexpr ',' {
-  $$ = $1;
+  $$ = std::move($1);
   $$.push_back($2);
 } | %empty {
   /* nothing required */
@@ -707,7 +707,7 @@ vardecl: id_list_opt ':' typeexpr {
 };
 
 vardecls: vardecls vardecl semi_opt {
-  $$ = $1;
+  $$ = std::move($1);
   std::move($2.begin(), $2.end(), std::back_inserter($$));
 } | %empty {
   /* nothing required */
@@ -24,18 +24,6 @@
 
 using namespace rumur;
 
-/// C++11 polyfill for `std::make_unique`
-template <typename T, typename... Args>
-static std::unique_ptr<T> make_unique(Args &&...args) {
-  auto raw = new T(std::forward<Args>(args)...);
-  try {
-    return std::unique_ptr<T>{raw};
-  } catch (std::exception &) {
-    delete raw;
-    throw;
-  }
-}
-
 namespace {
 
 class Resolver : public Traversal {
@@ -43,19 +31,21 @@ class Resolver : public Traversal {
 private:
   Symtab symtab;
 
-  /// node copies we allocated that we are responsible for cleaning up
+  /// create an independent copy of a function whose body is not yet resolved
   ///
-  /// We can use `std::unique_ptr` instead of `Ptr` here because we never need
-  /// to copy or subclass these pointers.
-  std::vector<std::unique_ptr<Node>> heap;
+  /// Calls within a function to itself need something to refer to. Sharing the
+  /// function itself would make resolving these calls introduce a reference
+  /// cycle. So they instead refer to a deep copy of the function as it was
+  /// before its body was resolved.
+  static Ptr<Function> snapshot(const Function &f) {
+
+    // traversing with mutable access unshares each node visited
+    class Detacher : public Traversal {};
 
-  /// create a new managed node pointer
-  template <typename T, typename... Args> T *make(Args &&...args) {
-    std::unique_ptr<T> ptr = make_unique<T>(std::forward<Args>(args)...);
-    heap.push_back(std::move(ptr));
-    auto ret = dynamic_cast<T *>(heap.back().get());
-    assert(ret != nullptr);
-    return ret;
+    auto copy = Ptr<Function>::make(f);
+    Detacher detacher;
+    detacher.dispatch(*copy);
+    return copy;
   }
 
 public:
@@ -65,11 +55,11 @@ public:
     symtab.open_scope();
 
     // Teach the symbol table the built ins
-    TypeDecl *const boolean = make<TypeDecl>("boolean", Boolean, location());
+    auto boolean = Ptr<TypeDecl>::make("boolean", Boolean, location());
     symtab.declare("boolean", boolean);
     mpz_class index = 0;
     for (const std::pair<std::string, location> &m : Boolean->members) {
-      ConstDecl *const member = make<ConstDecl>(
+      auto member = Ptr<ConstDecl>::make(
           m.first, Ptr<Number>::make(index, location()), Boolean, location());
       symtab.declare(m.first, member);
       index++;
@@ -87,7 +77,7 @@ public:
     symtab.open_scope();
     for (auto &a : n.aliases) {
       dispatch(*a);
-      symtab.declare(a->name, a.get());
+      symtab.declare(a->name, a);
     }
     for (auto &r : n.rules)
       dispatch(*r);
@@ -98,7 +88,7 @@ public:
     symtab.open_scope();
     for (auto &a : n.aliases) {
       dispatch(*a);
-      symtab.declare(a->name, a.get());
+      symtab.declare(a->name, a);
     }
     for (auto &s : n.body)
       dispatch(*s);
@@ -150,7 +140,7 @@ public:
     mpz_class index = 0;
     size_t id = e->unique_id + 1;
     for (const std::pair<std::string, location> &m : n.members) {
-      ConstDecl *const member = make<ConstDecl>(
+      auto member = Ptr<ConstDecl>::make(
           m.first, Ptr<Number>::make(index, m.second), e, m.second);
       // assign this member a unique id so that referrers can use it if need be
       assert(id < e->unique_id_limit &&
@@ -214,15 +204,15 @@ public:
     // register the function itself, even though its body has not yet been
     // resolved, in order to allow contained function calls to resolve to the
     // containing function, supporting recursion
-    symtab.declare(n.name, &n);
+    symtab.declare(n.name, snapshot(n));
     // only register the function parameters now, to avoid their names shadowing
     // anything that needs to be resolved during symbol resolution of another
     // parameter or the return type
     for (auto &p : n.parameters)
-      symtab.declare(p->name, p.get());
+      symtab.declare(p->name, p);
     for (auto &d : n.decls) {
       dispatch(*d);
-      symtab.declare(d->name, d.get());
+      symtab.declare(d->name, d);
     }
     for (auto &s : n.body)
       dispatch(*s);
@@ -314,10 +304,13 @@ public:
         }
       }
 
-      if (auto d = dynamic_cast<Decl *>(c.get()))
-        symtab.declare(d->name, c.get());
-      if (auto f = dynamic_cast<Function *>(c.get()))
-        symtab.declare(f->name, c.get());
+      // inspect the child through a const pointer, as mutable access after it
+      // has been declared would unshare it from the symbol table
+      const Node *child = c.get();
+      if (auto d = dynamic_cast<const Decl *>(child))
+        symtab.declare(d->name, c);
+      if (auto f = dynamic_cast<const Function *>(child))
+        symtab.declare(f->name, c);
     }
   }
 
@@ -386,7 +379,7 @@ public:
 
     dispatch(*n.decl);
 
-    symtab.declare(n.name, n.decl.get());
+    symtab.declare(n.name, n.decl);
   }
 
   void visit_range(Range &n) final {
@@ -427,7 +420,7 @@ public:
       dispatch(*n.guard);
     for (auto &d : n.decls) {
       dispatch(*d);
-      symtab.declare(d->name, d.get());
+      symtab.declare(d->name, d);
     }
     for (auto &s : n.body)
       dispatch(*s);
@@ -442,7 +435,7 @@ public:
       dispatch(q);
     for (auto &d : n.decls) {
       dispatch(*d);
-      symtab.declare(d->name, d.get());
+      symtab.declare(d->name, d);
     }
     for (auto &s : n.body)
       dispatch(*s);
@@ -115,25 +115,36 @@ enum {
  * compatible with GCC <4.9.
  */
 
+/* Settings that can be overridden on the command line (see parse_args()). They
+ * default to the values the checker was generated with. THREADS also sizes the
+ * per-thread arrays below, so the number of threads can only be lowered.
+ */
+SHARED size_t thread_count SHARED_INIT(THREADS);
+SHARED size_t set_capacity SHARED_INIT(SET_CAPACITY);
+SHARED unsigned set_expand_threshold SHARED_INIT(SET_EXPAND_THRESHOLD);
+SHARED unsigned long max_errors SHARED_INIT(MAX_ERRORS);
+SHARED enum color color SHARED_INIT((enum color)COLOR);
+SHARED bool machine_readable_output SHARED_INIT(MACHINE_READABLE_OUTPUT);
+
 /* Identifier of the current thread. This counts up from 0 and thus is suitable
  * to use for, e.g., indexing into arrays. The initial thread has ID 0.
  */
-static _Thread_local size_t thread_id;
+SHARED _Thread_local size_t thread_id;
 
 /* The threads themselves. Note that we have no element for the initial thread,
  * so *your* thread is 'threads[thread_id - 1]'.
  */
-static pthread_t threads[THREADS - 1];
+SHARED pthread_t threads[THREADS - 1];
 
 /* What we are currently doing. Either "warming up" (running single threaded
  * building up queue occupancy) or "free running" (running multithreaded).
  */
-static enum { WARMUP, RUN } phase = WARMUP;
+SHARED enum { WARMUP, RUN } phase SHARED_INIT(WARMUP);
 
 /* Number of errors we've noted so far. If a thread sees this hit or exceed
- * MAX_ERRORS, they should attempt to exit gracefully as soon as possible.
+ * max_errors, they should attempt to exit gracefully as soon as possible.
  */
-static unsigned long error_count;
+SHARED unsigned long error_count;
 
 /* Number of rules that have been processed. There are two representations of
  * this: a thread-local count of how many rules we have fired thus far and a
@@ -143,28 +154,94 @@ static unsigned long error_count;
  * this during checking, rather than having all threads contending on the global
  * array whose entries are likely all within the same cache line.
  */
-static _Thread_local uintmax_t rules_fired_local;
-static uintmax_t rules_fired[THREADS];
+SHARED _Thread_local uintmax_t rules_fired_local;
+SHARED uintmax_t rules_fired[THREADS];
+
+/* Number of lookups in, and hits from, the canonicalisation cache. These use
+ * the same thread-local/global split as the fired rule counts above.
+ */
+SHARED _Thread_local uintmax_t canonicalisation_cache_lookups_local;
+SHARED _Thread_local uintmax_t canonicalisation_cache_hits_local;
+SHARED uintmax_t canonicalisation_cache_lookups[THREADS];
+SHARED uintmax_t canonicalisation_cache_hits[THREADS];
+
+/* Each thread's cache of canonicalisation results, allocated on first use and
+ * released when the thread exits.
+ */
+SHARED _Thread_local struct canonicalisation_cache_entry
+    *canonicalisation_cache;
+
+/* Number of states visited by random walks when simulating, or by each worker
+ * in swarm verification. This uses the same thread-local/global split as the
+ * fired rule counts above.
+ */
+SHARED _Thread_local uintmax_t states_visited_local;
+SHARED uintmax_t states_visited[THREADS];
+
+/* Summary of a completed run, for a host that has loaded the checker as a
+ * shared object (see rumur_checker_run()). This layout is mirrored by the host.
+ */
+struct rumur_summary {
+  uint64_t completed; /* set to 1 once the remaining fields are filled in */
+  uint64_t states;
+  uint64_t rules_fired;
+  uint64_t errors;
+  uint64_t duration_seconds;
+};
+
+/* Where to write the summary on exit, if we were started by a host. */
+SHARED struct rumur_summary *summary_sink;
+
+/* Exit the process. When started by a host, this leaves without running exit
+ * handlers, which belong to the host rather than to us.
+ */
+static _Noreturn void terminate(int status) {
+  if (summary_sink != NULL) {
+    (void)fflush(stdout);
+    (void)fflush(stderr);
+    _exit(status);
+  }
+  exit(status);
+}
+
+/* Whether we are running a search that does not track every state it has seen,
+ * and so may miss parts of the state space.
+ */
+static bool is_partial_search(void) {
+  return SIMULATE_STEPS > 0 || SWARM_BITSTATE_SIZE > 0;
+}
 
 /* Checkpoint to restore to after reporting an error. This is only used if we
  * are tolerating more than one error before exiting.
  */
-static _Thread_local sigjmp_buf checkpoint;
+SHARED _Thread_local sigjmp_buf checkpoint;
+
+/* Checkpoint to restore to if evaluating the heuristic for best-first search
+ * triggers an error. Such errors are not reported, as the heuristic evaluates
+ * parts of invariants that normal checking may short circuit.
+ */
+SHARED _Thread_local sigjmp_buf heuristic_checkpoint;
+SHARED _Thread_local bool in_heuristic;
 
 _Static_assert(MAX_ERRORS > 0, "illegal MAX_ERRORS value");
 
 /* Whether we need to save and restore checkpoints. This is determined by
  * whether we ever need to perform the action "discard the current state and
- * skip to checking the next." This scenario can occur for two reasons:
+ * skip to checking the next" from somewhere we cannot simply return from. This
+ * scenario can occur for two reasons:
  *   1. We are running multithreaded, have just found an error and have not yet
- *      hit MAX_ERRORS. In this case we want to longjmp back to resume checking.
- *   2. We failed an assume statement. In this case we want to mark the current
- *      state as invalid and resume checking with the next state.
+ *      hit max_errors. In this case we want to longjmp back to resume checking.
+ *   2. We failed an assume statement within a function or procedure. In this
+ *      case we want to mark the current state as invalid and resume checking
+ *      with the next state.
  * In either scenario the actual longjmp performed is the same, but by knowing
- * statically whether either can occur we can avoid calling setjmp if both are
- * impossible.
+ * up front whether either can occur we can avoid calling setjmp if both are
+ * impossible. Note that failing an assume statement directly within a rule or
+ * start state does not need a checkpoint as the generated code returns an
+ * error status to the caller instead.
  */
-enum { JMP_BUF_NEEDED = MAX_ERRORS > 1 || ASSUME_STATEMENTS_COUNT > 0 };
+#define JMP_BUF_NEEDED                                                         \
+  (max_errors > 1 || FUNCTION_ASSUME_STATEMENTS_COUNT > 0)
 
 /*******************************************************************************
  * Sandbox support.                                                            *
@@ -189,7 +266,7 @@ static void sandbox(void) {
     if (__builtin_expect(r != 0, 0)) {
       fprintf(stderr, "sandbox_init failed: %s\n", err);
       free(err);
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
     }
 
     return;
@@ -200,7 +277,7 @@ static void sandbox(void) {
   {
     if (__builtin_expect(cap_enter() != 0, 0)) {
       perror("cap_enter");
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
     }
     return;
   }
@@ -213,7 +290,7 @@ static void sandbox(void) {
     int r = prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
     if (__builtin_expect(r != 0, 0)) {
       perror("prctl(PR_SET_NO_NEW_PRIVS) failed");
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
     }
 
     /* A BPF program that traps on any syscall we want to disallow. */
@@ -366,7 +443,7 @@ static void sandbox(void) {
     r = prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &filter_program, 0, 0);
     if (__builtin_expect(r != 0, 0)) {
       perror("prctl(PR_SET_SECCOMP) failed");
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
     }
 
     return;
@@ -378,7 +455,7 @@ static void sandbox(void) {
   {
     if (__builtin_expect(pledge("stdio", "") != 0, 0)) {
       perror("pledge");
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
     }
     return;
   }
@@ -386,41 +463,41 @@ static void sandbox(void) {
 
   /* No sandbox available. */
   fprintf(stderr, "no sandboxing facilities available\n");
-  exit(EXIT_FAILURE);
+  terminate(EXIT_FAILURE);
 }
 
 /******************************************************************************/
 
 /* ANSI colour code support */
 
-static bool istty;
+SHARED bool istty;
 
 static const char *green(void) {
-  if (COLOR == ON || (COLOR == AUTO && istty))
+  if (color == ON || (color == AUTO && istty))
     return "\033[32m";
   return "";
 }
 
 static const char *red(void) {
-  if (COLOR == ON || (COLOR == AUTO && istty))
+  if (color == ON || (color == AUTO && istty))
     return "\033[31m";
   return "";
 }
 
 static const char *yellow(void) {
-  if (COLOR == ON || (COLOR == AUTO && istty))
+  if (color == ON || (color == AUTO && istty))
     return "\033[33m";
   return "";
 }
 
 static const char *bold(void) {
-  if (COLOR == ON || (COLOR == AUTO && istty))
+  if (color == ON || (color == AUTO && istty))
     return "\033[1m";
   return "";
 }
 
 static const char *reset(void) {
-  if (COLOR == ON || (COLOR == AUTO && istty))
+  if (color == ON || (color == AUTO && istty))
     return "\033[0m";
   return "";
 }
@@ -567,7 +644,7 @@ static uint64_t MurmurHash64A(const void *NONNULL key, size_t len) {
 /* Signal an out-of-memory condition and terminate abruptly. */
 static _Noreturn void oom(void) {
   fputs("out of memory", stderr);
-  exit(EXIT_FAILURE);
+  terminate(EXIT_FAILURE);
 }
 
 static void *xmalloc(size_t size) {
@@ -584,6 +661,13 @@ static void *xcalloc(size_t count, size_t size) {
   return p;
 }
 
+static void *xrealloc(void *ptr, size_t size) {
+  void *p = realloc(ptr, size);
+  if (__builtin_expect(p == NULL, 0))
+    oom();
+  return p;
+}
+
 static void put(const char *NONNULL s) {
   for (; *s != '\0'; ++s)
     putchar_unlocked(*s);
@@ -1282,13 +1366,13 @@ static __attribute__((unused)) void state_schedule_set(struct state *NONNULL s,
  ******************************************************************************/
 
 /* An initial size of thread-local allocator pools ~8MB. */
-static _Thread_local size_t arena_count =
+SHARED _Thread_local size_t arena_count SHARED_INIT(
     (sizeof(struct state) > 8 * 1024 * 1024)
         ? 1
-        : (8 * 1024 * 1024 / sizeof(struct state));
+        : (8 * 1024 * 1024 / sizeof(struct state)));
 
-static _Thread_local struct state *arena_base;
-static _Thread_local struct state *arena_limit;
+SHARED _Thread_local struct state *arena_base;
+SHARED _Thread_local struct state *arena_limit;
 
 static struct state *state_new(void) {
 
@@ -1338,13 +1422,15 @@ static void state_free(struct state *s) {
  ******************************************************************************/
 
 /* number of allocated state structs per depth of expansion */
-static size_t allocated[BOUND == 0 ? 1 : (BOUND + 1)];
+SHARED size_t allocated[BOUND == 0 ? 1 : (BOUND + 1)];
 
 /* note a new allocation of a state struct at the given depth */
 static void register_allocation(size_t depth) {
 
-  /* if we are not tracing memory usage, make this a no-op */
-  if (!(TC_MEMORY_USAGE & TRACES_ENABLED))
+  /* if we are neither tracing memory usage nor reporting progress per depth,
+   * make this a no-op
+   */
+  if (!(TC_MEMORY_USAGE & TRACES_ENABLED) && DEEPEN_STEP == 0)
     return;
 
   ASSERT(depth < sizeof(allocated) / sizeof(allocated[0]) &&
@@ -1409,17 +1495,20 @@ static _Noreturn int exit_with(int status);
 static __attribute__((format(printf, 2, 3))) _Noreturn void
 error(const struct state *NONNULL s, const char *NONNULL fmt, ...) {
 
+  if (in_heuristic)
+    siglongjmp(heuristic_checkpoint, 1);
+
   unsigned long prior_errors =
       __atomic_fetch_add(&error_count, 1, __ATOMIC_ACQ_REL);
 
-  if (__builtin_expect(prior_errors < MAX_ERRORS, 1)) {
+  if (__builtin_expect(prior_errors < max_errors, 1)) {
 
     flockfile(stdout);
 
     va_list ap;
     va_start(ap, fmt);
 
-    if (MACHINE_READABLE_OUTPUT) {
+    if (machine_readable_output) {
       put("<error includes_trace=\"");
       put((s == NULL || COUNTEREXAMPLE_TRACE == CEX_OFF) ? "false" : "true");
       put("\">\n");
@@ -1433,13 +1522,13 @@ error(const struct state *NONNULL s, const char *NONNULL fmt, ...) {
         va_end(ap2);
         if (__builtin_expect(size < 0, 0)) {
           fputs("vsnprintf failed", stderr);
-          exit(EXIT_FAILURE);
+          terminate(EXIT_FAILURE);
         }
 
         char *buffer = xmalloc(size + 1);
         if (__builtin_expect(vsnprintf(buffer, size + 1, fmt, ap) != size, 0)) {
           fputs("vsnprintf failed", stderr);
-          exit(EXIT_FAILURE);
+          terminate(EXIT_FAILURE);
         }
 
         xml_printf(buffer);
@@ -1470,13 +1559,13 @@ error(const struct state *NONNULL s, const char *NONNULL fmt, ...) {
         va_end(ap2);
         if (__builtin_expect(size < 0, 0)) {
           fputs("vsnprintf failed", stderr);
-          exit(EXIT_FAILURE);
+          terminate(EXIT_FAILURE);
         }
 
         char *buffer = xmalloc(size + 1);
         if (__builtin_expect(vsnprintf(buffer, size + 1, fmt, ap) != size, 0)) {
           fputs("vsnprintf failed", stderr);
-          exit(EXIT_FAILURE);
+          terminate(EXIT_FAILURE);
         }
 
         put(buffer);
@@ -1496,20 +1585,7 @@ error(const struct state *NONNULL s, const char *NONNULL fmt, ...) {
     funlockfile(stdout);
   }
 
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wtautological-compare"
-#pragma clang diagnostic ignored "-Wtautological-unsigned-zero-compare"
-#elif defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wtype-limits"
-#endif
-  if (prior_errors < MAX_ERRORS - 1) {
-#ifdef __clang__
-#pragma clang diagnostic pop
-#elif defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
+  if (prior_errors < max_errors - 1) {
     assert(JMP_BUF_NEEDED && "longjmping without a setup jmp_buf");
     siglongjmp(checkpoint, 1);
   }
@@ -1518,7 +1594,8 @@ error(const struct state *NONNULL s, const char *NONNULL fmt, ...) {
 }
 
 static void deadlock(const struct state *NONNULL s) {
-  if (JMP_BUF_NEEDED) {
+  /* error() will only longjmp if we have not yet hit max_errors */
+  if (max_errors > 1) {
     if (sigsetjmp(checkpoint, 0)) {
       /* error() longjmped back to us. */
       return;
@@ -1594,6 +1671,7 @@ state_drop_const(const struct state *s) {
 /* These functions are generated. */
 static void state_canonicalise_heuristic(struct state *NONNULL s);
 static void state_canonicalise_exhaustive(struct state *NONNULL s);
+static void state_canonicalise_multi(struct state *NONNULL s);
 
 static void state_canonicalise(struct state *NONNULL s) {
 
@@ -1611,22 +1689,26 @@ static void state_canonicalise(struct state *NONNULL s) {
   case SYMMETRY_REDUCTION_EXHAUSTIVE:
     state_canonicalise_exhaustive(s);
     break;
+
+  case SYMMETRY_REDUCTION_MULTI:
+    state_canonicalise_multi(s);
+    break;
   }
 }
 
 /* This function is generated. */
-static __attribute__((unused)) void state_print_field_offsets(void);
+EXPORT __attribute__((unused)) void state_print_field_offsets(void);
 
 /* Print a state to stderr. This function is generated. This function assumes
  * that the caller already holds a lock on stdout.
  */
-static __attribute__((unused)) void state_print(const struct state *previous,
+EXPORT __attribute__((unused)) void state_print(const struct state *previous,
                                                 const struct state *NONNULL s);
 
 /* Print the first rule that resulted in s. This function is generated. This
  * function assumes that the caller holds a lock on stdout.
  */
-static __attribute__((unused)) void
+EXPORT __attribute__((unused)) void
 print_transition(const struct state *NONNULL s);
 
 static void print_counterexample(const struct state *NONNULL s
@@ -1659,10 +1741,10 @@ static void print_counterexample(const struct state *NONNULL s
 
     print_transition(current);
 
-    if (MACHINE_READABLE_OUTPUT)
+    if (machine_readable_output)
       put("<state>\n");
     state_print(COUNTEREXAMPLE_TRACE == FULL ? NULL : previous, current);
-    if (MACHINE_READABLE_OUTPUT) {
+    if (machine_readable_output) {
       put("</state>\n");
     } else {
       put("----------\n\n");
@@ -1783,6 +1865,49 @@ static void handle_write_raw(const struct state *NONNULL s, struct handle h,
   write_raw(h, (uint64_t)value);
 }
 
+/* Swap two equally sized, non-overlapping ranges of bits within a state. This
+ * is used to move array elements during symmetry reduction.
+ */
+static __attribute__((unused)) void state_swap_bits(struct state *NONNULL s,
+                                                    size_t offset_a,
+                                                    size_t offset_b,
+                                                    size_t width) {
+
+  assert(sizeof(s->data) * CHAR_BIT - width >= offset_a &&
+         sizeof(s->data) * CHAR_BIT - width >= offset_b &&
+         "out of bounds swap in state_swap_bits()");
+  assert((offset_a == offset_b || offset_a + width <= offset_b ||
+          offset_b + width <= offset_a) &&
+         "overlapping swap in state_swap_bits()");
+
+  if (offset_a == offset_b)
+    return;
+
+  /* if both ranges are byte-aligned, swap them a byte at a time */
+  if (offset_a % CHAR_BIT == 0 && offset_b % CHAR_BIT == 0 &&
+      width % CHAR_BIT == 0) {
+    uint8_t *a = &s->data[offset_a / CHAR_BIT];
+    uint8_t *b = &s->data[offset_b / CHAR_BIT];
+    for (size_t i = 0; i < width / CHAR_BIT; ++i) {
+      uint8_t tmp = a[i];
+      a[i] = b[i];
+      b[i] = tmp;
+    }
+    return;
+  }
+
+  /* otherwise, swap them a word at a time */
+  for (size_t i = 0; i < width; i += 64) {
+    size_t w = width - i < 64 ? width - i : 64;
+    struct handle a = state_handle(s, offset_a + i, w);
+    struct handle b = state_handle(s, offset_b + i, w);
+    uint64_t va = read_raw(a);
+    uint64_t vb = read_raw(b);
+    write_raw(a, vb);
+    write_raw(b, va);
+  }
+}
+
 static __attribute__((unused)) void
 handle_write(const char *NONNULL context, const char *rule_name,
              const char *NONNULL name, const struct state *NONNULL s,
@@ -1809,6 +1934,28 @@ handle_write(const char *NONNULL context, const char *rule_name,
   handle_write_raw(s, h, r);
 }
 
+/* A version of handle_write() for when the code generator has proven the value
+ * being written is within the bounds of the destination.
+ */
+static __attribute__((unused)) void
+handle_write_unchecked(const struct state *NONNULL s, value_t lb, value_t ub,
+                       struct handle h, value_t value) {
+
+  /* If we happen to be writing to the current state, do a sanity check that
+   * we're only writing within bounds.
+   */
+  assert((h.base != (const unsigned char *)s->data
+          /* not a write to the current state */
+          || sizeof(s->data) * CHAR_BIT - h.width >= h.offset) /* in bounds */
+         && "out of bounds write in handle_write_unchecked()");
+
+  ASSERT(value >= lb && value <= ub &&
+         "out-of-range value in handle_write_unchecked()");
+
+  handle_write_raw(s, h,
+                   (raw_value_t)((raw_value_t)value - (raw_value_t)lb) + 1);
+}
+
 static __attribute__((unused)) void handle_zero(struct handle h) {
 
   unsigned char *p = h.base + h.offset / CHAR_BIT;
@@ -1935,6 +2082,25 @@ handle_index(const char *NONNULL context, const char *rule_name,
   };
 }
 
+/* A version of handle_index() for when the code generator has proven the index
+ * is within the bounds of the array.
+ */
+static __attribute__((unused)) struct handle
+handle_index_unchecked(size_t element_width, value_t index_min,
+                       value_t index_max, struct handle root, value_t index) {
+
+  ASSERT(index >= index_min && index <= index_max &&
+         "out-of-range index in handle_index_unchecked()");
+
+  size_t r = ((size_t)index - (size_t)index_min) * element_width;
+
+  return (struct handle){
+      .base = root.base + (root.offset + r) / CHAR_BIT,
+      .offset = (root.offset + r) % CHAR_BIT,
+      .width = element_width,
+  };
+}
+
 static __attribute__((unused)) value_t
 handle_isundefined(const struct state *NONNULL s, struct handle h) {
   raw_value_t v = handle_read_raw(s, h);
@@ -2120,6 +2286,33 @@ static __attribute__((unused)) value_t bnot(value_t v) {
   return (value_t) ~(raw_value_t)v;
 }
 
+/* combine a value into a scalarset element signature */
+static __attribute__((unused)) uint64_t signature_mix(uint64_t h, uint64_t v) {
+  h ^= v + UINT64_C(0x9e3779b97f4a7c15) + (h << 6) + (h >> 2);
+  h ^= h >> 33;
+  h *= UINT64_C(0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  return h;
+}
+
+/* count the number of distinct signatures among scalarset elements */
+static __attribute__((unused)) size_t
+count_distinct(const uint64_t *NONNULL signature, size_t count) {
+  size_t distinct = 0;
+  for (size_t i = 0; i < count; ++i) {
+    bool seen = false;
+    for (size_t j = 0; j < i; ++j) {
+      if (signature[j] == signature[i]) {
+        seen = true;
+        break;
+      }
+    }
+    if (!seen)
+      ++distinct;
+  }
+  return distinct;
+}
+
 /* use Heap's algorithm for generating permutations to implement a
  * permutation-to-number mapping
  */
@@ -2308,7 +2501,7 @@ static queue_handle_t queue_handle_next(queue_handle_t h) {
  ******************************************************************************/
 
 /* Queue node pointers currently safe to dereference. */
-static const struct queue_node *hazarded[THREADS];
+SHARED const struct queue_node *hazarded[THREADS];
 
 /* Protect a pointer that we wish to dereference. */
 static void hazard(queue_handle_t h) {
@@ -2675,7 +2868,7 @@ static double_ptr_t double_ptr_make(uintptr_t q1, uintptr_t q2) {
  * invariants.                                                                 *
  ******************************************************************************/
 
-static struct {
+SHARED struct {
   double_ptr_t ends;
   size_t count;
 } q[THREADS];
@@ -2836,7 +3029,7 @@ static const struct state *queue_dequeue(size_t *NONNULL queue_id) {
 
   const struct state *s = NULL;
 
-  for (size_t attempts = 0; attempts < sizeof(q) / sizeof(q[0]); attempts++) {
+  for (size_t attempts = 0; attempts < thread_count; attempts++) {
 
     double_ptr_t ends = atomic_read(&q[*queue_id].ends);
 
@@ -2931,7 +3124,7 @@ static const struct state *queue_dequeue(size_t *NONNULL queue_id) {
 
       if (s == NULL) {
         /* Move to the next queue to try. */
-        *queue_id = (*queue_id + 1) % (sizeof(q) / sizeof(q[0]));
+        *queue_id = (*queue_id + 1) % thread_count;
         continue;
       }
 
@@ -2948,7 +3141,7 @@ static const struct state *queue_dequeue(size_t *NONNULL queue_id) {
            "head of queue 0 while tail is non-0");
 
     /* Move to the next queue to try. */
-    *queue_id = (*queue_id + 1) % (sizeof(q) / sizeof(q[0]));
+    *queue_id = (*queue_id + 1) % thread_count;
   }
 
   return s;
@@ -3105,27 +3298,27 @@ static void refcounted_ptr_shift(refcounted_ptr_t *NONNULL current,
  ******************************************************************************/
 
 /* sleep mechanism for below. */
-static pthread_mutex_t rendezvous_lock;
+SHARED pthread_mutex_t rendezvous_lock;
 
-static pthread_cond_t rendezvous_cond; /* sleep mechanism for below. */
+SHARED pthread_cond_t rendezvous_cond; /* sleep mechanism for below. */
 
 /* how many threads are opted in to rendezvous? */
-static size_t running_count = 1;
+SHARED size_t running_count SHARED_INIT(1);
 
 /* how many threads are opted in and not sleeping? */
-static size_t rendezvous_pending = 1;
+SHARED size_t rendezvous_pending SHARED_INIT(1);
 
 static void rendezvous_init(void) {
   int r = pthread_mutex_init(&rendezvous_lock, NULL);
   if (__builtin_expect(r != 0, 0)) {
     fprintf(stderr, "pthread_mutex_init failed: %s\n", strerror(r));
-    exit(EXIT_FAILURE);
+    terminate(EXIT_FAILURE);
   }
 
   r = pthread_cond_init(&rendezvous_cond, NULL);
   if (__builtin_expect(r != 0, 0)) {
     fprintf(stderr, "pthread_cond_init failed: %s\n", strerror(r));
-    exit(EXIT_FAILURE);
+    terminate(EXIT_FAILURE);
   }
 }
 
@@ -3295,15 +3488,15 @@ static __attribute__((const)) bool slot_neq(slot_t a, slot_t b) {
  * elements.                                                                   *
  ******************************************************************************/
 
-enum {
-  INITIAL_SET_SIZE_EXPONENT =
-      CLZLL(SET_CAPACITY / sizeof(struct state *) / sizeof(struct state)) !=
-              sizeof(unsigned long long) * CHAR_BIT
-          ? sizeof(unsigned long long) * CHAR_BIT - 1 -
-                CLZLL(SET_CAPACITY / sizeof(struct state *) /
-                      sizeof(struct state))
-          : 0
-};
+/* log2 of the number of slots the seen set starts with, as determined by
+ * set_capacity
+ */
+static size_t initial_set_size_exponent(void) {
+  const unsigned long long slots =
+      set_capacity / sizeof(struct state *) / sizeof(struct state);
+  return slots != 0 ? sizeof(unsigned long long) * CHAR_BIT - 1 - CLZLL(slots)
+                    : 0;
+}
 
 struct set {
   slot_t *bucket;
@@ -3325,14 +3518,14 @@ static size_t set_index(const struct set *NONNULL set, size_t index) {
  * checking the model. Note that we have a global reference-counted pointer and
  * a local bare pointer. See below for an explanation.
  */
-static refcounted_ptr_t global_seen;
-static _Thread_local struct set *local_seen;
+SHARED refcounted_ptr_t global_seen;
+SHARED _Thread_local struct set *local_seen;
 
 /* Number of elements in the global set (i.e. occupancy). */
-static size_t seen_count;
+SHARED size_t seen_count;
 
 /* The "next" 'global_seen' value. See below for an explanation. */
-static refcounted_ptr_t next_global_seen;
+SHARED refcounted_ptr_t next_global_seen;
 
 /* Now the explanation I teased... When the set capacity exceeds a threshold
  * (see 'set_expand' related logic below) it is expanded and the reference
@@ -3347,10 +3540,10 @@ static refcounted_ptr_t next_global_seen;
 /* The next chunk to migrate from the old set to the new set. What exactly a
  * "chunk" is is covered in 'set_migrate'.
  */
-static size_t next_migration;
+SHARED size_t next_migration;
 
 /* A mechanism for synchronisation in 'set_expand'. */
-static pthread_mutex_t set_expand_mutex;
+SHARED pthread_mutex_t set_expand_mutex;
 
 static void set_expand_lock(void) {
   if (THREADS > 1) {
@@ -3372,7 +3565,7 @@ static void set_init(void) {
     int r = pthread_mutex_init(&set_expand_mutex, NULL);
     if (__builtin_expect(r < 0, 0)) {
       fprintf(stderr, "pthread_mutex_init failed: %s\n", strerror(r));
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
     }
   }
 
@@ -3380,7 +3573,7 @@ static void set_init(void) {
    * size.
    */
   struct set *set = xmalloc(sizeof(*set));
-  set->size_exponent = INITIAL_SET_SIZE_EXPONENT;
+  set->size_exponent = initial_set_size_exponent();
   set->bucket = xcalloc(set_size(set), sizeof(set->bucket[0]));
 
   /* Stash this somewhere for threads to later retrieve it from. Note that we
@@ -3539,7 +3732,7 @@ restart:
 
   if (__atomic_load_n(&seen_count, __ATOMIC_ACQUIRE) * 100 /
           set_size(local_seen) >=
-      SET_EXPAND_THRESHOLD)
+      set_expand_threshold)
     set_expand();
 
   const size_t hash = state_hash(s);
@@ -3663,12 +3856,692 @@ set_find(const struct state *NONNULL s) {
 
 /******************************************************************************/
 
-static time_t START_TIME;
+/*******************************************************************************
+ * Layered frontier                                                            *
+ *                                                                             *
+ * With --search bfs-layered, pending states are kept in arrays, one per       *
+ * breadth-first layer, instead of the queues above. All threads expand states *
+ * from the current layer, appending successors to their own array for the     *
+ * next layer. When the current layer is exhausted, the threads wait for each  *
+ * other at a rendezvous and the leader concatenates these arrays to form the  *
+ * new current layer. Every state is thus first reached at its minimal depth,  *
+ * so counterexample traces are as short as possible regardless of how many    *
+ * threads are in use.                                                         *
+ ******************************************************************************/
+
+/* the layer currently being expanded */
+SHARED const struct state **layer;
+SHARED size_t layer_count;
+
+/* index of the next state in the current layer to be expanded */
+SHARED size_t layer_cursor;
+
+/* number of layers that have been started */
+SHARED size_t layer_generation;
+
+/* successors found by each thread, that will form the next layer */
+SHARED struct {
+  const struct state **states;
+  size_t count;
+  size_t capacity;
+} layer_next[THREADS];
+
+/* number of threads waiting at the end of the current layer */
+SHARED size_t layer_waiting;
+
+static size_t layer_enqueue(const struct state *NONNULL s) {
+  assert(thread_id < sizeof(layer_next) / sizeof(layer_next[0]) &&
+         "out of bounds layer access");
+
+  if (layer_next[thread_id].count == layer_next[thread_id].capacity) {
+    size_t capacity = layer_next[thread_id].capacity == 0
+                          ? 1024
+                          : layer_next[thread_id].capacity * 2;
+    layer_next[thread_id].states =
+        xrealloc(layer_next[thread_id].states,
+                 capacity * sizeof(layer_next[thread_id].states[0]));
+    layer_next[thread_id].capacity = capacity;
+  }
+
+  layer_next[thread_id].states[layer_next[thread_id].count] = s;
+  size_t count = ++layer_next[thread_id].count;
+
+  TRACE(TC_QUEUE, "enqueued state %p into next layer, thread %zu has %zu", s,
+        thread_id, count);
+
+  return count;
+}
+
+/* Action for the leader of a rendezvous at the end of a layer. */
+static void layer_advance(void) {
+
+  /* Some participants may have arrived here having finished migrating the seen
+   * set, so complete this.
+   */
+  set_update();
+
+  /* If any participants were migrating rather than waiting, other threads are
+   * still working on the current layer.
+   */
+  if (__atomic_load_n(&layer_waiting, __ATOMIC_ACQUIRE) != running_count)
+    return;
+
+  size_t count = 0;
+  for (size_t i = 0; i < sizeof(layer_next) / sizeof(layer_next[0]); i++)
+    count += layer_next[i].count;
+
+  free(layer);
+  layer = count == 0 ? NULL : xmalloc(count * sizeof(layer[0]));
+
+  size_t offset = 0;
+  for (size_t i = 0; i < sizeof(layer_next) / sizeof(layer_next[0]); i++) {
+    if (layer_next[i].count > 0) {
+      memcpy(&layer[offset], layer_next[i].states,
+             layer_next[i].count * sizeof(layer[0]));
+      offset += layer_next[i].count;
+      layer_next[i].count = 0;
+    }
+  }
+
+  TRACE(TC_QUEUE, "starting layer %zu of %zu states", layer_generation + 1,
+        count);
+
+  layer_count = count;
+  __atomic_store_n(&layer_cursor, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&layer_generation, layer_generation + 1, __ATOMIC_RELEASE);
+}
+
+static const struct state *layer_dequeue(void) {
+
+  for (;;) {
+
+    size_t i = __atomic_fetch_add(&layer_cursor, 1, __ATOMIC_ACQ_REL);
+    if (i < layer_count)
+      return layer[i];
+
+    /* This layer is exhausted. Wait for the other threads to finish it. */
+    const size_t generation =
+        __atomic_load_n(&layer_generation, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&layer_generation, __ATOMIC_ACQUIRE) == generation) {
+
+      if (THREADS > 1 &&
+          __atomic_load_n(&error_count, __ATOMIC_ACQUIRE) >= max_errors) {
+        /* Another thread found an error. */
+        return NULL;
+      }
+
+      /* If another thread is expanding the seen set, it needs our help to
+       * migrate it before the layer can finish.
+       */
+      if (THREADS > 1 && refcounted_ptr_peek(&next_global_seen) != NULL) {
+        set_migrate();
+        continue;
+      }
+
+      /* Release our reference to the seen set while we wait in case the
+       * rendezvous completes a migration, as in exit_with().
+       */
+      __atomic_add_fetch(&layer_waiting, 1, __ATOMIC_ACQ_REL);
+      refcounted_ptr_put(&global_seen, local_seen);
+      rendezvous(layer_advance);
+      local_seen = refcounted_ptr_get(&global_seen);
+      __atomic_sub_fetch(&layer_waiting, 1, __ATOMIC_ACQ_REL);
+    }
+
+    /* if the new layer is empty, we have explored the entire state space */
+    if (layer_count == 0)
+      return NULL;
+  }
+}
+
+/******************************************************************************/
+
+/*******************************************************************************
+ * Best-first frontier                                                         *
+ *                                                                             *
+ * With --search best-first, pending states are kept in a binary min-heap      *
+ * shared between all threads, ordered by a heuristic estimate of how close    *
+ * each state is to violating an invariant. States with equal estimates are    *
+ * expanded in the order they were found, so with no invariants this degrades  *
+ * to breadth-first search.                                                    *
+ ******************************************************************************/
+
+/* Heuristic estimate of how far a state is from violating an invariant,
+ * generated from the model's invariants.
+ */
+EXPORT uint64_t state_heuristic(const struct state *NONNULL s);
+
+/* Helpers for the generated heuristic. These saturate to avoid overflow. */
+
+static __attribute__((unused)) uint64_t distance_add(uint64_t a, uint64_t b) {
+  return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+static __attribute__((unused)) uint64_t distance_min(uint64_t a, uint64_t b) {
+  return a < b ? a : b;
+}
+
+static __attribute__((unused)) uint64_t distance_eq(value_t a, value_t b) {
+  return a > b ? (uint64_t)a - (uint64_t)b : (uint64_t)b - (uint64_t)a;
+}
+
+static __attribute__((unused)) uint64_t distance_neq(value_t a, value_t b) {
+  return a != b ? 0 : 1;
+}
+
+static __attribute__((unused)) uint64_t distance_leq(value_t a, value_t b) {
+  return a <= b ? 0 : distance_eq(a, b);
+}
+
+static __attribute__((unused)) uint64_t distance_lt(value_t a, value_t b) {
+  return a < b ? 0 : distance_add(distance_eq(a, b), 1);
+}
+
+struct heap_entry {
+  uint64_t priority;
+  uint64_t sequence;
+  const struct state *state;
+};
+
+SHARED pthread_mutex_t heap_lock SHARED_INIT(PTHREAD_MUTEX_INITIALIZER);
+SHARED struct heap_entry *heap;
+SHARED size_t heap_count;
+SHARED size_t heap_capacity;
+SHARED uint64_t heap_sequence;
+
+static bool heap_entry_lt(const struct heap_entry *NONNULL a,
+                          const struct heap_entry *NONNULL b) {
+  if (a->priority != b->priority)
+    return a->priority < b->priority;
+  return a->sequence < b->sequence;
+}
+
+static size_t heap_enqueue(const struct state *NONNULL s) {
+
+  /* compute the priority before taking the lock */
+  uint64_t priority = state_heuristic(s);
+
+  int r __attribute__((unused)) = pthread_mutex_lock(&heap_lock);
+  assert(r == 0);
+
+  if (heap_count == heap_capacity) {
+    heap_capacity = heap_capacity == 0 ? 1024 : heap_capacity * 2;
+    heap = xrealloc(heap, heap_capacity * sizeof(heap[0]));
+  }
+
+  /* sift up */
+  struct heap_entry e = {
+      .priority = priority, .sequence = heap_sequence++, .state = s};
+  size_t i = heap_count;
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!heap_entry_lt(&e, &heap[parent]))
+      break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = e;
+  size_t count = ++heap_count;
+
+  r = pthread_mutex_unlock(&heap_lock);
+  assert(r == 0);
+
+  TRACE(TC_QUEUE, "enqueued state %p with priority %" PRIu64
+        ", heap size is now %zu", s, priority, count);
+
+  return count;
+}
+
+static const struct state *heap_dequeue(void) {
+
+  int r __attribute__((unused)) = pthread_mutex_lock(&heap_lock);
+  assert(r == 0);
+
+  const struct state *s = NULL;
+  if (heap_count > 0) {
+    s = heap[0].state;
+
+    /* sift down */
+    heap_count--;
+    struct heap_entry e = heap[heap_count];
+    size_t i = 0;
+    for (;;) {
+      size_t child = 2 * i + 1;
+      if (child >= heap_count)
+        break;
+      if (child + 1 < heap_count &&
+          heap_entry_lt(&heap[child + 1], &heap[child]))
+        child++;
+      if (!heap_entry_lt(&heap[child], &e))
+        break;
+      heap[i] = heap[child];
+      i = child;
+    }
+    heap[i] = e;
+  }
+
+  r = pthread_mutex_unlock(&heap_lock);
+  assert(r == 0);
+
+  if (s != NULL)
+    TRACE(TC_QUEUE, "dequeued state %p", s);
+
+  return s;
+}
+
+/******************************************************************************/
+
+/*******************************************************************************
+ * Depth-first frontier                                                        *
+ *                                                                             *
+ * With --search dfs, each thread keeps a stack of pending states and always   *
+ * expands the one it found most recently. The pending states at any point are *
+ * then roughly the unexplored siblings along the current path, so their       *
+ * number grows with the depth of the search rather than the width of the      *
+ * state space. A thread whose stack runs dry steals the oldest entry from     *
+ * another thread's stack. These entries are the closest to the root and so    *
+ * tend to carry the most remaining work, which keeps steals infrequent.       *
+ ******************************************************************************/
+
+SHARED struct {
+  pthread_mutex_t lock;
+  const struct state **states;
+
+  /* index of the oldest live entry; entries below it have been stolen */
+  size_t base;
+
+  size_t count;
+  size_t capacity;
+} dfs[THREADS];
+
+static void dfs_init(void) {
+  for (size_t i = 0; i < sizeof(dfs) / sizeof(dfs[0]); i++) {
+    int r = pthread_mutex_init(&dfs[i].lock, NULL);
+    if (__builtin_expect(r != 0, 0)) {
+      fprintf(stderr, "pthread_mutex_init failed: %s\n", strerror(r));
+      terminate(EXIT_FAILURE);
+    }
+  }
+}
+
+static size_t dfs_push(const struct state *NONNULL s, size_t queue_id) {
+  assert(queue_id < sizeof(dfs) / sizeof(dfs[0]) &&
+         "out of bounds stack access");
+
+  int r __attribute__((unused)) = pthread_mutex_lock(&dfs[queue_id].lock);
+  assert(r == 0);
+
+  if (dfs[queue_id].count == dfs[queue_id].capacity) {
+    if (dfs[queue_id].base > 0) {
+      /* reclaim the space left by stolen entries */
+      memmove(dfs[queue_id].states, &dfs[queue_id].states[dfs[queue_id].base],
+              (dfs[queue_id].count - dfs[queue_id].base) *
+                  sizeof(dfs[queue_id].states[0]));
+      dfs[queue_id].count -= dfs[queue_id].base;
+      dfs[queue_id].base = 0;
+    } else {
+      size_t capacity =
+          dfs[queue_id].capacity == 0 ? 1024 : dfs[queue_id].capacity * 2;
+      dfs[queue_id].states = xrealloc(
+          dfs[queue_id].states, capacity * sizeof(dfs[queue_id].states[0]));
+      dfs[queue_id].capacity = capacity;
+    }
+  }
+
+  dfs[queue_id].states[dfs[queue_id].count] = s;
+  dfs[queue_id].count++;
+  size_t depth = dfs[queue_id].count - dfs[queue_id].base;
+
+  r = pthread_mutex_unlock(&dfs[queue_id].lock);
+  assert(r == 0);
+
+  TRACE(TC_QUEUE, "pushed state %p to stack %zu, stack size is now %zu", s,
+        queue_id, depth);
+
+  return depth;
+}
+
+static const struct state *dfs_pop(size_t *NONNULL queue_id) {
+  assert(queue_id != NULL && *queue_id < sizeof(dfs) / sizeof(dfs[0]) &&
+         "out of bounds stack access");
+
+  for (size_t attempts = 0; attempts < thread_count; attempts++) {
+
+    const struct state *s = NULL;
+
+    int r __attribute__((unused)) = pthread_mutex_lock(&dfs[*queue_id].lock);
+    assert(r == 0);
+
+    if (dfs[*queue_id].count > dfs[*queue_id].base) {
+      if (*queue_id == thread_id) {
+        /* our own stack; take the newest entry */
+        dfs[*queue_id].count--;
+        s = dfs[*queue_id].states[dfs[*queue_id].count];
+      } else {
+        /* someone else's stack; steal the oldest entry */
+        s = dfs[*queue_id].states[dfs[*queue_id].base];
+        dfs[*queue_id].base++;
+      }
+      if (dfs[*queue_id].count == dfs[*queue_id].base) {
+        dfs[*queue_id].base = 0;
+        dfs[*queue_id].count = 0;
+      }
+    }
+
+    r = pthread_mutex_unlock(&dfs[*queue_id].lock);
+    assert(r == 0);
+
+    if (s != NULL) {
+      TRACE(TC_QUEUE, "popped state %p from stack %zu", s, *queue_id);
+      return s;
+    }
+
+    /* This stack is empty. Try the next one. */
+    *queue_id = (*queue_id + 1) % thread_count;
+  }
+
+  return NULL;
+}
+
+/******************************************************************************/
+
+SHARED time_t START_TIME;
 
 static unsigned long long gettime(void) {
   return (unsigned long long)(time(NULL) - START_TIME);
 }
 
+/*******************************************************************************
+ * Iterative deepening                                                         *
+ *                                                                             *
+ * With --deepen, bounded exploration proceeds in rounds. Each round expands   *
+ * states up to a depth limit and sets aside the states it finds at the limit. *
+ * When every thread has run out of work, the limit is raised by DEEPEN_STEP   *
+ * and the set aside states seed the next round. The seen set carries over     *
+ * between rounds, so no state is explored twice and reaching the final bound  *
+ * costs the same as a single bounded run. Each depth is reported as it is     *
+ * completed.                                                                  *
+ ******************************************************************************/
+
+static size_t pending_enqueue(const struct state *NONNULL s, size_t queue_id);
+
+/* depth at which the current round stops expanding states */
+SHARED uint64_t deepen_limit;
+
+/* states at the limit found by each thread, that will seed the next round */
+SHARED struct {
+  const struct state **states;
+  size_t count;
+  size_t capacity;
+} deepen_frontier[THREADS];
+
+/* number of rounds that have been completed */
+SHARED size_t deepen_generation;
+
+/* number of threads waiting at the end of the current round */
+SHARED size_t deepen_waiting;
+
+/* whether the last round found no states to seed another */
+SHARED bool deepen_done;
+
+/* next depth to be reported and the states found up to it */
+SHARED size_t deepen_reported;
+SHARED size_t deepen_total;
+
+static void deepen_init(void) {
+  deepen_limit = DEEPEN_STEP > BOUND ? BOUND : DEEPEN_STEP;
+}
+
+#if BOUND > 0
+static size_t deepen_defer(const struct state *NONNULL s) {
+  assert(thread_id < sizeof(deepen_frontier) / sizeof(deepen_frontier[0]) &&
+         "out of bounds frontier access");
+
+  if (deepen_frontier[thread_id].count ==
+      deepen_frontier[thread_id].capacity) {
+    size_t capacity = deepen_frontier[thread_id].capacity == 0
+                          ? 1024
+                          : deepen_frontier[thread_id].capacity * 2;
+    deepen_frontier[thread_id].states =
+        xrealloc(deepen_frontier[thread_id].states,
+                 capacity * sizeof(deepen_frontier[thread_id].states[0]));
+    deepen_frontier[thread_id].capacity = capacity;
+  }
+
+  deepen_frontier[thread_id].states[deepen_frontier[thread_id].count] = s;
+  size_t count = ++deepen_frontier[thread_id].count;
+
+  TRACE(TC_QUEUE, "deferred state %p to the next round, frontier size is now "
+        "%zu", s, count);
+
+  return count;
+}
+#endif
+
+/* print a summary of each depth that has been completed */
+static void deepen_report(void) {
+
+  flockfile(stdout);
+
+  for (; deepen_reported <= deepen_limit; deepen_reported++) {
+
+    /* it is assumed all other threads are waiting and we do not need atomic
+     * accesses
+     */
+    size_t count = allocated[deepen_reported];
+    if (count == 0) {
+      /* no states at this depth, so none deeper either */
+      break;
+    }
+    deepen_total += count;
+
+    if (machine_readable_output) {
+      put("<depth_complete depth=\"");
+      put_uint(deepen_reported);
+      put("\" states=\"");
+      put_uint(count);
+      put("\" total_states=\"");
+      put_uint(deepen_total);
+      put("\" duration_seconds=\"");
+      put_uint(gettime());
+      put("\"/>\n");
+    } else {
+      put("\t depth ");
+      put_uint(deepen_reported);
+      put(" complete: ");
+      put_uint(count);
+      put(" states at this depth, ");
+      put_uint(deepen_total);
+      put(" in total, in ");
+      put_uint(gettime());
+      put("s.\n");
+    }
+  }
+
+  funlockfile(stdout);
+}
+
+/* Action for the leader of a rendezvous at the end of a round. */
+static void deepen_advance(void) {
+
+  /* Some participants may have arrived here having finished migrating the seen
+   * set, so complete this.
+   */
+  set_update();
+
+  /* If any participants were migrating rather than waiting, other threads are
+   * still working on the current round.
+   */
+  if (__atomic_load_n(&deepen_waiting, __ATOMIC_ACQUIRE) != running_count)
+    return;
+
+  deepen_report();
+
+  size_t count = 0;
+  for (size_t i = 0; i < sizeof(deepen_frontier) / sizeof(deepen_frontier[0]);
+       i++)
+    count += deepen_frontier[i].count;
+
+  if (count == 0) {
+    deepen_done = true;
+  } else {
+    deepen_limit = BOUND - deepen_limit < DEEPEN_STEP
+                       ? BOUND
+                       : deepen_limit + DEEPEN_STEP;
+
+    TRACE(TC_QUEUE, "starting round to depth %" PRIu64 " from %zu states",
+          deepen_limit, count);
+
+    for (size_t i = 0;
+         i < sizeof(deepen_frontier) / sizeof(deepen_frontier[0]); i++) {
+      for (size_t j = 0; j < deepen_frontier[i].count; j++)
+        (void)pending_enqueue(deepen_frontier[i].states[j], i);
+      deepen_frontier[i].count = 0;
+    }
+  }
+
+  __atomic_store_n(&deepen_generation, deepen_generation + 1,
+                   __ATOMIC_RELEASE);
+}
+
+/* Wait for the current round to end. Returns true if another round has begun,
+ * in which case there may be new states to expand.
+ */
+static bool deepen_wait(void) {
+
+  const size_t generation =
+      __atomic_load_n(&deepen_generation, __ATOMIC_ACQUIRE);
+  while (__atomic_load_n(&deepen_generation, __ATOMIC_ACQUIRE) == generation) {
+
+    if (THREADS > 1 &&
+        __atomic_load_n(&error_count, __ATOMIC_ACQUIRE) >= max_errors) {
+      /* Another thread found an error. */
+      return false;
+    }
+
+    /* If another thread is expanding the seen set, it needs our help to
+     * migrate it before the round can finish.
+     */
+    if (THREADS > 1 && refcounted_ptr_peek(&next_global_seen) != NULL) {
+      set_migrate();
+      continue;
+    }
+
+    /* Release our reference to the seen set while we wait, as in
+     * layer_dequeue().
+     */
+    __atomic_add_fetch(&deepen_waiting, 1, __ATOMIC_ACQ_REL);
+    refcounted_ptr_put(&global_seen, local_seen);
+    rendezvous(deepen_advance);
+    local_seen = refcounted_ptr_get(&global_seen);
+    __atomic_sub_fetch(&deepen_waiting, 1, __ATOMIC_ACQ_REL);
+  }
+
+  return !deepen_done;
+}
+
+/******************************************************************************/
+
+/*******************************************************************************
+ * Pending states                                                              *
+ *                                                                             *
+ * The following dispatches to the container of states waiting to be expanded  *
+ * for the selected search order.                                              *
+ ******************************************************************************/
+
+static size_t pending_enqueue(const struct state *NONNULL s, size_t queue_id) {
+
+#if BOUND > 0
+  /* hold back states at the limit of the current round */
+  if (DEEPEN_STEP > 0 && state_bound_get(s) >= deepen_limit)
+    return deepen_defer(s);
+#endif
+
+  switch (SEARCH) {
+
+  case SEARCH_BFS_LAYERED:
+    return layer_enqueue(s);
+
+  case SEARCH_BEST_FIRST:
+    return heap_enqueue(s);
+
+  case SEARCH_DFS:
+    return dfs_push(s, queue_id);
+
+  default:
+    return queue_enqueue(s, queue_id);
+  }
+}
+
+static const struct state *pending_dequeue(size_t *NONNULL queue_id) {
+
+  for (;;) {
+
+    const struct state *s;
+    switch (SEARCH) {
+
+    case SEARCH_BFS_LAYERED:
+      s = layer_dequeue();
+      break;
+
+    case SEARCH_BEST_FIRST:
+      s = heap_dequeue();
+      break;
+
+    case SEARCH_DFS:
+      s = dfs_pop(queue_id);
+      break;
+
+    default:
+      s = queue_dequeue(queue_id);
+      break;
+    }
+
+    /* with iterative deepening, running out of states may only mean the end of
+     * the current round
+     */
+    if (s != NULL || DEEPEN_STEP == 0 || !deepen_wait())
+      return s;
+  }
+}
+
+/******************************************************************************/
+
+/*******************************************************************************
+ * Random number generation                                                    *
+ *                                                                             *
+ * Simulation chooses among enabled transitions using a SplitMix64 generator   *
+ * per thread. Each thread derives its own starting point from a common seed,  *
+ * so a given seed reproduces the same walks regardless of thread scheduling.  *
+ ******************************************************************************/
+
+/* the seed in use, either SEED or one chosen at startup */
+SHARED uint64_t random_seed;
+
+SHARED _Thread_local uint64_t rng_state;
+
+static uint64_t rng_mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+static void rng_init(void) {
+  rng_state = rng_mix(random_seed +
+                      ((uint64_t)thread_id + 1) * UINT64_C(0x9e3779b97f4a7c15));
+}
+
+static uint64_t rng_next(void) {
+  rng_state += UINT64_C(0x9e3779b97f4a7c15);
+  return rng_mix(rng_state);
+}
+
+/* return a pseudo-random number in the range [0, bound) */
+static uint64_t rng_below(uint64_t bound) {
+  assert(bound > 0 && "empty range for random number");
+  return rng_next() % bound;
+}
+
 #if LIVENESS_COUNT > 0
 /* Set one of the liveness bits (i.e. mark the matching property as 'hit') in a
  * state and all its predecessors.
@@ -3779,11 +4652,15 @@ static unsigned long learn_liveness(struct state *NONNULL s,
 #endif
 
 /* Prototypes for generated functions. */
-static void init(void);
-static _Noreturn void explore(void);
+EXPORT void init(void);
+EXPORT _Noreturn void explore(void);
+EXPORT _Noreturn void simulate(void);
+EXPORT size_t swarm_start(void);
+EXPORT void swarm_expand(const struct state *NONNULL s, size_t rule,
+                         bool *NONNULL possible_deadlock);
 #if LIVENESS_COUNT > 0
-static void check_liveness_final(void);
-static unsigned long check_liveness_summarise(void);
+EXPORT void check_liveness_final(void);
+EXPORT unsigned long check_liveness_summarise(void);
 #endif
 
 static int exit_with(int status) {
@@ -3795,24 +4672,18 @@ static int exit_with(int status) {
 
   /* Make fired rule count visible globally. */
   rules_fired[thread_id] = rules_fired_local;
+  canonicalisation_cache_lookups[thread_id] =
+      canonicalisation_cache_lookups_local;
+  canonicalisation_cache_hits[thread_id] = canonicalisation_cache_hits_local;
+  states_visited[thread_id] = states_visited_local;
+
+  /* Release our canonicalisation cache. */
+  free(canonicalisation_cache);
+  canonicalisation_cache = NULL;
 
   if (thread_id == 0) {
     /* We are the initial thread. Wait on the others before exiting. */
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wtautological-compare"
-#pragma clang diagnostic ignored "-Wtautological-unsigned-zero-compare"
-#elif defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wtype-limits"
-#endif
-    for (size_t i = 0; phase == RUN && i < sizeof(threads) / sizeof(threads[0]);
-         i++) {
-#ifdef __clang__
-#pragma clang diagnostic pop
-#elif defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
+    for (size_t i = 0; phase == RUN && i + 1 < thread_count; i++) {
       void *ret;
       int r = pthread_join(threads[i], &ret);
       if (__builtin_expect(r != 0, 0)) {
@@ -3832,8 +4703,11 @@ static int exit_with(int status) {
      */
     local_seen = refcounted_ptr_get(&global_seen);
 
-    if (error_count == 0) {
-      /* If we didn't see any other errors, print cover information. */
+    if (error_count == 0 && !is_partial_search()) {
+      /* If we didn't see any other errors, print cover information. A partial
+       * search only visits a fraction of the state space, so cover properties
+       * are not meaningful in this case.
+       */
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wtautological-compare"
@@ -3848,7 +4722,7 @@ static int exit_with(int status) {
 #elif defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
-        if (MACHINE_READABLE_OUTPUT) {
+        if (machine_readable_output) {
           put("<cover_result message=\"");
           xml_printf(COVER_MESSAGES[i]);
           put("\" count=\"");
@@ -3856,7 +4730,7 @@ static int exit_with(int status) {
           put("\"/>\n");
         }
         if (covers[i] == 0) {
-          if (!MACHINE_READABLE_OUTPUT) {
+          if (!machine_readable_output) {
             put("\t");
             put(red());
             put(bold());
@@ -3868,7 +4742,7 @@ static int exit_with(int status) {
           }
           error_count++;
           status = EXIT_FAILURE;
-        } else if (!MACHINE_READABLE_OUTPUT) {
+        } else if (!machine_readable_output) {
           put("\t");
           put(green());
           put(bold());
@@ -3885,9 +4759,10 @@ static int exit_with(int status) {
 
 #if LIVENESS_COUNT > 0
     /* If we have liveness properties to assess and have seen no previous
-     * errors, do a final check of them now.
+     * errors, do a final check of them now. As for cover properties, these are
+     * not checked in a partial search.
      */
-    if (error_count == 0) {
+    if (error_count == 0 && !is_partial_search()) {
       check_liveness_final();
 
       unsigned long failed = check_liveness_summarise();
@@ -3898,7 +4773,7 @@ static int exit_with(int status) {
     }
 #endif
 
-    if (!MACHINE_READABLE_OUTPUT) {
+    if (!machine_readable_output) {
       put("\n"
           "===================================================================="
           "======\n"
@@ -3929,6 +4804,27 @@ static int exit_with(int status) {
     for (size_t i = 0; i < sizeof(rules_fired) / sizeof(rules_fired[0]); i++)
       fire_count += rules_fired[i];
 
+    /* Calculate the number of states seen. In a partial search, this is the
+     * total across threads of the length of the random walks or of the states
+     * each swarm worker saw, rather than a count of distinct states.
+     */
+    uintmax_t state_count = seen_count;
+    if (is_partial_search()) {
+      state_count = 0;
+      for (size_t i = 0; i < THREADS; i++)
+        state_count += states_visited[i];
+    }
+
+    /* Calculate the canonicalisation cache statistics. */
+    bool use_cache = SYMMETRY_REDUCTION == SYMMETRY_REDUCTION_HEURISTIC &&
+                     CANONICALISATION_CACHE_SIZE > 0;
+    uintmax_t cache_lookups = 0;
+    uintmax_t cache_hits = 0;
+    for (size_t i = 0; i < THREADS; i++) {
+      cache_lookups += canonicalisation_cache_lookups[i];
+      cache_hits += canonicalisation_cache_hits[i];
+    }
+
     /* Paranoid check that we didn't miscount during set insertions/expansions.
      */
 #ifndef NDEBUG
@@ -3940,38 +4836,216 @@ static int exit_with(int status) {
 #endif
     assert(count == seen_count && "seen set count is inconsistent at exit");
 
-    if (MACHINE_READABLE_OUTPUT) {
+    if (machine_readable_output) {
       put("<summary states=\"");
-      put_uint(seen_count);
+      put_uint(state_count);
       put("\" rules_fired=\"");
       put_uint(fire_count);
       put("\" errors=\"");
       put_uint(error_count);
       put("\" duration_seconds=\"");
       put_uint(gettime());
+      if (use_cache) {
+        put("\" canonicalisation_cache_lookups=\"");
+        put_uint(cache_lookups);
+        put("\" canonicalisation_cache_hits=\"");
+        put_uint(cache_hits);
+      }
       put("\"/>\n");
       put("</rumur_run>\n");
     } else {
       put("State Space Explored:\n"
           "\n"
           "\t");
-      put_uint(seen_count);
+      put_uint(state_count);
       put(" states, ");
       put_uint(fire_count);
       put(" rules fired in ");
       put_uint(gettime());
       put("s.\n");
+      if (use_cache) {
+        put("\t");
+        put_uint(cache_hits);
+        put(" of ");
+        put_uint(cache_lookups);
+        put(" canonicalisations served from cache (");
+        put_uint(cache_lookups == 0 ? 0 : cache_hits * 100 / cache_lookups);
+        put("% hit rate).\n");
+      }
     }
 
     /* print memory usage statistics if `--trace memory_usage` is in effect */
     print_allocation_summary();
 
-    exit(status);
+    if (summary_sink != NULL) {
+      summary_sink->states = state_count;
+      summary_sink->rules_fired = fire_count;
+      summary_sink->errors = error_count;
+      summary_sink->duration_seconds = gettime();
+      summary_sink->completed = 1;
+    }
+
+    terminate(status);
   } else {
     pthread_exit((void *)(intptr_t)status);
   }
 }
 
+/*******************************************************************************
+ * Swarm verification                                                          *
+ *                                                                             *
+ * With --swarm, each thread runs its own independent depth-first search, in   *
+ * the style of SPIN's swarm verification. Instead of the shared seen set,     *
+ * every worker records states in a private bitstate table of fixed size. A    *
+ * state is considered new if any of the bits it hashes to are unset, so hash  *
+ * collisions may cause a worker to skip states it has not seen. To make       *
+ * workers cover different parts of the state space first, each uses its own   *
+ * hash seed and order in which to evaluate rules. Even numbered workers use a *
+ * fixed order (model order for worker 0) while odd numbered workers shuffle   *
+ * the order afresh at every state.                                            *
+ *                                                                             *
+ * The search keeps only the states along the current path, along with their   *
+ * unexplored siblings, so memory use is bounded by the depth of the search    *
+ * and the size of the bitstate table.                                         *
+ ******************************************************************************/
+
+/* number of bits set per state in the bitstate table */
+enum { SWARM_HASHES = 3 };
+
+SHARED _Thread_local uint8_t *swarm_bitstate;
+SHARED _Thread_local uint64_t swarm_bitstate_bits;
+SHARED _Thread_local uint64_t swarm_hash_seed;
+
+/* successors of a state on the current path, that are yet to be explored */
+struct swarm_frame {
+  struct state *states;
+  size_t count;
+  size_t capacity;
+  size_t cursor;
+};
+
+SHARED _Thread_local struct swarm_frame *swarm_stack;
+SHARED _Thread_local size_t swarm_depth;
+SHARED _Thread_local size_t swarm_stack_capacity;
+
+/* Mark a state as seen, returning true if it was not already. */
+static bool bitstate_insert(const struct state *NONNULL s) {
+  uint64_t h1 = rng_mix(MurmurHash64A(s->data, sizeof(s->data)) ^
+                        swarm_hash_seed);
+  uint64_t h2 = rng_mix(h1) | 1;
+
+  bool inserted = false;
+  for (uint64_t i = 0; i < SWARM_HASHES; i++) {
+    uint64_t bit = (h1 + i * h2) % swarm_bitstate_bits;
+    uint8_t mask = (uint8_t)(1u << (bit % CHAR_BIT));
+    if (!(swarm_bitstate[bit / CHAR_BIT] & mask)) {
+      swarm_bitstate[bit / CHAR_BIT] |= mask;
+      inserted = true;
+    }
+  }
+  return inserted;
+}
+
+/* Start a new frame for the successors of the state about to be expanded. */
+static void swarm_open(void) {
+  if (swarm_depth == swarm_stack_capacity) {
+    swarm_stack_capacity =
+        swarm_stack_capacity == 0 ? 64 : swarm_stack_capacity * 2;
+    swarm_stack = xrealloc(swarm_stack,
+                           swarm_stack_capacity * sizeof(swarm_stack[0]));
+  }
+  swarm_stack[swarm_depth] = (struct swarm_frame){0};
+  swarm_depth++;
+}
+
+/* Add a newly generated state to the current frame. This takes a copy of the
+ * state and releases the original, which must be the most recently allocated.
+ */
+static void swarm_push(struct state *NONNULL s) {
+  assert(swarm_depth > 0 && "pushing a state with no open frame");
+  struct swarm_frame *f = &swarm_stack[swarm_depth - 1];
+
+  if (f->count == f->capacity) {
+    f->capacity = f->capacity == 0 ? 8 : f->capacity * 2;
+    f->states = xrealloc(f->states, f->capacity * sizeof(f->states[0]));
+  }
+  f->states[f->count] = *s;
+  f->count++;
+  states_visited_local++;
+
+  state_free(s);
+}
+
+static _Noreturn void swarm(void) {
+
+  rng_init();
+  swarm_hash_seed = rng_next();
+  swarm_bitstate = xcalloc(SWARM_BITSTATE_SIZE, sizeof(swarm_bitstate[0]));
+  swarm_bitstate_bits = SWARM_BITSTATE_SIZE * CHAR_BIT;
+
+  /* the start states form the bottom of the stack */
+  swarm_open();
+  size_t rule_count = swarm_start();
+
+  /* choose the order in which this worker evaluates rules */
+  size_t *order = xmalloc((rule_count + 1) * sizeof(order[0]));
+  for (size_t i = 0; i < rule_count; i++)
+    order[i] = i;
+  bool shuffle_each = thread_id % 2 == 1;
+  bool shuffle = thread_id != 0;
+
+  while (swarm_depth > 0) {
+
+    if (THREADS > 1 &&
+        __atomic_load_n(&error_count, __ATOMIC_ACQUIRE) >= max_errors) {
+      /* Another thread found an error. */
+      break;
+    }
+
+    struct swarm_frame *f = &swarm_stack[swarm_depth - 1];
+    if (f->cursor == f->count) {
+      /* we have explored everything beneath this state */
+      free(f->states);
+      swarm_depth--;
+      continue;
+    }
+    const struct state *s = &f->states[f->cursor];
+    f->cursor++;
+
+#if BOUND > 0
+    if (state_bound_get(s) >= BOUND)
+      continue;
+#endif
+
+    if (shuffle) {
+      for (size_t i = rule_count; i > 1; i--) {
+        size_t j = (size_t)rng_below(i);
+        size_t tmp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = tmp;
+      }
+      shuffle = shuffle_each;
+    }
+
+    /* Note that this may move the stack, invalidating f but not s. */
+    swarm_open();
+
+    bool possible_deadlock = true;
+    for (size_t i = 0; i < rule_count; i++)
+      swarm_expand(s, order[i], &possible_deadlock);
+
+    /* If we did not toggle 'possible_deadlock' off by this point, we have a
+     * deadlock.
+     */
+    if (DEADLOCK_DETECTION != DEADLOCK_DETECTION_OFF && possible_deadlock)
+      deadlock(s);
+  }
+
+  exit_with(EXIT_SUCCESS);
+}
+
+/******************************************************************************/
+
 static void *thread_main(void *arg) {
 
   /* Initialize (thread-local) thread identifier. */
@@ -3979,6 +5053,12 @@ static void *thread_main(void *arg) {
 
   set_thread_init();
 
+  if (SIMULATE_STEPS > 0)
+    simulate();
+
+  if (SWARM_BITSTATE_SIZE > 0)
+    swarm();
+
   explore();
 }
 
@@ -3993,36 +5073,152 @@ static void start_secondary_threads(void) {
    * rendezvous_lock because we are still single threaded at this point.
    */
   assert(running_count == 1);
-  running_count = THREADS;
+  running_count = thread_count;
   assert(rendezvous_pending == 1);
-  rendezvous_pending = THREADS;
+  rendezvous_pending = thread_count;
 
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wtautological-compare"
-#pragma clang diagnostic ignored "-Wtautological-unsigned-zero-compare"
-#elif defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wtype-limits"
-#endif
-  for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
-#ifdef __clang__
-#pragma clang diagnostic pop
-#elif defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
+  for (size_t i = 0; i + 1 < thread_count; i++) {
     int r = pthread_create(&threads[i], NULL, thread_main,
                            (void *)(uintptr_t)(i + 1));
     if (__builtin_expect(r != 0, 0)) {
       fprintf(stderr, "pthread_create failed: %s\n", strerror(r));
-      exit(EXIT_FAILURE);
+      terminate(EXIT_FAILURE);
+    }
+  }
+}
+
+#if RUNTIME_UNIT
+/* If the given command line argument is the option "--name value" or
+ * "--name=value", consume it and return its value. Otherwise return NULL.
+ */
+static const char *option(int argc, char **NONNULL argv, int *NONNULL index,
+                          const char *NONNULL name) {
+  const char *arg = argv[*index];
+  size_t len = strlen(name);
+  if (strncmp(arg, name, len) != 0)
+    return NULL;
+  if (arg[len] == '=')
+    return &arg[len + 1];
+  if (arg[len] != '\0')
+    return NULL;
+  if (*index + 1 >= argc) {
+    fprintf(stderr, "%s requires an argument\n", name);
+    terminate(EXIT_FAILURE);
+  }
+  ++*index;
+  return argv[*index];
+}
+
+/* parse a number within the given range as the value of the given option */
+static unsigned long long option_number(const char *NONNULL name,
+                                        const char *NONNULL value,
+                                        unsigned long long min,
+                                        unsigned long long max) {
+  char *end;
+  errno = 0;
+  unsigned long long v = strtoull(value, &end, 10);
+  if (errno != 0 || end == value || *end != '\0' || value[0] == '-' ||
+      v < min || v > max) {
+    fprintf(stderr, "invalid %s argument \"%s\"\n", name, value);
+    terminate(EXIT_FAILURE);
+  }
+  return v;
+}
+
+static void usage(const char *NONNULL argv0) {
+  printf("usage: %s [options]\n"
+         "\n"
+         "  --color auto|off|on       whether to use ANSI colour codes in "
+         "output\n"
+         "  --max-errors COUNT        number of errors to report before "
+         "exiting\n"
+         "  --output-format human-readable|machine-readable\n"
+         "                            whether to produce output as XML\n"
+         "  --set-capacity SIZE       initial size in bytes of the seen state "
+         "set\n"
+         "  --set-expand-threshold PERCENT\n"
+         "                            occupancy at which to expand the seen "
+         "state set\n"
+         "  --threads COUNT           number of threads to use, at most %zu\n",
+         argv0, (size_t)THREADS);
+}
+
+/* Apply any settings given on the command line. The available options mirror
+ * those of the same names that were given to Rumur when generating the checker.
+ */
+static void parse_args(int argc, char **NONNULL argv) {
+  const char *value;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+      usage(argv[0]);
+      terminate(EXIT_SUCCESS);
+
+    } else if ((value = option(argc, argv, &i, "--color")) != NULL ||
+               (value = option(argc, argv, &i, "--colour")) != NULL) {
+      if (strcmp(value, "auto") == 0) {
+        color = AUTO;
+      } else if (strcmp(value, "off") == 0) {
+        color = OFF;
+      } else if (strcmp(value, "on") == 0) {
+        color = ON;
+      } else {
+        fprintf(stderr, "invalid --color argument \"%s\"\n", value);
+        terminate(EXIT_FAILURE);
+      }
+
+    } else if ((value = option(argc, argv, &i, "--max-errors")) != NULL) {
+      max_errors = (unsigned long)option_number("--max-errors", value, 1,
+                                                ULONG_MAX);
+
+    } else if ((value = option(argc, argv, &i, "--output-format")) != NULL) {
+      if (strcmp(value, "machine-readable") == 0) {
+        machine_readable_output = true;
+        // disable colour that would interfere with XML
+        color = OFF;
+      } else if (strcmp(value, "human-readable") == 0) {
+        machine_readable_output = false;
+      } else {
+        fprintf(stderr, "invalid --output-format argument \"%s\"\n", value);
+        terminate(EXIT_FAILURE);
+      }
+
+    } else if ((value = option(argc, argv, &i, "--set-capacity")) != NULL) {
+      set_capacity =
+          (size_t)option_number("--set-capacity", value, 1, SIZE_MAX);
+
+    } else if ((value = option(argc, argv, &i, "--set-expand-threshold")) !=
+               NULL) {
+      set_expand_threshold =
+          (unsigned)option_number("--set-expand-threshold", value, 1, 100);
+
+    } else if ((value = option(argc, argv, &i, "--threads")) != NULL) {
+      thread_count = (size_t)option_number("--threads", value, 1, SIZE_MAX);
+      if (thread_count > THREADS) {
+        fprintf(stderr,
+                "this checker was generated for at most %zu threads; "
+                "regenerate it with rumur --threads %zu to use more\n",
+                (size_t)THREADS, thread_count);
+        terminate(EXIT_FAILURE);
+      }
+
+    } else {
+      fprintf(stderr, "unrecognised option \"%s\"\n", argv[i]);
+      terminate(EXIT_FAILURE);
     }
   }
+
+  if (machine_readable_output && color == ON) {
+    fprintf(stderr, "colour is not supported in combination with "
+                    "--output-format machine-readable\n");
+    terminate(EXIT_FAILURE);
+  }
 }
 
-int main(void) {
+static int run(int argc, char **NONNULL argv) {
 
-  if (COLOR == AUTO)
+  parse_args(argc, argv);
+
+  if (color == AUTO)
     istty = isatty(STDOUT_FILENO) != 0;
 
   /* We don't need to read anything from stdin, so discard it. */
@@ -4030,7 +5226,7 @@ int main(void) {
 
   sandbox();
 
-  if (MACHINE_READABLE_OUTPUT) {
+  if (machine_readable_output) {
     put("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
         "<rumur_run>\n"
         "<information state_size_bits=\"");
@@ -4038,7 +5234,7 @@ int main(void) {
     put("\" state_size_bytes=\"");
     put_uint(STATE_SIZE_BYTES);
     put("\" hash_table_slots=\"");
-    put_uint(((size_t)1) << INITIAL_SET_SIZE_EXPONENT);
+    put_uint(((size_t)1) << initial_set_size_exponent());
     put("\"/>\n");
   } else {
     put("Memory usage:\n"
@@ -4049,7 +5245,7 @@ int main(void) {
     put_uint(STATE_SIZE_BYTES);
     put(" bytes).\n"
         "\t* The size of the hash table is ");
-    put_uint(((size_t)1) << INITIAL_SET_SIZE_EXPONENT);
+    put_uint(((size_t)1) << initial_set_size_exponent());
     put(" slots.\n"
         "\n");
   }
@@ -4066,10 +5262,75 @@ int main(void) {
 
   set_thread_init();
 
+  if (SEARCH == SEARCH_DFS) {
+    dfs_init();
+  }
+
+  if (DEEPEN_STEP > 0) {
+    deepen_init();
+  }
+
+  if (SIMULATE_STEPS > 0) {
+    random_seed = SEED != 0 ? SEED : (uint64_t)START_TIME;
+
+    if (!machine_readable_output) {
+      put("Simulating ");
+      put_uint(thread_count);
+      put(" random walk(s) of up to ");
+      put_uint(SIMULATE_STEPS);
+      put(" steps with seed ");
+      put_uint(random_seed);
+      put(".\n\n");
+    }
+
+    /* Walks are independent, so there is no need to warm up before starting
+     * the other threads.
+     */
+    start_secondary_threads();
+    phase = RUN;
+
+    simulate();
+  }
+
+  if (SWARM_BITSTATE_SIZE > 0) {
+    random_seed = SEED != 0 ? SEED : (uint64_t)START_TIME;
+
+    if (!machine_readable_output) {
+      put("Running ");
+      put_uint(thread_count);
+      put(" swarm worker(s), each with a ");
+      put_uint(SWARM_BITSTATE_SIZE);
+      put(" byte bitstate table, with seed ");
+      put_uint(random_seed);
+      put(".\n\n");
+    }
+
+    start_secondary_threads();
+    phase = RUN;
+
+    swarm();
+  }
+
   init();
 
-  if (!MACHINE_READABLE_OUTPUT)
+  if (!machine_readable_output)
     put("Progress Report:\n\n");
 
   explore();
 }
+
+int main(int argc, char **argv) { return run(argc, argv); }
+
+/* Entry point for a host that has loaded the checker as a shared object. A run
+ * ends by exiting the process, so the host is expected to call this in a
+ * process of its own. The arguments are as for main(). The summary, if given,
+ * is filled in before exiting.
+ */
+__attribute__((visibility("default"))) int
+rumur_checker_run(struct rumur_summary *summary, int argc, char **argv);
+__attribute__((visibility("default"))) int
+rumur_checker_run(struct rumur_summary *summary, int argc, char **argv) {
+  summary_sink = summary;
+  return run(argc, argv);
+}
+#endif
@@ -0,0 +1,324 @@
+#include "always-defined.h"
+#include "../../common/isa.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <gmpxx.h>
+#include <memory>
+#include <rumur/rumur.h>
+#include <unordered_set>
+#include <vector>
+
+using namespace rumur;
+
+// unique IDs of reads that do not need an undefined check
+static std::unordered_set<size_t> defined_reads;
+
+namespace {
+
+// what an lvalue ultimately refers to
+enum class Root {
+  STATE,   // (part of) a state variable
+  OTHER,   // a local, parameter or quantified variable
+  UNKNOWN, // something we could not determine
+};
+
+} // namespace
+
+static Root get_root(const Expr &e, size_t &id) {
+
+  if (auto el = dynamic_cast<const Element *>(&e))
+    return get_root(*el->array, id);
+
+  if (auto f = dynamic_cast<const Field *>(&e))
+    return get_root(*f->record, id);
+
+  if (auto x = dynamic_cast<const ExprID *>(&e)) {
+
+    if (auto v = dynamic_cast<const VarDecl *>(x->value.get())) {
+      if (!v->is_in_state())
+        return Root::OTHER;
+      id = v->unique_id;
+      return Root::STATE;
+    }
+
+    if (auto a = dynamic_cast<const AliasDecl *>(x->value.get())) {
+      if (a->value->is_lvalue())
+        return get_root(*a->value, id);
+    }
+  }
+
+  return Root::UNKNOWN;
+}
+
+// if this is a direct reference to an entire state variable, return it
+static const VarDecl *get_state_var(const Expr &e) {
+  auto x = dynamic_cast<const ExprID *>(&e);
+  if (x == nullptr)
+    return nullptr;
+  auto v = dynamic_cast<const VarDecl *>(x->value.get());
+  if (v == nullptr || !v->is_in_state())
+    return nullptr;
+  return v;
+}
+
+// does this loop iterate over every value of the given (index) type?
+static bool covers(const Quantifier &q, const TypeExpr &type) {
+
+  if (q.step != nullptr) {
+    if (!q.step->constant())
+      return false;
+    const mpz_class step = q.step->constant_fold();
+    if (step != 1 && step != -1)
+      return false;
+  }
+
+  const Ptr<TypeExpr> t = type.resolve();
+  const Ptr<TypeExpr> qt = q.decl->type->resolve();
+
+  if (auto r = dynamic_cast<const Range *>(qt.get())) {
+    if (r->min == nullptr || r->max == nullptr)
+      return false;
+  }
+  if (!qt->constant() || !t->constant())
+    return false;
+
+  return qt->lower_bound() == t->lower_bound() &&
+         qt->upper_bound() == t->upper_bound();
+}
+
+namespace {
+// a traversal that detects return statements
+class ReturnFinder : public ConstTraversal {
+
+public:
+  bool found = false;
+
+  // returns within functions do not leave the start state
+  void visit_function(const Function &) final {}
+  void visit_functioncall(const FunctionCall &) final {}
+  void visit_procedurecall(const ProcedureCall &) final {}
+
+  void visit_return(const Return &) final { found = true; }
+};
+} // namespace
+
+// may this statement return from the containing start state?
+static bool may_return(const Stmt &s) {
+  ReturnFinder f;
+  f.dispatch(s);
+  return f.found;
+}
+
+/* Find the state variables a start state fully defines. We only look for the
+ * common idioms of assigning a simple variable, clearing a variable, or
+ * assigning every element of an array in a loop. A return accepts the state as
+ * it is at that point, so definitions after a statement that may return do not
+ * count.
+ */
+static std::unordered_set<size_t> defined_by(const StartState &s) {
+
+  std::unordered_set<size_t> defined;
+
+  for (const Ptr<Stmt> &st : s.body) {
+
+    if (may_return(*st))
+      break;
+
+    if (auto a = dynamic_cast<const Assignment *>(st.get())) {
+      const VarDecl *v = get_state_var(*a->lhs);
+      if (v != nullptr && v->type->is_simple())
+        defined.insert(v->unique_id);
+      continue;
+    }
+
+    if (auto c = dynamic_cast<const Clear *>(st.get())) {
+      if (const VarDecl *v = get_state_var(*c->rhs))
+        defined.insert(v->unique_id);
+      continue;
+    }
+
+    if (auto f = dynamic_cast<const For *>(st.get())) {
+      for (const Ptr<Stmt> &b : f->body) {
+
+        const Expr *target = nullptr;
+        if (auto a = dynamic_cast<const Assignment *>(b.get())) {
+          target = a->lhs.get();
+        } else if (auto c = dynamic_cast<const Clear *>(b.get())) {
+          target = c->rhs.get();
+        }
+
+        // are we writing to a[q] for some state array a?
+        auto e = dynamic_cast<const Element *>(target);
+        if (e == nullptr)
+          continue;
+        const VarDecl *v = get_state_var(*e->array);
+        if (v == nullptr)
+          continue;
+        auto i = dynamic_cast<const ExprID *>(e->index.get());
+        if (i == nullptr || i->value == nullptr ||
+            i->value->unique_id != f->quantifier.decl->unique_id)
+          continue;
+
+        const Ptr<TypeExpr> t = v->type->resolve();
+        auto array = dynamic_cast<const Array *>(t.get());
+        assert(array != nullptr && "indexing a non-array");
+        if (!array->element_type->is_simple() && !isa<Clear>(b))
+          continue;
+
+        if (covers(f->quantifier, *array->index_type))
+          defined.insert(v->unique_id);
+      }
+    }
+  }
+
+  return defined;
+}
+
+namespace {
+
+// remove any variable that may be made undefined after the start states
+class Invalidator : public ConstTraversal {
+
+public:
+  std::unordered_set<size_t> *defined;
+  bool in_function = false;
+
+  explicit Invalidator(std::unordered_set<size_t> &defined_)
+      : defined(&defined_) {}
+
+  void visit_assignment(const Assignment &n) final {
+    // a copy of a complex value may carry undefined components with it
+    if (!n.lhs->type()->is_simple())
+      invalidate(*n.lhs);
+    dispatch(*n.lhs);
+    dispatch(*n.rhs);
+  }
+
+  void visit_function(const Function &n) final {
+    bool old = in_function;
+    in_function = true;
+    ConstTraversal::visit_function(n);
+    in_function = old;
+  }
+
+  void visit_undefine(const Undefine &n) final {
+    invalidate(*n.rhs);
+    dispatch(*n.rhs);
+  }
+
+private:
+  void invalidate(const Expr &lvalue) {
+    size_t id = 0;
+    switch (get_root(lvalue, id)) {
+
+    case Root::STATE:
+      defined->erase(id);
+      break;
+
+    case Root::OTHER:
+      // a rule's own locals are irrelevant, but a function's parameters may be
+      // references to state variables
+      if (in_function)
+        defined->clear();
+      break;
+
+    case Root::UNKNOWN:
+      defined->clear();
+      break;
+    }
+  }
+};
+
+// collect reads of always-defined variables within rules and properties
+class Collector : public ConstTraversal {
+
+public:
+  const std::unordered_set<size_t> *defined;
+
+  explicit Collector(const std::unordered_set<size_t> &defined_)
+      : defined(&defined_) {}
+
+  void visit_element(const Element &n) final {
+    check(n);
+    ConstTraversal::visit_element(n);
+  }
+
+  void visit_exprid(const ExprID &n) final { check(n); }
+
+  void visit_field(const Field &n) final {
+    check(n);
+    ConstTraversal::visit_field(n);
+  }
+
+  void visit_function(const Function &) final {
+    // skip, as functions may be called from start states
+  }
+
+  void visit_startstate(const StartState &) final {
+    // skip, as state variables may not yet have been assigned
+  }
+
+private:
+  void check(const Expr &n) {
+    if (n.unique_id == SIZE_MAX || !n.is_lvalue())
+      return;
+    const Ptr<TypeExpr> t = n.type();
+    if (t == nullptr || !t->is_simple())
+      return;
+    size_t id = 0;
+    if (get_root(n, id) != Root::STATE)
+      return;
+    if (defined->find(id) != defined->end())
+      defined_reads.insert(n.unique_id);
+  }
+};
+
+} // namespace
+
+void find_always_defined(const Model &m) {
+
+  defined_reads.clear();
+
+  // find the state variables every start state defines
+  std::unordered_set<size_t> defined;
+  bool first = true;
+  for (const Ptr<Node> &c : m.children) {
+    if (auto rule = dynamic_cast<const Rule *>(c.get())) {
+      for (const Ptr<Rule> &r : rule->flatten()) {
+        auto s = dynamic_cast<const StartState *>(r.get());
+        if (s == nullptr)
+          continue;
+        const std::unordered_set<size_t> d = defined_by(*s);
+        if (first) {
+          defined = d;
+          first = false;
+        } else {
+          for (auto it = defined.begin(); it != defined.end();) {
+            if (d.find(*it) == d.end()) {
+              it = defined.erase(it);
+            } else {
+              ++it;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // discard any that may later become undefined
+  Invalidator invalidator(defined);
+  invalidator.dispatch(m);
+
+  if (defined.empty())
+    return;
+
+  Collector collector(defined);
+  collector.dispatch(m);
+}
+
+bool is_always_defined(const Expr &e) {
+  if (e.unique_id == SIZE_MAX)
+    return false;
+  return defined_reads.find(e.unique_id) != defined_reads.end();
+}
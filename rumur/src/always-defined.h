@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <rumur/rumur.h>
+
+/* Find reads of state variables that can never observe an undefined value.
+ *
+ * A simple-typed state variable (or array of simple-typed elements) that is
+ * unconditionally assigned by every start state and is never subsequently
+ * undefined will always hold a defined value in any reachable state. Reads of
+ * such a variable within rules and properties do not need to check for the
+ * undefined encoding. Reads within start states and functions are never
+ * considered, as these may execute before the variable has been assigned.
+ */
+void find_always_defined(const rumur::Model &m);
+
+// is this read one identified by find_always_defined() as not needing a check?
+bool is_always_defined(const rumur::Expr &e);
@@ -4,7 +4,7 @@
 
 using namespace rumur;
 
-unsigned long assume_statements_count(const Model &model) {
+unsigned long function_assume_statements_count(const Model &model) {
 
   // define a traversal for counting assume statements
   class AssumeCounter : public ConstTraversal {
@@ -19,9 +19,15 @@ unsigned long assume_statements_count(const Model &model) {
     }
   };
 
-  // use the counter to find how many assume statements we have
-  AssumeCounter ac;
-  ac.dispatch(model);
+  // use the counter to find how many assume statements each function has
+  unsigned long count = 0;
+  for (const Ptr<Node> &c : model.children) {
+    if (auto f = dynamic_cast<const Function *>(c.get())) {
+      AssumeCounter ac;
+      ac.dispatch(*f);
+      count += ac.count;
+    }
+  }
 
-  return ac.count;
+  return count;
 }
@@ -3,5 +3,8 @@
 #include <cstddef>
 #include <rumur/rumur.h>
 
-// find the number of assume statements in the model
-unsigned long assume_statements_count(const rumur::Model &model);
+/* Find the number of assume statements within functions and procedures in the
+ * model. Assume statements directly within rules and start states are not
+ * counted as these do not require a checkpoint to recover from.
+ */
+unsigned long function_assume_statements_count(const rumur::Model &model);
@@ -0,0 +1,285 @@
+#include "compiled-checker.h"
+#include "../../common/environ.h"
+#include "ValueType.h"
+#include "generate.h"
+#include "options.h"
+#include "prepare-model.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <rumur/rumur.h>
+#include <spawn.h>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace rumur;
+
+namespace {
+// summary a checker writes on exit, mirroring struct rumur_summary in
+// ../resources/header.c
+struct Summary {
+  uint64_t completed;
+  uint64_t states;
+  uint64_t rules_fired;
+  uint64_t errors;
+  uint64_t duration_seconds;
+};
+
+// A program to start a run of the checker. This is linked against the checker's
+// shared object and writes the summary into the file named by its first
+// argument, which the host has created with the right size.
+const char RUNNER[] = R"(#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct rumur_summary;
+int rumur_checker_run(struct rumur_summary *summary, int argc, char **argv);
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s summary-file [checker arguments...]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int fd = open(argv[1], O_RDWR);
+  if (fd < 0) {
+    perror("open");
+    return EXIT_FAILURE;
+  }
+  void *summary = mmap(NULL, SUMMARY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+  if (summary == MAP_FAILED) {
+    perror("mmap");
+    return EXIT_FAILURE;
+  }
+  (void)close(fd);
+
+  /* pass on the remaining arguments, in place of our own */
+  argv[1] = argv[0];
+  return rumur_checker_run(summary, argc - 1, argv + 1);
+}
+)";
+} // namespace
+
+/// run a command and wait for it, returning its exit status or -1 if it could
+/// not be run
+static int call(const std::vector<std::string> &args, bool quiet = false) {
+
+  std::vector<char *> argv;
+  for (const std::string &arg : args)
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t fa;
+  if (posix_spawn_file_actions_init(&fa) != 0)
+    return -1;
+  if (quiet && posix_spawn_file_actions_addopen(&fa, STDERR_FILENO, "/dev/null",
+                                                O_WRONLY, 0) != 0) {
+    (void)posix_spawn_file_actions_destroy(&fa);
+    return -1;
+  }
+
+  pid_t pid;
+  int r = posix_spawnp(&pid, argv[0], &fa, nullptr, argv.data(), get_environ());
+  (void)posix_spawn_file_actions_destroy(&fa);
+  if (r != 0)
+    return -1;
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR)
+      return -1;
+  }
+
+  if (!WIFEXITED(status))
+    return -1;
+  return WEXITSTATUS(status);
+}
+
+/// can we link against libatomic? Some targets need it for the checker's
+/// double-word compare-and-swap, and linking it where it is not needed is
+/// harmless.
+static bool has_libatomic(const std::string &cc, const std::string &dir) {
+  const std::string src = dir + "/libatomic.c";
+  const std::string out = dir + "/libatomic";
+  FILE *f = fopen(src.c_str(), "w");
+  if (f == nullptr)
+    return false;
+  (void)fputs("int main(void) { return 0; }\n", f);
+  (void)fclose(f);
+
+  bool ok = call({cc, "-o", out, src, "-latomic"}, true) == 0;
+  (void)unlink(out.c_str());
+  (void)unlink(src.c_str());
+  return ok;
+}
+
+std::unique_ptr<CompiledChecker>
+CompiledChecker::build(Ptr<Model> model, const Options &opts,
+                       const std::vector<std::string> &cflags) {
+
+  options = opts;
+
+  // the shared object is always built from a single file
+  options.split = 0;
+
+  // resolve settings as the command line parser would
+  validate_options();
+
+  prepare_model(*model);
+
+  const std::pair<ValueType, ValueType> value_types =
+      get_value_type(options.value_type, *model);
+
+  std::unique_ptr<CompiledChecker> checker(new CompiledChecker);
+
+  // create some scratch space to generate and compile the checker in
+  const char *tmp = getenv("TMPDIR");
+  std::string scratch =
+      std::string(tmp == nullptr ? "/tmp" : tmp) + "/rumur-XXXXXX";
+  if (mkdtemp(&scratch[0]) == nullptr)
+    throw std::runtime_error("failed to create temporary directory: " +
+                             std::string(strerror(errno)));
+  checker->dir = scratch;
+
+  const std::string src = scratch + "/checker.c";
+  if (output_checker(src, *model, value_types) != 0)
+    throw std::runtime_error("failed to write " + src);
+
+  const char *cc = getenv("CC");
+  if (cc == nullptr)
+    cc = "cc";
+
+  // Build a shared object exposing only rumur_checker_run(). Hiding everything
+  // else also keeps the checker's own main() from clashing with the runner's.
+  const std::string so = scratch + "/checker.so";
+  std::vector<std::string> args = {cc, "-std=c11"};
+  args.insert(args.end(), cflags.begin(), cflags.end());
+  args.insert(args.end(), {"-fPIC", "-shared", "-fvisibility=hidden",
+#ifdef __x86_64__
+                           "-mcx16",
+#endif
+                           "-o", so, src, "-lpthread"});
+  if (has_libatomic(cc, scratch))
+    args.push_back("-latomic");
+
+  if (call(args) != 0)
+    throw std::runtime_error("failed to compile " + src);
+
+  // build the program that starts each run, linked against the shared object
+  const std::string runner_src = scratch + "/runner.c";
+  FILE *f = fopen(runner_src.c_str(), "w");
+  if (f == nullptr)
+    throw std::runtime_error("failed to write " + runner_src);
+  (void)fputs(RUNNER, f);
+  if (fclose(f) != 0)
+    throw std::runtime_error("failed to write " + runner_src);
+
+  checker->runner = scratch + "/runner";
+  if (call({cc, "-std=c11", "-DSUMMARY_SIZE=" + std::to_string(sizeof(Summary)),
+            "-o", checker->runner, runner_src, so}) != 0)
+    throw std::runtime_error("failed to compile " + runner_src);
+
+  return checker;
+}
+
+CompiledChecker::Result
+CompiledChecker::run(const std::vector<std::string> &args, int output) const {
+
+  // somewhere the run can write its summary that we can see
+  std::string path = dir + "/summary-XXXXXX";
+  const int fd = mkstemp(&path[0]);
+  if (fd < 0)
+    throw std::runtime_error("failed to create summary file: " +
+                             std::string(strerror(errno)));
+
+  // discard the summary file and report an error
+  auto fail = [&](const std::string &message, int err) {
+    (void)close(fd);
+    (void)unlink(path.c_str());
+    throw std::runtime_error(message + ": " + std::string(strerror(err)));
+  };
+
+  const Summary empty = Summary();
+  if (write(fd, &empty, sizeof(empty)) != static_cast<ssize_t>(sizeof(empty)))
+    fail("failed to write summary file", errno);
+
+  std::vector<std::string> arguments = {runner, path};
+  arguments.insert(arguments.end(), args.begin(), args.end());
+  std::vector<char *> argv;
+  for (std::string &arg : arguments)
+    argv.push_back(&arg[0]);
+  argv.push_back(nullptr);
+
+  // send the checker's output where the caller asked
+  posix_spawn_file_actions_t fa;
+  int r = posix_spawn_file_actions_init(&fa);
+  if (r != 0)
+    fail("posix_spawn_file_actions_init failed", r);
+  if (output >= 0) {
+    r = posix_spawn_file_actions_adddup2(&fa, output, STDOUT_FILENO);
+    if (r == 0)
+      r = posix_spawn_file_actions_adddup2(&fa, output, STDERR_FILENO);
+  } else {
+    r = posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null",
+                                         O_WRONLY, 0);
+    if (r == 0)
+      r = posix_spawn_file_actions_adddup2(&fa, STDOUT_FILENO, STDERR_FILENO);
+  }
+
+  pid_t pid;
+  if (r == 0)
+    r = posix_spawn(&pid, argv[0], &fa, nullptr, argv.data(), get_environ());
+  (void)posix_spawn_file_actions_destroy(&fa);
+  if (r != 0)
+    fail("failed to start checker", r);
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR)
+      fail("waitpid failed", errno);
+  }
+
+  Result result;
+  if (WIFEXITED(status))
+    result.status = WEXITSTATUS(status);
+
+  Summary summary;
+  if (pread(fd, &summary, sizeof(summary), 0) ==
+          static_cast<ssize_t>(sizeof(summary)) &&
+      summary.completed != 0) {
+    result.completed = true;
+    result.states = summary.states;
+    result.rules_fired = summary.rules_fired;
+    result.errors = summary.errors;
+    result.duration_seconds = summary.duration_seconds;
+  }
+
+  (void)close(fd);
+  (void)unlink(path.c_str());
+  return result;
+}
+
+CompiledChecker::~CompiledChecker() {
+  if (!dir.empty()) {
+    (void)unlink((dir + "/runner").c_str());
+    (void)unlink((dir + "/runner.c").c_str());
+    (void)unlink((dir + "/checker.so").c_str());
+    (void)unlink((dir + "/checker.c").c_str());
+    (void)rmdir(dir.c_str());
+  }
+}
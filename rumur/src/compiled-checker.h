@@ -0,0 +1,73 @@
+#pragma once
+
+#include "options.h"
+#include <cstdint>
+#include <memory>
+#include <rumur/rumur.h>
+#include <string>
+#include <vector>
+
+/* A checker that has been generated and compiled into a shared object, ready to
+ * be run repeatedly. This is an alternative to driving the rumur command line
+ * tool for programs that run many checks and want to pay for parsing,
+ * generation and compilation only once.
+ *
+ * A run of a checker ends by exiting, so each run takes place in a separate
+ * process. This is started with posix_spawn() rather than fork(), so the caller
+ * may be multithreaded and may run checkers from several threads at once. The
+ * process runs a small program linked against the shared object, which calls
+ * straight into the checker without any further compilation.
+ */
+class CompiledChecker {
+
+public:
+  // outcome of a single run of the checker
+  struct Result {
+
+    // exit status of the checker, or -1 if it was terminated by a signal
+    int status = -1;
+
+    // did the checker run to completion? If not, the counts below are not
+    // meaningful.
+    bool completed = false;
+
+    uint64_t states = 0;
+    uint64_t rules_fired = 0;
+    uint64_t errors = 0;
+    uint64_t duration_seconds = 0;
+  };
+
+  /* Generate a checker for the given model according to the given options and
+   * compile it, using the C compiler named by $CC or "cc" if this is unset. The
+   * model is expected to be freshly parsed. Throws rumur::Error if the model is
+   * invalid or unsupported and std::runtime_error if generating or compiling
+   * the checker fails. This sets the global options, so must not be
+   * called concurrently with anything else reading them.
+   */
+  static std::unique_ptr<CompiledChecker>
+  build(rumur::Ptr<rumur::Model> model, const Options &opts = Options(),
+        const std::vector<std::string> &cflags = {"-O3"});
+
+  /* Run the checker to completion. The arguments are passed to the checker as
+   * if given on its command line, allowing runtime settings like --threads or
+   * --max-errors to vary between runs. Its output is written to the given file
+   * descriptor, or discarded if this is -1. Throws std::runtime_error if the
+   * checker's process cannot be started. This may be called from several
+   * threads at once.
+   */
+  Result run(const std::vector<std::string> &args = {}, int output = -1) const;
+
+  ~CompiledChecker();
+
+  CompiledChecker(const CompiledChecker &) = delete;
+  CompiledChecker &operator=(const CompiledChecker &) = delete;
+
+private:
+  CompiledChecker() = default;
+
+  // temporary directory holding the generated code and shared object
+  std::string dir;
+
+  // program that starts a run of the checker
+  std::string runner;
+};
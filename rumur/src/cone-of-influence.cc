@@ -0,0 +1,522 @@
+#include "cone-of-influence.h"
+#include "../../common/isa.h"
+#include "always-defined.h"
+#include "log.h"
+#include <cstddef>
+#include <cstdint>
+#include <gmpxx.h>
+#include <rumur/rumur.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace rumur;
+
+// if this lvalue is (part of) a state variable, return the variable
+static const VarDecl *get_root(const Expr &e) {
+
+  if (auto el = dynamic_cast<const Element *>(&e))
+    return get_root(*el->array);
+
+  if (auto f = dynamic_cast<const Field *>(&e))
+    return get_root(*f->record);
+
+  if (auto x = dynamic_cast<const ExprID *>(&e)) {
+    if (auto v = dynamic_cast<const VarDecl *>(x->value.get())) {
+      if (v->is_in_state())
+        return v;
+    }
+  }
+
+  // note that we deliberately do not see through aliases, so a write via an
+  // alias is always treated as a write to a variable we need
+  return nullptr;
+}
+
+namespace {
+
+// does a node contain a function call?
+class CallFinder : public ConstTraversal {
+
+public:
+  bool found = false;
+
+  void visit_functioncall(const FunctionCall &) final { found = true; }
+};
+
+} // namespace
+
+static bool has_call(const Node &n) {
+  CallFinder f;
+  f.dispatch(n);
+  return f.found;
+}
+
+// is this array index always within the bounds of the array?
+static bool in_bounds(const Element &e) {
+
+  const Ptr<TypeExpr> t = e.array->type()->resolve();
+  auto a = dynamic_cast<const Array *>(t.get());
+  if (a == nullptr)
+    return false;
+  const Ptr<TypeExpr> index_type = a->index_type->resolve();
+
+  if (e.index->constant()) {
+    const mpz_class i = e.index->constant_fold();
+    return index_type->lower_bound() <= i && i <= index_type->upper_bound();
+  }
+
+  // otherwise rely on the type of a variable used as an index
+  if (!e.index->is_lvalue())
+    return false;
+  const Ptr<TypeExpr> i = e.index->type()->resolve();
+  return i->is_simple() && i->constant() &&
+         index_type->lower_bound() <= i->lower_bound() &&
+         i->upper_bound() <= index_type->upper_bound();
+}
+
+static bool may_fail(const Expr &e);
+
+// can computing the location of this lvalue raise a runtime error?
+static bool lvalue_may_fail(const Expr &e) {
+
+  if (auto el = dynamic_cast<const Element *>(&e))
+    return lvalue_may_fail(*el->array) || may_fail(*el->index) ||
+           !in_bounds(*el);
+
+  if (auto f = dynamic_cast<const Field *>(&e))
+    return lvalue_may_fail(*f->record);
+
+  return !isa<ExprID>(&e);
+}
+
+/* Can evaluating this expression raise a runtime error? This is conservative,
+ * accepting only the forms that are easy to show safe without knowing the
+ * range of the checker's value type.
+ */
+static bool may_fail(const Expr &e) {
+
+  // constant expressions are evaluated during generation
+  if (e.constant())
+    return false;
+
+  if (e.is_lvalue()) {
+    // a read of a simple value checks whether it is undefined
+    const Ptr<TypeExpr> t = e.type()->resolve();
+    if (t->is_simple() && !is_always_defined(e))
+      return true;
+    return lvalue_may_fail(e);
+  }
+
+  if (auto x = dynamic_cast<const ExprID *>(&e))
+    return !isa<ConstDecl>(x->value) && !isa<VarDecl>(x->value);
+
+  if (auto n = dynamic_cast<const Not *>(&e))
+    return may_fail(*n->rhs);
+
+  if (auto u = dynamic_cast<const IsUndefined *>(&e))
+    return lvalue_may_fail(*u->rhs);
+
+  if (auto b = dynamic_cast<const BinaryExpr *>(&e)) {
+    // arithmetic may overflow or divide by zero
+    if (isa<ArithmeticBinaryExpr>(b))
+      return true;
+    return may_fail(*b->lhs) || may_fail(*b->rhs);
+  }
+
+  if (auto t = dynamic_cast<const Ternary *>(&e))
+    return may_fail(*t->cond) || may_fail(*t->lhs) || may_fail(*t->rhs);
+
+  return true;
+}
+
+// can evaluating the range of this quantifier raise a runtime error?
+static bool may_fail(const Quantifier &q) {
+  if (q.constant())
+    return false;
+  return q.type != nullptr || may_fail(*q.from) || may_fail(*q.to) ||
+         (q.step != nullptr && may_fail(*q.step));
+}
+
+/* Can this write raise a runtime error? Removing such a write would also remove
+ * the error it could report.
+ */
+static bool may_fail(const Expr &lhs, const Expr *rhs) {
+
+  if (lvalue_may_fail(lhs))
+    return true;
+
+  if (rhs == nullptr)
+    return false;
+
+  if (may_fail(*rhs))
+    return true;
+
+  // a simple value is checked against the range of its destination
+  const Ptr<TypeExpr> t = lhs.type()->resolve();
+  if (!t->is_simple())
+    return false;
+  if (rhs->constant()) {
+    const mpz_class v = rhs->constant_fold();
+    return v < t->lower_bound() || v > t->upper_bound();
+  }
+  const Ptr<TypeExpr> r = rhs->type()->resolve();
+  if (!rhs->is_lvalue() && !r->is_boolean())
+    return true;
+  return !r->is_simple() || !r->constant() ||
+         r->lower_bound() < t->lower_bound() ||
+         r->upper_bound() > t->upper_bound();
+}
+
+/* Is this statement composed of nothing but writes to state variables, possibly
+ * nested within conditionals and loops, none of which can raise an error? Such a
+ * statement has no effect beyond the variables it writes and can be removed if
+ * none of these are needed. The unique IDs of the written variables are
+ * appended to targets.
+ */
+static bool only_writes(const Stmt &s, std::vector<size_t> &targets) {
+
+  const Expr *lvalue = nullptr;
+  const Expr *rhs = nullptr;
+  if (auto a = dynamic_cast<const Assignment *>(&s)) {
+    lvalue = a->lhs.get();
+    rhs = a->rhs.get();
+  } else if (auto c = dynamic_cast<const Clear *>(&s)) {
+    lvalue = c->rhs.get();
+  } else if (auto u = dynamic_cast<const Undefine *>(&s)) {
+    lvalue = u->rhs.get();
+  }
+
+  if (lvalue != nullptr) {
+    const VarDecl *root = get_root(*lvalue);
+    if (root == nullptr)
+      return false;
+    // a function call may have side effects we cannot discard
+    if (has_call(*lvalue) || (rhs != nullptr && has_call(*rhs)))
+      return false;
+    if (may_fail(*lvalue, rhs))
+      return false;
+    targets.push_back(root->unique_id);
+    return true;
+  }
+
+  auto all_only_writes = [&](const std::vector<Ptr<Stmt>> &body) {
+    for (const Ptr<Stmt> &st : body) {
+      if (!only_writes(*st, targets))
+        return false;
+    }
+    return true;
+  };
+
+  if (auto i = dynamic_cast<const If *>(&s)) {
+    for (const IfClause &c : i->clauses) {
+      if (c.condition != nullptr &&
+          (has_call(*c.condition) || may_fail(*c.condition)))
+        return false;
+      if (!all_only_writes(c.body))
+        return false;
+    }
+    return true;
+  }
+
+  if (auto f = dynamic_cast<const For *>(&s)) {
+    if (has_call(f->quantifier) || may_fail(f->quantifier))
+      return false;
+    return all_only_writes(f->body);
+  }
+
+  if (auto sw = dynamic_cast<const Switch *>(&s)) {
+    if (has_call(*sw->expr) || may_fail(*sw->expr))
+      return false;
+    for (const SwitchCase &c : sw->cases) {
+      for (const Ptr<Expr> &m : c.matches) {
+        if (has_call(*m) || may_fail(*m))
+          return false;
+      }
+      if (!all_only_writes(c.body))
+        return false;
+    }
+    return true;
+  }
+
+  // anything else (while loops, assertions, procedure calls, ...) may have
+  // effects beyond writing to state variables
+  return false;
+}
+
+namespace {
+
+/* Find which state variables are read where. A read is either a "seed", a use
+ * that can directly affect the model's behaviour, or a dependency of the state
+ * variable being written to.
+ */
+class Collector : public ConstTraversal {
+
+public:
+  // state variables read by a seed use
+  std::unordered_set<size_t> seeds;
+
+  // state variables read when computing a write to each state variable
+  std::unordered_map<size_t, std::unordered_set<size_t>> deps;
+
+  void visit_assignment(const Assignment &n) final {
+    write(*n.lhs, n.rhs.get());
+  }
+
+  void visit_clear(const Clear &n) final { write(*n.rhs, nullptr); }
+
+  void visit_exprid(const ExprID &n) final {
+    auto v = dynamic_cast<const VarDecl *>(n.value.get());
+    if (v == nullptr || !v->is_in_state())
+      return;
+    if (target == SIZE_MAX) {
+      seeds.insert(v->unique_id);
+    } else {
+      deps[target].insert(v->unique_id);
+    }
+  }
+
+  void visit_for(const For &n) final {
+    if (!is_only_writes(n)) {
+      ConstTraversal::visit_for(n);
+      return;
+    }
+    // the loop bounds only influence the variables written within the loop
+    conditions.push_back(&n.quantifier);
+    for (const Ptr<Stmt> &s : n.body)
+      dispatch(*s);
+    conditions.pop_back();
+  }
+
+  void visit_function(const Function &n) final {
+    // a function may be called from anywhere and may write through its
+    // parameters, so treat everything within it as a seed
+    bool old = in_function;
+    in_function = true;
+    ConstTraversal::visit_function(n);
+    in_function = old;
+  }
+
+  void visit_if(const If &n) final {
+    if (!is_only_writes(n)) {
+      ConstTraversal::visit_if(n);
+      return;
+    }
+    // the conditions only influence the variables written within the clauses
+    const size_t depth = conditions.size();
+    for (const IfClause &c : n.clauses) {
+      if (c.condition != nullptr)
+        conditions.push_back(c.condition.get());
+    }
+    for (const IfClause &c : n.clauses) {
+      for (const Ptr<Stmt> &s : c.body)
+        dispatch(*s);
+    }
+    conditions.resize(depth);
+  }
+
+  void visit_switch(const Switch &n) final {
+    if (!is_only_writes(n)) {
+      ConstTraversal::visit_switch(n);
+      return;
+    }
+    // the switch expression and case labels only influence the variables
+    // written within the cases
+    const size_t depth = conditions.size();
+    conditions.push_back(n.expr.get());
+    for (const SwitchCase &c : n.cases) {
+      for (const Ptr<Expr> &m : c.matches)
+        conditions.push_back(m.get());
+    }
+    for (const SwitchCase &c : n.cases) {
+      for (const Ptr<Stmt> &s : c.body)
+        dispatch(*s);
+    }
+    conditions.resize(depth);
+  }
+
+  void visit_undefine(const Undefine &n) final { write(*n.rhs, nullptr); }
+
+private:
+  size_t target = SIZE_MAX;
+  bool in_function = false;
+
+  // conditions controlling whether the current statement executes
+  std::vector<const Node *> conditions;
+
+  bool is_only_writes(const Stmt &s) const {
+    if (in_function)
+      return false;
+    std::vector<size_t> targets;
+    return only_writes(s, targets);
+  }
+
+  void write(const Expr &lhs, const Expr *rhs) {
+
+    const VarDecl *root = in_function ? nullptr : get_root(lhs);
+
+    // a function call may have side effects we cannot discard
+    if (root != nullptr &&
+        (has_call(lhs) || (rhs != nullptr && has_call(*rhs))))
+      root = nullptr;
+
+    // a write that may raise an error cannot be discarded either, so it keeps
+    // the variable it writes and everything it reads
+    if (root != nullptr && may_fail(lhs, rhs)) {
+      seeds.insert(root->unique_id);
+      root = nullptr;
+    }
+
+    if (root != nullptr)
+      target = root->unique_id;
+    dispatch(lhs);
+    if (rhs != nullptr)
+      dispatch(*rhs);
+    for (const Node *c : conditions)
+      dispatch(*c);
+    target = SIZE_MAX;
+  }
+};
+
+// remove writes to the given state variables
+class Slicer : public Traversal {
+
+public:
+  const std::unordered_set<size_t> *sliced;
+
+  explicit Slicer(const std::unordered_set<size_t> &sliced_)
+      : sliced(&sliced_) {}
+
+  void visit_aliasstmt(AliasStmt &n) final {
+    filter(n.body);
+    Traversal::visit_aliasstmt(n);
+  }
+
+  void visit_for(For &n) final {
+    filter(n.body);
+    Traversal::visit_for(n);
+  }
+
+  void visit_ifclause(IfClause &n) final {
+    filter(n.body);
+    Traversal::visit_ifclause(n);
+  }
+
+  void visit_simplerule(SimpleRule &n) final {
+    filter(n.body);
+    Traversal::visit_simplerule(n);
+  }
+
+  void visit_startstate(StartState &n) final {
+    filter(n.body);
+    Traversal::visit_startstate(n);
+  }
+
+  void visit_switchcase(SwitchCase &n) final {
+    filter(n.body);
+    Traversal::visit_switchcase(n);
+  }
+
+  void visit_while(While &n) final {
+    filter(n.body);
+    Traversal::visit_while(n);
+  }
+
+private:
+  // does this statement do nothing but write to sliced variables?
+  bool is_sliced(const Stmt &s) const {
+    std::vector<size_t> targets;
+    if (!only_writes(s, targets))
+      return false;
+    for (size_t id : targets) {
+      if (sliced->find(id) == sliced->end())
+        return false;
+    }
+    return true;
+  }
+
+  void filter(std::vector<Ptr<Stmt>> &body) const {
+    for (auto it = body.begin(); it != body.end();) {
+      if (is_sliced(**it)) {
+        it = body.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+};
+
+} // namespace
+
+size_t slice_state(Model &m) {
+
+  // find which reads can be relied on to never see an undefined value
+  find_always_defined(m);
+
+  Collector collector;
+  collector.dispatch(m);
+
+  // find everything the seeds transitively depend on
+  std::unordered_set<size_t> needed;
+  std::vector<size_t> pending(collector.seeds.begin(), collector.seeds.end());
+  while (!pending.empty()) {
+    const size_t id = pending.back();
+    pending.pop_back();
+    if (!needed.insert(id).second)
+      continue;
+    auto it = collector.deps.find(id);
+    if (it == collector.deps.end())
+      continue;
+    for (size_t dep : it->second) {
+      if (needed.find(dep) == needed.end())
+        pending.push_back(dep);
+    }
+  }
+
+  // find the state variables we can discard
+  std::unordered_set<size_t> sliced;
+  mpz_class sliced_bits = 0;
+  for (const Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<const VarDecl *>(c.get())) {
+      if (needed.find(v->unique_id) == needed.end()) {
+        *info << v->loc << ": sliced state variable " << v->name << " ("
+              << v->type->width() << " bits) that cannot influence any "
+              << "guard, property or condition\n";
+        sliced.insert(v->unique_id);
+        sliced_bits += v->type->width();
+      }
+    }
+  }
+
+  if (sliced.empty())
+    return 0;
+
+  // remove all writes to them
+  Slicer slicer(sliced);
+  slicer.dispatch(m);
+
+  // remove the variables themselves
+  for (auto it = m.children.begin(); it != m.children.end();) {
+    if (sliced.find((*it)->unique_id) != sliced.end()) {
+      it = m.children.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // the offset of each remaining variable within the model state is now
+  // inaccurate, so recalculate them
+  mpz_class offset = 0;
+  for (Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<VarDecl *>(c.get())) {
+      v->offset = offset;
+      offset += v->type->width();
+    }
+  }
+
+  *info << "sliced " << sliced.size() << " state variables, reducing the "
+        << "state size by " << sliced_bits << " bits\n";
+
+  return sliced.size();
+}
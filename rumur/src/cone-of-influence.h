@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <rumur/rumur.h>
+
+/* Remove state variables that cannot influence the behaviour of the model.
+ *
+ * A state variable is retained if it is read by a rule guard, a property, a
+ * control flow condition, a function or one of the other places whose value
+ * can affect which states are reachable or which errors are reported, as is
+ * any variable written or read by a write that may raise a runtime error. Any
+ * variable whose value flows into a retained variable through an assignment is
+ * then also retained. Every other state variable is removed from the model,
+ * along with the assignments, clears and undefines that write to it. Returns
+ * the number of state variables removed.
+ */
+size_t slice_state(rumur::Model &m);
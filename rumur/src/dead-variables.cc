@@ -0,0 +1,244 @@
+#include "dead-variables.h"
+#include "../../common/isa.h"
+#include "log.h"
+#include "options.h"
+#include <cstddef>
+#include <cstdint>
+#include <rumur/rumur.h>
+#include <unordered_set>
+#include <vector>
+
+using namespace rumur;
+
+// unique IDs of state variables that are dead between transitions
+static std::unordered_set<size_t> dead;
+
+namespace {
+
+// collect the state variables referenced within a node
+class Referencer : public ConstTraversal {
+
+public:
+  std::unordered_set<size_t> referenced;
+
+  void visit_exprid(const ExprID &n) final {
+    auto v = dynamic_cast<const VarDecl *>(n.value.get());
+    if (v != nullptr && v->is_in_state())
+      referenced.insert(v->unique_id);
+  }
+};
+
+// state variables that may be read before being written
+class Liveness {
+
+public:
+  std::unordered_set<size_t> live;
+
+  // note a read of everything referenced within this node
+  void read(const Node &n, const std::unordered_set<size_t> &written) {
+    Referencer r;
+    r.dispatch(n);
+    for (size_t id : r.referenced) {
+      if (written.find(id) == written.end())
+        live.insert(id);
+    }
+  }
+
+  void rule(const Rule &r) {
+    std::unordered_set<size_t> written;
+
+    for (const Quantifier &q : r.quantifiers)
+      read(q, written);
+    for (const Ptr<AliasDecl> &a : r.aliases)
+      read(*a, written);
+
+    if (auto s = dynamic_cast<const SimpleRule *>(&r)) {
+      if (s->guard != nullptr)
+        read(*s->guard, written);
+      body(s->body, written);
+      return;
+    }
+
+    // any other rule is a property that reads what it references
+    read(r, written);
+  }
+
+private:
+  void body(const std::vector<Ptr<Stmt>> &stmts,
+            std::unordered_set<size_t> &written) {
+    for (const Ptr<Stmt> &s : stmts)
+      stmt(*s, written);
+  }
+
+  // process a write to the given lvalue
+  void write(const Expr &lvalue, std::unordered_set<size_t> &written) {
+
+    // is this a write to an entire state variable?
+    if (auto x = dynamic_cast<const ExprID *>(&lvalue)) {
+      if (auto v = dynamic_cast<const VarDecl *>(x->value.get())) {
+        if (v->is_in_state()) {
+          written.insert(v->unique_id);
+          return;
+        }
+      }
+    }
+
+    // otherwise, conservatively treat this as a read of the variable
+    read(lvalue, written);
+  }
+
+  // intersect the variables written on two paths
+  static void meet(std::unordered_set<size_t> &a,
+                   const std::unordered_set<size_t> &b) {
+    for (auto it = a.begin(); it != a.end();) {
+      if (b.find(*it) == b.end()) {
+        it = a.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void stmt(const Stmt &s, std::unordered_set<size_t> &written) {
+
+    if (auto a = dynamic_cast<const Assignment *>(&s)) {
+      read(*a->rhs, written);
+      write(*a->lhs, written);
+      return;
+    }
+
+    if (auto c = dynamic_cast<const Clear *>(&s)) {
+      write(*c->rhs, written);
+      return;
+    }
+
+    if (auto u = dynamic_cast<const Undefine *>(&s)) {
+      write(*u->rhs, written);
+      return;
+    }
+
+    if (auto a = dynamic_cast<const AliasStmt *>(&s)) {
+      for (const Ptr<AliasDecl> &d : a->aliases)
+        read(*d, written);
+      body(a->body, written);
+      return;
+    }
+
+    if (auto i = dynamic_cast<const If *>(&s)) {
+      std::unordered_set<size_t> out;
+      bool first = true;
+      bool has_else = false;
+      for (const IfClause &c : i->clauses) {
+        if (c.condition == nullptr) {
+          has_else = true;
+        } else {
+          read(*c.condition, written);
+        }
+        std::unordered_set<size_t> w = written;
+        body(c.body, w);
+        if (first) {
+          out = w;
+          first = false;
+        } else {
+          meet(out, w);
+        }
+      }
+      // without an else, none of the clauses may be taken
+      if (!has_else)
+        return;
+      written = out;
+      return;
+    }
+
+    if (auto sw = dynamic_cast<const Switch *>(&s)) {
+      read(*sw->expr, written);
+      std::unordered_set<size_t> out;
+      bool first = true;
+      bool has_default = false;
+      for (const SwitchCase &c : sw->cases) {
+        if (c.matches.empty())
+          has_default = true;
+        for (const Ptr<Expr> &m : c.matches)
+          read(*m, written);
+        std::unordered_set<size_t> w = written;
+        body(c.body, w);
+        if (first) {
+          out = w;
+          first = false;
+        } else {
+          meet(out, w);
+        }
+      }
+      if (!has_default)
+        return;
+      written = out;
+      return;
+    }
+
+    // loops may execute zero times, so writes within them do not count
+    if (auto f = dynamic_cast<const For *>(&s)) {
+      read(f->quantifier, written);
+      std::unordered_set<size_t> w = written;
+      body(f->body, w);
+      return;
+    }
+    if (auto wh = dynamic_cast<const While *>(&s)) {
+      read(*wh->condition, written);
+      std::unordered_set<size_t> w = written;
+      body(wh->body, w);
+      return;
+    }
+
+    // anything else simply reads what it references
+    read(s, written);
+  }
+};
+
+} // namespace
+
+size_t find_dead_variables(const Model &m) {
+
+  dead.clear();
+
+  Liveness liveness;
+  for (const Ptr<Node> &c : m.children) {
+
+    // a function may be called from anywhere, so anything it references is
+    // live
+    if (auto f = dynamic_cast<const Function *>(c.get())) {
+      liveness.read(*f, {});
+      continue;
+    }
+
+    if (auto rule = dynamic_cast<const Rule *>(c.get())) {
+      for (const Ptr<Rule> &r : rule->flatten()) {
+        // start states execute from an empty state so do not observe
+        // anything left behind by a previous transition
+        if (isa<StartState>(r))
+          continue;
+        liveness.rule(*r);
+      }
+    }
+  }
+
+  for (const Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<const VarDecl *>(c.get())) {
+      if (liveness.live.find(v->unique_id) == liveness.live.end()) {
+        *info << v->loc << ": state variable " << v->name << " is dead "
+              << "between transitions and will be reset after each one\n";
+        dead.insert(v->unique_id);
+      }
+    }
+  }
+
+  return dead.size();
+}
+
+bool is_dead(const VarDecl &v) {
+  // without --auto-undefine, what we found may be from a previous model
+  if (!options.auto_undefine)
+    return false;
+  if (v.unique_id == SIZE_MAX)
+    return false;
+  return dead.find(v.unique_id) != dead.end();
+}
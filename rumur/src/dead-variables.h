@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <rumur/rumur.h>
+
+/* Find state variables whose values are dead between transitions.
+ *
+ * A state variable is dead if every rule definitely overwrites it before
+ * reading it (including in the guard) and no property reads it. Its value at
+ * the end of a transition can never be observed, so it can be reset to
+ * undefined after each rule fires. States that differ only in such a variable
+ * are then merged. Returns the number of dead state variables found.
+ */
+size_t find_dead_variables(const rumur::Model &m);
+
+/* Is this state variable one identified by find_dead_variables() as dead? This
+ * is always false when --auto-undefine is off.
+ */
+bool is_dead(const rumur::VarDecl &v);
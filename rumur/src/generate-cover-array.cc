@@ -77,5 +77,5 @@ void generate_cover_array(std::ostream &out, const Model &model) {
   mg.dispatch(model);
   out << "};\n\n";
 
-  out << "static uintmax_t covers[" << ca.get_count() << "];\n\n";
+  out << "SHARED uintmax_t covers[" << ca.get_count() << "];\n\n";
 }
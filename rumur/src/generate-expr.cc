@@ -1,5 +1,8 @@
 #include "../../common/isa.h"
+#include "always-defined.h"
 #include "generate.h"
+#include "interval-analysis.h"
+#include "smt/simplify.h"
 #include "utils.h"
 #include <cassert>
 #include <cstddef>
@@ -38,6 +41,11 @@ public:
   void visit_add(const Add &n) final {
     if (lvalue)
       invalid(n);
+    if (is_overflow_free(n)) {
+      elided_checks++;
+      *this << "((value_t)(" << *n.lhs << " + " << *n.rhs << "))";
+      return;
+    }
     *this << "add(" << to_C_string(n.loc) << ", rule_name, " << to_C_string(n)
           << ", s, " << *n.lhs << ", " << *n.rhs << ")";
   }
@@ -107,17 +115,19 @@ public:
       assert(false && "array with invalid index type");
     }
 
-    if (!lvalue && a.element_type->is_simple()) {
-      const std::string lb = a.element_type->lower_bound().get_str();
-      const std::string ub = a.element_type->upper_bound().get_str();
-      *out << "handle_read(" << to_C_string(n.loc) << ", rule_name, "
-           << to_C_string(n) << ", s, VALUE_C(" << lb << "), VALUE_C(" << ub
-           << "), ";
-    }
+    if (!lvalue && a.element_type->is_simple())
+      open_read(n, *a.element_type);
 
-    *out << "handle_index(" << to_C_string(n.loc) << ", rule_name, "
-         << to_C_string(n) << ", s, " << element_width << "ull, VALUE_C(" << min
-         << "), VALUE_C(" << max << "), ";
+    // if the index is known to be within bounds, we can skip the range check
+    if (smt::is_index_in_bounds(n) || is_in_range(*n.index, *a.index_type)) {
+      elided_checks++;
+      *out << "handle_index_unchecked(" << element_width << "ull, VALUE_C("
+           << min << "), VALUE_C(" << max << "), ";
+    } else {
+      *out << "handle_index(" << to_C_string(n.loc) << ", rule_name, "
+           << to_C_string(n) << ", s, " << element_width << "ull, VALUE_C("
+           << min << "), VALUE_C(" << max << "), ";
+    }
     if (lvalue) {
       generate_lvalue(*out, *n.array);
     } else {
@@ -126,7 +136,7 @@ public:
     *this << ", " << *n.index << ")";
 
     if (!lvalue && a.element_type->is_simple())
-      *out << ")";
+      close_read(n);
   }
 
   void visit_eq(const Eq &n) final {
@@ -177,17 +187,13 @@ public:
       const Ptr<TypeExpr> t = n.type();
       assert((!n.is_lvalue() || t != nullptr) && "lvalue without a type");
 
-      if (!lvalue && n.is_lvalue() && t->is_simple()) {
-        const std::string lb = "VALUE_C(" + t->lower_bound().get_str() + ")";
-        const std::string ub = "VALUE_C(" + t->upper_bound().get_str() + ")";
-        *out << "handle_read(" << to_C_string(n.loc) << ", rule_name, "
-             << to_C_string(n) << ", s, " << lb << ", " << ub << ", ";
-      }
+      if (!lvalue && n.is_lvalue() && t->is_simple())
+        open_read(n, *t);
 
       *out << "ru_" << n.id;
 
       if (!lvalue && n.is_lvalue() && t->is_simple())
-        *out << ")";
+        close_read(n);
       return;
     }
 
@@ -207,13 +213,8 @@ public:
       mpz_class offset = 0;
       for (const Ptr<VarDecl> &f : r->fields) {
         if (f->name == n.field) {
-          if (!lvalue && f->type->is_simple()) {
-            const std::string lb = f->type->lower_bound().get_str();
-            const std::string ub = f->type->upper_bound().get_str();
-            *out << "handle_read(" << to_C_string(n.loc) << ", rule_name, "
-                 << to_C_string(n) << ", s, VALUE_C(" << lb << "), VALUE_C("
-                 << ub << "), ";
-          }
+          if (!lvalue && f->type->is_simple())
+            open_read(n, *f->type);
           *out << "handle_narrow(";
           if (lvalue) {
             generate_lvalue(*out, *n.record);
@@ -222,7 +223,7 @@ public:
           }
           *out << ", " << offset << ", " << f->type->width() << ")";
           if (!lvalue && f->type->is_simple())
-            *out << ")";
+            close_read(n);
           return;
         }
         offset += f->type->width();
@@ -508,6 +509,11 @@ public:
   void visit_mul(const Mul &n) final {
     if (lvalue)
       invalid(n);
+    if (is_overflow_free(n)) {
+      elided_checks++;
+      *this << "((value_t)(" << *n.lhs << " * " << *n.rhs << "))";
+      return;
+    }
     *this << "mul(" << to_C_string(n.loc) << ", rule_name, " << to_C_string(n)
           << ", s, " << *n.lhs << ", " << *n.rhs << ")";
   }
@@ -538,6 +544,12 @@ public:
       }
     }
 
+    if (is_overflow_free(n)) {
+      elided_checks++;
+      *this << "((value_t)(-" << *n.rhs << "))";
+      return;
+    }
+
     *this << "negate(" << to_C_string(n.loc) << ", rule_name, "
           << to_C_string(n) << ", s, " << *n.rhs << ")";
   }
@@ -582,6 +594,11 @@ public:
   void visit_sub(const Sub &n) final {
     if (lvalue)
       invalid(n);
+    if (is_overflow_free(n)) {
+      elided_checks++;
+      *this << "((value_t)(" << *n.lhs << " - " << *n.rhs << "))";
+      return;
+    }
     *this << "sub(" << to_C_string(n.loc) << ", rule_name, " << to_C_string(n)
           << ", s, " << *n.lhs << ", " << *n.rhs << ")";
   }
@@ -599,6 +616,33 @@ public:
   }
 
 private:
+  // emit the start of a read of a simple-typed lvalue
+  void open_read(const Expr &n, const TypeExpr &t) {
+    const std::string lb = t.lower_bound().get_str();
+    const std::string ub = t.upper_bound().get_str();
+
+    // if this is known to never be undefined, we can skip checking for this
+    if (is_always_defined(n)) {
+      elided_checks++;
+      *out << "decode_value(VALUE_C(" << lb << "), VALUE_C(" << ub
+           << "), handle_read_raw(s, ";
+      return;
+    }
+
+    *out << "handle_read(" << to_C_string(n.loc) << ", rule_name, "
+         << to_C_string(n) << ", s, VALUE_C(" << lb << "), VALUE_C(" << ub
+         << "), ";
+  }
+
+  // emit the end of a read started by open_read()
+  void close_read(const Expr &n) {
+    if (is_always_defined(n)) {
+      *out << "))";
+      return;
+    }
+    *out << ")";
+  }
+
   void invalid(const Expr &n) const {
     throw Error("invalid expression used as lvalue", n.loc);
   }
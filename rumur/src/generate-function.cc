@@ -96,7 +96,7 @@ void generate_function(std::ostream &out, const Function &f,
   // Generate the body of the function
   for (auto &s : f.body) {
     out << "  ";
-    generate_stmt(out, *s);
+    generate_stmt(out, *s, true);
     out << ";\n";
   }
 
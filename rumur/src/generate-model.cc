@@ -1,13 +1,16 @@
 #include "../../common/escape.h"
 #include "../../common/isa.h"
+#include "dead-variables.h"
 #include "generate.h"
 #include "symmetry-reduction.h"
 #include <cassert>
 #include <cstddef>
+#include <functional>
 #include <gmpxx.h>
 #include <iostream>
 #include <memory>
 #include <rumur/rumur.h>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -19,23 +22,52 @@ static std::string rule_name_string(const Rule &r, size_t index) {
   return "\\\"" + escape(r.name) + "\\\"";
 }
 
-void generate_model(std::ostream &out, const Model &m) {
+FlatRules::FlatRules(const Model &m) {
+  for (const Ptr<Node> &c : m.children) {
+    if (auto rule = dynamic_cast<const Rule *>(c.get())) {
+
+      // Generate a set of flattened (non-hierarchical) rules. The purpose of
+      // this is to essentially remove rulesets from the cases generation needs
+      // to deal with.
+      for (const Ptr<Rule> &r : rule->flatten()) {
+        all.emplace_back(rule, r);
+        if (isa<StartState>(r)) {
+          start_states.push_back(r);
+        } else if (isa<PropertyRule>(r)) {
+          properties.push_back(r);
+        } else {
+          assert(isa<SimpleRule>(r) && "unexpected type of flattened rule");
+          rules.push_back(r);
+        }
+      }
+    }
+  }
+}
+
+static void generate_runtime(std::ostream &out, const Model &m,
+                             const FlatRules &flat);
+static void generate_printing(std::ostream &out, const Model &m,
+                              const FlatRules &flat);
+
+void generate_model(const ModelOutput &output, const Model &m,
+                    const FlatRules &flat) {
 
   // Write out the symmetry reduction canonicalisation function
-  generate_canonicalise(m, out);
-  out << "\n\n";
+  generate_canonicalise(m, output.common);
+  output.common << "\n\n";
 
   // index counters for various things
   size_t start_index = 0;    // for start states
   size_t property_index = 0; // for property rules
   size_t rule_index = 0;     // for simple rules
+  size_t flat_index = 0;     // for all of the above
 
   for (const Ptr<Node> &child : m.children) {
 
     // if this is a constant, emit it
     if (auto d = dynamic_cast<const ConstDecl *>(child.get())) {
-      generate_decl(out, *d);
-      out << ";\n\n";
+      generate_decl(output.common, *d);
+      output.common << ";\n\n";
       continue;
     }
 
@@ -51,26 +83,31 @@ void generate_model(std::ostream &out, const Model &m) {
           decls.push_back(d);
       }
 
-      generate_function(out, *f, decls);
-      out << "\n\n";
+      generate_function(output.common, *f, decls);
+      output.common << "\n\n";
       continue;
     }
 
-    if (auto rule = dynamic_cast<const Rule *>(child.get())) {
+    if (isa<Rule>(child)) {
 
-      // Generate a set of flattened (non-hierarchical) rules. The purpose of
-      // this is to essentially remove rulesets from the cases we need to deal
-      // with below.
-      const std::vector<Ptr<Rule>> rs = rule->flatten();
+      // the flattened rules that originated from this rule
+      for (; flat_index < flat.all.size() &&
+             flat.all[flat_index].first == child.get();
+           ++flat_index) {
+        const Ptr<Rule> &r = flat.all[flat_index].second;
 
-      for (const Ptr<Rule> &r : rs) {
+        std::ostream &out = output.rules(flat_index);
 
         if (auto s = dynamic_cast<const StartState *>(r.get())) {
-          out << "static bool startstate" << start_index
-              << "(struct state *NONNULL s";
+          std::ostringstream decl;
+          decl << "EXPORT bool startstate" << start_index
+               << "(struct state *NONNULL s";
           for (const Quantifier &q : s->quantifiers)
-            out << ", struct handle ru_" << q.name;
-          out << ") {\n";
+            decl << ", struct handle ru_" << q.name;
+          decl << ")";
+          out << decl.str() << " {\n";
+          if (output.prototypes)
+            output.common << decl.str() << ";\n";
 
           out << "  static const char rule_name[] __attribute__((unused)) = "
                  "\"startstate "
@@ -120,7 +157,7 @@ void generate_model(std::ostream &out, const Model &m) {
 
           for (auto &st : s->body) {
             out << "    ";
-            generate_stmt(out, *st);
+            generate_stmt(out, *st, false);
             out << ";\n";
           }
 
@@ -133,53 +170,77 @@ void generate_model(std::ostream &out, const Model &m) {
         }
 
         if (auto p = dynamic_cast<const PropertyRule *>(r.get())) {
-          out << "static __attribute__((unused)) bool property"
-              << property_index << "(const struct state *NONNULL s";
-          for (const Quantifier &q : p->quantifiers)
-            out << ", struct handle ru_" << q.name;
-          out << ") {\n";
 
-          out << "  static const char rule_name[] __attribute__((unused)) = "
-                 "\"property "
-              << rule_name_string(*p, property_index) << "\";\n";
+          // for invariants, we also emit a heuristic estimate of how far a
+          // state is from violating them
+          const bool is_invariant = p->property.category == Property::ASSERTION;
 
-          // output the state variable handles that are in scope so we can
-          // reference them within this property
-          for (const Ptr<Node> &c : m.children) {
-            if (child.get() == c.get())
+          for (bool distance : {false, true}) {
+            if (distance && !is_invariant)
               break;
-            if (auto d = dynamic_cast<const VarDecl *>(c.get())) {
-              out << "  ";
-              generate_decl(out, *d);
+
+            std::ostringstream decl;
+            decl << "EXPORT __attribute__((unused)) "
+                 << (distance ? "uint64_t distance" : "bool property")
+                 << property_index << "(const struct state *NONNULL s";
+            for (const Quantifier &q : p->quantifiers)
+              decl << ", struct handle ru_" << q.name;
+            decl << ")";
+            out << decl.str() << " {\n";
+            if (output.prototypes)
+              output.common << decl.str() << ";\n";
+
+            out << "  static const char rule_name[] __attribute__((unused)) = "
+                   "\"property "
+                << rule_name_string(*p, property_index) << "\";\n";
+
+            // output the state variable handles that are in scope so we can
+            // reference them within this property
+            for (const Ptr<Node> &c : m.children) {
+              if (child.get() == c.get())
+                break;
+              if (auto d = dynamic_cast<const VarDecl *>(c.get())) {
+                out << "  ";
+                generate_decl(out, *d);
+                out << ";\n";
+              }
+            }
+
+            // output alias definitions, opening a scope in advance to support
+            // aliases that shadow state variables, parameters, or other
+            // aliases
+            for (const Ptr<AliasDecl> &a : p->aliases) {
+              out << "   {\n  ";
+              generate_decl(out, *a);
               out << ";\n";
             }
-          }
 
-          // output alias definitions, opening a scope in advance to support
-          // aliases that shadow state variables, parameters, or other aliases
-          for (const Ptr<AliasDecl> &a : p->aliases) {
-            out << "   {\n  ";
-            generate_decl(out, *a);
-            out << ";\n";
+            out << "  return ";
+            if (distance) {
+              generate_distance(out, p->property);
+            } else {
+              generate_property(out, p->property);
+            }
+            out << ";\n"
+                << std::string(p->aliases.size(), '}') << "\n"
+                << "}\n\n";
           }
-
-          out << "  return ";
-          generate_property(out, p->property);
-          out << ";\n"
-              << std::string(p->aliases.size(), '}') << "\n"
-              << "}\n\n";
           ++property_index;
         }
 
         if (auto s = dynamic_cast<const SimpleRule *>(r.get())) {
 
           // write the guard
-          out << "static int guard" << rule_index
-              << "(const struct state *NONNULL s __attribute__((unused))";
+          std::ostringstream guard;
+          guard << "EXPORT int guard" << rule_index
+                << "(const struct state *NONNULL s __attribute__((unused))";
           for (const Quantifier &q : s->quantifiers)
-            out << ", struct handle ru_" << q.name
-                << " __attribute__((unused))";
-          out << ") {\n";
+            guard << ", struct handle ru_" << q.name
+                  << " __attribute__((unused))";
+          guard << ")";
+          out << guard.str() << " {\n";
+          if (output.prototypes)
+            output.common << guard.str() << ";\n";
 
           out << "  static const char rule_name[] __attribute__((unused)) = \""
                  "guard of rule "
@@ -227,10 +288,15 @@ void generate_model(std::ostream &out, const Model &m) {
               << "}\n\n";
 
           // write the body
-          out << "static bool rule" << rule_index << "(struct state *NONNULL s";
+          std::ostringstream body;
+          body << "EXPORT bool rule" << rule_index
+               << "(struct state *NONNULL s";
           for (const Quantifier &q : s->quantifiers)
-            out << ", struct handle ru_" << q.name;
-          out << ") {\n";
+            body << ", struct handle ru_" << q.name;
+          body << ")";
+          out << body.str() << " {\n";
+          if (output.prototypes)
+            output.common << body.str() << ";\n";
 
           out << "  static const char rule_name[] __attribute__((unused)) = "
                  "\"rule "
@@ -280,7 +346,7 @@ void generate_model(std::ostream &out, const Model &m) {
 
           for (auto &st : s->body) {
             out << "  ";
-            generate_stmt(out, *st);
+            generate_stmt(out, *st, false);
             out << ";\n";
           }
 
@@ -297,6 +363,33 @@ void generate_model(std::ostream &out, const Model &m) {
     }
   }
 
+  assert(start_index == flat.start_states.size() &&
+         property_index == flat.properties.size() &&
+         rule_index == flat.rules.size() &&
+         "flattened rules out of sync with model during generation");
+
+  generate_runtime(output.runtime, m, flat);
+  generate_printing(output.print, m, flat);
+}
+
+static void generate_runtime(std::ostream &out, const Model &m,
+                             const FlatRules &flat) {
+
+  // Write a function to reset dead state variables
+  {
+    out << "static void state_reset_dead(struct state *NONNULL s "
+           "__attribute__((unused))) {\n";
+    for (const Ptr<Node> &c : m.children) {
+      if (auto v = dynamic_cast<const VarDecl *>(c.get())) {
+        if (is_dead(*v))
+          out << "  /* " << v->name << " */\n"
+              << "  handle_zero(state_handle(s, " << v->offset << "ull, "
+              << v->type->width() << "ull));\n";
+      }
+    }
+    out << "}\n\n";
+  }
+
   // Write invariant checker
   {
     out << "static bool check_invariants(const struct state *NONNULL s "
@@ -310,55 +403,89 @@ void generate_model(std::ostream &out, const Model &m) {
            "  }\n";
     size_t index = 0;
     size_t invariant_index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-
-        // as above, we flatten the rule to avoid dealing with rulesets
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-
-        for (const Ptr<Rule> &r : rs) {
-          if (auto p = dynamic_cast<const PropertyRule *>(r.get())) {
-            if (p->property.category == Property::ASSERTION) {
-
-              // open a scope so we do not have to think about name collisions
-              out << "  {\n";
-
-              // set up quantifiers
-              for (const Quantifier &q : r->quantifiers)
-                generate_quantifier_header(out, q);
-
-              assert(index < property_index &&
-                     "miscounted property rules during model generation");
-
-              out << "    if (!property" << index << "(s";
-              for (const Quantifier &q : r->quantifiers)
-                out << ", ru_" << q.name;
-              out << ")) {\n"
-                  << "      error(s, \"invariant %s failed\", \""
-                  << rule_name_string(*p, invariant_index) << "\");\n"
-                  << "    }\n";
-
-              // close the quantifier loops
-              for (auto it = r->quantifiers.rbegin();
-                   it != r->quantifiers.rend(); it++)
-                generate_quantifier_footer(out, *it);
-
-              // close this invariant's scope
-              out << "  }\n";
-
-              assert(invariant_index <= index &&
-                     "incorrect invariant checker generation logic");
-              ++invariant_index;
-            }
-            ++index;
-          }
-        }
+    for (const Ptr<Rule> &r : flat.properties) {
+      auto p = dynamic_cast<const PropertyRule *>(r.get());
+      if (p->property.category == Property::ASSERTION) {
+
+        // open a scope so we do not have to think about name collisions
+        out << "  {\n";
+
+        // set up quantifiers
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        out << "    if (!property" << index << "(s";
+        for (const Quantifier &q : r->quantifiers)
+          out << ", ru_" << q.name;
+        out << ")) {\n"
+            << "      error(s, \"invariant %s failed\", \""
+            << rule_name_string(*p, invariant_index) << "\");\n"
+            << "    }\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this invariant's scope
+        out << "  }\n";
+
+        assert(invariant_index <= index &&
+               "incorrect invariant checker generation logic");
+        ++invariant_index;
       }
+      ++index;
     }
     out << "  return true;\n"
            "}\n\n";
   }
 
+  // Write search heuristic
+  {
+    out << "EXPORT uint64_t state_heuristic(const struct state *NONNULL s "
+           "__attribute__((unused))) {\n"
+           "  static const char *rule_name __attribute__((unused)) = NULL;\n"
+           "  volatile uint64_t h = UINT64_MAX;\n"
+           "  in_heuristic = true;\n";
+    size_t index = 0;
+    for (const Ptr<Rule> &r : flat.properties) {
+      auto p = dynamic_cast<const PropertyRule *>(r.get());
+      if (p->property.category == Property::ASSERTION) {
+
+        // open a scope so we do not have to think about name collisions
+        out << "  {\n";
+
+        // set up quantifiers
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        // an instance whose evaluation triggers an error is treated as
+        // infinitely far from violation, without affecting the others
+        out << "    if (sigsetjmp(heuristic_checkpoint, 0) == 0) {\n"
+            << "      uint64_t d = distance" << index << "(s";
+        for (const Quantifier &q : r->quantifiers)
+          out << ", ru_" << q.name;
+        out << ");\n"
+            << "      if (d < h) {\n"
+            << "        h = d;\n"
+            << "      }\n"
+            << "    }\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this invariant's scope
+        out << "  }\n";
+      }
+      ++index;
+    }
+    out << "  in_heuristic = false;\n"
+           "  return h;\n"
+           "}\n\n";
+  }
+
   // Write assumption checker
   {
     out << "static bool check_assumptions(const struct state *NONNULL s "
@@ -371,46 +498,34 @@ void generate_model(std::ostream &out, const Model &m) {
            "    }\n"
            "  }\n";
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-
-        // as above, we flatten the rule to avoid dealing with rulesets
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-
-        for (const Ptr<Rule> &r : rs) {
-          if (auto p = dynamic_cast<const PropertyRule *>(r.get())) {
-            if (p->property.category == Property::ASSUMPTION) {
-
-              // open a scope so we do not have to think about name collisions
-              out << "  {\n";
-
-              // set up quantifiers
-              for (const Quantifier &q : r->quantifiers)
-                generate_quantifier_header(out, q);
-
-              assert(index < property_index &&
-                     "miscounted property rules during model generation");
-
-              out << "    if (!property" << index << "(s";
-              for (const Quantifier &q : r->quantifiers)
-                out << ", ru_" << q.name;
-              out << ")) {\n"
-                     "      /* Assumption violated. */\n"
-                     "      return false;\n"
-                     "    }\n";
-
-              // close the quantifier loops
-              for (auto it = r->quantifiers.rbegin();
-                   it != r->quantifiers.rend(); it++)
-                generate_quantifier_footer(out, *it);
-
-              // close this assumptions's scope.
-              out << "  }\n";
-            }
-            ++index;
-          }
-        }
+    for (const Ptr<Rule> &r : flat.properties) {
+      auto p = dynamic_cast<const PropertyRule *>(r.get());
+      if (p->property.category == Property::ASSUMPTION) {
+
+        // open a scope so we do not have to think about name collisions
+        out << "  {\n";
+
+        // set up quantifiers
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        out << "    if (!property" << index << "(s";
+        for (const Quantifier &q : r->quantifiers)
+          out << ", ru_" << q.name;
+        out << ")) {\n"
+               "      /* Assumption violated. */\n"
+               "      return false;\n"
+               "    }\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this assumptions's scope.
+        out << "  }\n";
       }
+      ++index;
     }
     out << "  return true;\n"
            "}\n\n";
@@ -428,48 +543,36 @@ void generate_model(std::ostream &out, const Model &m) {
            "    }\n"
            "  }\n";
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-
-        // as above, we flatten the rule to avoid dealing with rulesets
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-
-        for (const Ptr<Rule> &r : rs) {
-          if (auto p = dynamic_cast<const PropertyRule *>(r.get())) {
-            if (p->property.category == Property::COVER) {
-
-              // open a scope so we do not have to think about name collisions
-              out << "  {\n";
-
-              // set up quantifiers
-              for (const Quantifier &q : r->quantifiers)
-                generate_quantifier_header(out, q);
-
-              assert(index < property_index &&
-                     "miscounted property rules during model generation");
-
-              out << "    if (property" << index << "(s";
-              for (const Quantifier &q : r->quantifiers)
-                out << ", ru_" << q.name;
-              out << ")) {\n"
-                     "      /* Covered. */\n"
-                     "      (void)__atomic_fetch_add(&covers[COVER_"
-                  << p->property.unique_id
-                  << "], 1, __ATOMIC_RELAXED);\n"
-                     "    }\n";
-
-              // close the quantifier loops
-              for (auto it = r->quantifiers.rbegin();
-                   it != r->quantifiers.rend(); it++)
-                generate_quantifier_footer(out, *it);
-
-              // close this cover's scope
-              out << "  }\n";
-            }
-            ++index;
-          }
-        }
+    for (const Ptr<Rule> &r : flat.properties) {
+      auto p = dynamic_cast<const PropertyRule *>(r.get());
+      if (p->property.category == Property::COVER) {
+
+        // open a scope so we do not have to think about name collisions
+        out << "  {\n";
+
+        // set up quantifiers
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        out << "    if (property" << index << "(s";
+        for (const Quantifier &q : r->quantifiers)
+          out << ", ru_" << q.name;
+        out << ")) {\n"
+               "      /* Covered. */\n"
+               "      (void)__atomic_fetch_add(&covers[COVER_"
+            << p->property.unique_id
+            << "], 1, __ATOMIC_RELAXED);\n"
+               "    }\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this cover's scope
+        out << "  }\n";
       }
+      ++index;
     }
     out << "  return true;\n"
            "}\n\n";
@@ -489,47 +592,35 @@ void generate_model(std::ostream &out, const Model &m) {
            "  }\n"
            "  size_t liveness_index __attribute__((unused)) = 0;\n";
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-
-        // as above, we flatten the rule to avoid dealing with rulesets
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-
-        for (const Ptr<Rule> &r : rs) {
-          if (auto p = dynamic_cast<const PropertyRule *>(r.get())) {
-            if (p->property.category == Property::LIVENESS) {
-
-              // open a scope so we do not have to think about name collisions
-              out << "  {\n";
-
-              // set up quantifiers
-              for (const Quantifier &q : r->quantifiers)
-                generate_quantifier_header(out, q);
-
-              assert(index < property_index &&
-                     "miscounted property rules during model generation");
-
-              out << "    if (property" << index << "(s";
-              for (const Quantifier &q : r->quantifiers)
-                out << ", ru_" << q.name;
-              out << ")) {\n"
-                     "      /* Hit. */\n"
-                     "      mark_liveness(s, liveness_index, false);\n"
-                     "    }\n"
-                     "    liveness_index++;\n";
-
-              // close the quantifier loops
-              for (auto it = r->quantifiers.rbegin();
-                   it != r->quantifiers.rend(); it++)
-                generate_quantifier_footer(out, *it);
-
-              // close this liveness property's scope
-              out << "  }\n";
-            }
-            ++index;
-          }
-        }
+    for (const Ptr<Rule> &r : flat.properties) {
+      auto p = dynamic_cast<const PropertyRule *>(r.get());
+      if (p->property.category == Property::LIVENESS) {
+
+        // open a scope so we do not have to think about name collisions
+        out << "  {\n";
+
+        // set up quantifiers
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        out << "    if (property" << index << "(s";
+        for (const Quantifier &q : r->quantifiers)
+          out << ", ru_" << q.name;
+        out << ")) {\n"
+               "      /* Hit. */\n"
+               "      mark_liveness(s, liveness_index, false);\n"
+               "    }\n"
+               "    liveness_index++;\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this liveness property's scope
+        out << "  }\n";
       }
+      ++index;
     }
     out << "  return true;\n"
            "}\n\n";
@@ -537,11 +628,11 @@ void generate_model(std::ostream &out, const Model &m) {
 
   // Write final liveness checker, the one that runs just prior to termination
   {
-    out << "static void check_liveness_final(void) {\n"
+    out << "EXPORT void check_liveness_final(void) {\n"
            "\n"
            "  static const char *rule_name __attribute__((unused)) = NULL;\n"
            "\n"
-           "  if (!MACHINE_READABLE_OUTPUT) {\n"
+           "  if (!machine_readable_output) {\n"
            "    put(\"trying to prove remaining liveness "
            "constraints...\\n\");\n"
            "  }\n"
@@ -550,7 +641,7 @@ void generate_model(std::ostream &out, const Model &m) {
            "  unsigned long remaining = 0;\n"
            "  unsigned long long last_update = 0;\n"
            "  unsigned long learned_since_last = 0;\n"
-           "  if (!MACHINE_READABLE_OUTPUT) {\n"
+           "  if (!machine_readable_output) {\n"
            "    for (size_t i = 0; i < set_size(local_seen); i++) {\n"
            "\n"
            "      slot_t slot = __atomic_load_n(&local_seen->bucket[i], "
@@ -618,120 +709,110 @@ void generate_model(std::ostream &out, const Model &m) {
            "#endif\n"
            "\n";
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-        for (const Ptr<Rule> &r : rs) {
-          if (isa<SimpleRule>(r)) {
-
-            assert(index < rule_index &&
-                   "miscounted simple rules during model generation");
-
-            // open a scope so we do not have to think about name collisions
-            out << "      {\n";
-
-            for (const Quantifier &q : r->quantifiers)
-              generate_quantifier_header(out, q);
-
-            out
-                // use a dummy do-while to give us 'break' as a local goto
-                << "        do {\n"
-                   "          struct state *n = state_dup(s);\n"
-                   "\n"
-                   "          int g = guard"
-                << index << "(n";
-            for (const Quantifier &q : r->quantifiers)
-              out << ", ru_" << q.name;
-            out << ");\n"
-                   "          if (g == -1) {\n"
-                   "            /* guard triggered an error */\n"
-                   "            state_free(n);\n"
-                   "            break;\n"
-                   "          } else if (g == 1) {\n"
-                   "            if (!rule"
-                << index << "(n";
-            for (const Quantifier &q : r->quantifiers)
-              out << ", ru_" << q.name;
-            out << ")) {\n"
-                   "              /* this rule triggered an error */\n"
-                   "              state_free(n);\n"
-                   "              break;\n"
-                   "            }\n"
-                   "            state_canonicalise(n);\n"
-                   "            if (!check_assumptions(n)) {\n"
-                   "              /* assumption violated */\n"
-                   "              state_free(n);\n"
-                   "              break;\n"
-                   "            }\n"
-                   "\n"
-                   "            /* note that we can skip an invariant check "
-                   "because we already know it\n"
-                   "             * passed from prior expansion of this state.\n"
-                   "             */\n"
-                   "\n"
-                   "            /* We should be able to find this state in the "
-                   "seen set. */\n"
-                   "            const struct state *t = set_find(n);\n"
-                   "            ASSERT(t != NULL && \"state encountered during "
-                   "final liveness wrap up \"\n"
-                   "              \"that was not previously seen\");\n"
-                   "\n"
-                   "            /* See if this successor state learned a "
-                   "liveness property it never\n"
-                   "             * passed back to us. This can occur if the "
-                   "state our exploration\n"
-                   "             * encountered (`n`) was not the first of its "
-                   "kind seen and thus was\n"
-                   "             * de-duped and never made it into the seen "
-                   "set with a back pointer\n"
-                   "             * to `s`.\n"
-                   "             */\n"
-                   "            unsigned long learned = learn_liveness(s, t);\n"
-                   "            if (learned > 0) {\n"
-                   "              if (!MACHINE_READABLE_OUTPUT) {\n"
-                   "                learned_since_last += learned;\n"
-                   "                remaining -= learned;\n"
-                   "                unsigned long long t = gettime();\n"
-                   "                if (t > last_update) {\n"
-                   "                  put(\"\\t \");\n"
-                   "                  put_uint(learned_since_last);\n"
-                   "                  put(\" further liveness constraints "
-                   "proved in \");\n"
-                   "                  put_uint(t - last_update);\n"
-                   "                  put(\"s, with \");\n"
-                   "                  put(green()); put_uint(remaining); "
-                   "put(reset());\n"
-                   "                  put(\" remaining\\n\");\n"
-                   "                  learned_since_last = 0;\n"
-                   "                  last_update = t;\n"
-                   "                }\n"
-                   "              }\n"
-                   "              progress = true;\n"
-                   "            }\n"
-                   "          }\n"
-                   "          /* we don't need this state anymore. */\n"
-                   "          state_free(n);\n"
-                   "        } while (0);\n";
-
-            // close the quantifier loops
-            for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
-                 it++)
-              generate_quantifier_footer(out, *it);
-
-            // close this rule's scope
-            out << "}\n";
-
-            ++index;
-          }
-        }
-      }
+    for (const Ptr<Rule> &r : flat.rules) {
+      // open a scope so we do not have to think about name collisions
+      out << "      {\n";
+
+      for (const Quantifier &q : r->quantifiers)
+        generate_quantifier_header(out, q);
+
+      out
+          // use a dummy do-while to give us 'break' as a local goto
+          << "        do {\n"
+             "          struct state *n = state_dup(s);\n"
+             "\n"
+             "          int g = guard"
+          << index << "(n";
+      for (const Quantifier &q : r->quantifiers)
+        out << ", ru_" << q.name;
+      out << ");\n"
+             "          if (g == -1) {\n"
+             "            /* guard triggered an error */\n"
+             "            state_free(n);\n"
+             "            break;\n"
+             "          } else if (g == 1) {\n"
+             "            if (!rule"
+          << index << "(n";
+      for (const Quantifier &q : r->quantifiers)
+        out << ", ru_" << q.name;
+      out << ")) {\n"
+             "              /* this rule triggered an error */\n"
+             "              state_free(n);\n"
+             "              break;\n"
+             "            }\n"
+             "            state_reset_dead(n);\n"
+             "            state_canonicalise(n);\n"
+             "            if (!check_assumptions(n)) {\n"
+             "              /* assumption violated */\n"
+             "              state_free(n);\n"
+             "              break;\n"
+             "            }\n"
+             "\n"
+             "            /* note that we can skip an invariant check "
+             "because we already know it\n"
+             "             * passed from prior expansion of this state.\n"
+             "             */\n"
+             "\n"
+             "            /* We should be able to find this state in the "
+             "seen set. */\n"
+             "            const struct state *t = set_find(n);\n"
+             "            ASSERT(t != NULL && \"state encountered during "
+             "final liveness wrap up \"\n"
+             "              \"that was not previously seen\");\n"
+             "\n"
+             "            /* See if this successor state learned a "
+             "liveness property it never\n"
+             "             * passed back to us. This can occur if the "
+             "state our exploration\n"
+             "             * encountered (`n`) was not the first of its "
+             "kind seen and thus was\n"
+             "             * de-duped and never made it into the seen "
+             "set with a back pointer\n"
+             "             * to `s`.\n"
+             "             */\n"
+             "            unsigned long learned = learn_liveness(s, t);\n"
+             "            if (learned > 0) {\n"
+             "              if (!machine_readable_output) {\n"
+             "                learned_since_last += learned;\n"
+             "                remaining -= learned;\n"
+             "                unsigned long long t = gettime();\n"
+             "                if (t > last_update) {\n"
+             "                  put(\"\\t \");\n"
+             "                  put_uint(learned_since_last);\n"
+             "                  put(\" further liveness constraints "
+             "proved in \");\n"
+             "                  put_uint(t - last_update);\n"
+             "                  put(\"s, with \");\n"
+             "                  put(green()); put_uint(remaining); "
+             "put(reset());\n"
+             "                  put(\" remaining\\n\");\n"
+             "                  learned_since_last = 0;\n"
+             "                  last_update = t;\n"
+             "                }\n"
+             "              }\n"
+             "              progress = true;\n"
+             "            }\n"
+             "          }\n"
+             "          /* we don't need this state anymore. */\n"
+             "          state_free(n);\n"
+             "        } while (0);\n";
+
+      // close the quantifier loops
+      for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+           it++)
+        generate_quantifier_footer(out, *it);
+
+      // close this rule's scope
+      out << "}\n";
+
+      ++index;
     }
     out << "    }\n"
            "  }\n"
            "}\n"
            "\n"
            "\n"
-           "static unsigned long check_liveness_summarise(void) {\n"
+           "EXPORT unsigned long check_liveness_summarise(void) {\n"
            "\n"
            "  /* We can now finally check whether all liveness properties were "
            "hit. */\n"
@@ -756,67 +837,58 @@ void generate_model(std::ostream &out, const Model &m) {
            "\n"
            "    size_t index __attribute__((unused)) = 0;\n";
     index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-        for (const Ptr<Rule> &r : rs) {
-          if (auto p = dynamic_cast<const PropertyRule *>(r.get())) {
-            if (p->property.category == Property::LIVENESS) {
-
-              assert(index < property_index &&
-                     "miscounted liveness properties during model generation");
-
-              // open a scope so we don't have to think about name collisions
-              out << "    {\n";
-
-              // Set up quantifiers. Note, in this case they are not used.
-              for (const Quantifier &q : r->quantifiers)
-                generate_quantifier_header(out, q);
-
-              out << "      size_t word_index = index / "
-                     "(sizeof(s->liveness[0]) * CHAR_BIT);\n"
-                     "      size_t bit_index = index % (sizeof(s->liveness[0]) "
-                     "* CHAR_BIT);\n"
-                     "      if (!missed[index] && !((s->liveness[word_index] "
-                     ">> bit_index) & 0x1)) {\n"
-                     "        /* missed */\n"
-                     "        missed[index] = true;\n"
-                     "        if (MACHINE_READABLE_OUTPUT) {\n"
-                     "          put(\"<error includes_trace=\\\"\");\n"
-                     "          put(COUNTEREXAMPLE_TRACE == CEX_OFF ? "
-                     "\"false\" : \"true\");\n"
-                     "          put(\"\\\">\\n<message>liveness property \");\n"
-                     "          xml_printf(\""
-                  << rule_name_string(*p, index)
-                  << "\");\n"
-                     "          put(\" violated</message>\\n\");\n"
-                     "        } else {\n"
-                     "          put(\"\\t\");\n"
-                     "          put(red()); put(bold());\n"
-                     "          put(\"liveness property "
-                  << rule_name_string(*p, index)
-                  << " violated:\");\n"
-                     "          put(reset()); put(\"\\n\");\n"
-                     "        }\n"
-                     "        print_counterexample(s);\n"
-                     "        if (MACHINE_READABLE_OUTPUT) {\n"
-                     "          put(\"</error>\\n\");\n"
-                     "        }\n"
-                     "      }\n"
-                     "      index++;\n";
-
-              // close the quantifier loops
-              for (auto it = r->quantifiers.rbegin();
-                   it != r->quantifiers.rend(); it++)
-                generate_quantifier_footer(out, *it);
-
-              // close this liveness property's scope
-              out << "    }\n";
-
-              ++index;
-            }
-          }
-        }
+    for (const Ptr<Rule> &r : flat.properties) {
+      auto p = dynamic_cast<const PropertyRule *>(r.get());
+      if (p->property.category == Property::LIVENESS) {
+
+        // open a scope so we don't have to think about name collisions
+        out << "    {\n";
+
+        // Set up quantifiers. Note, in this case they are not used.
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        out << "      size_t word_index = index / "
+               "(sizeof(s->liveness[0]) * CHAR_BIT);\n"
+               "      size_t bit_index = index % (sizeof(s->liveness[0]) "
+               "* CHAR_BIT);\n"
+               "      if (!missed[index] && !((s->liveness[word_index] "
+               ">> bit_index) & 0x1)) {\n"
+               "        /* missed */\n"
+               "        missed[index] = true;\n"
+               "        if (machine_readable_output) {\n"
+               "          put(\"<error includes_trace=\\\"\");\n"
+               "          put(COUNTEREXAMPLE_TRACE == CEX_OFF ? "
+               "\"false\" : \"true\");\n"
+               "          put(\"\\\">\\n<message>liveness property \");\n"
+               "          xml_printf(\""
+            << rule_name_string(*p, index)
+            << "\");\n"
+               "          put(\" violated</message>\\n\");\n"
+               "        } else {\n"
+               "          put(\"\\t\");\n"
+               "          put(red()); put(bold());\n"
+               "          put(\"liveness property "
+            << rule_name_string(*p, index)
+            << " violated:\");\n"
+               "          put(reset()); put(\"\\n\");\n"
+               "        }\n"
+               "        print_counterexample(s);\n"
+               "        if (machine_readable_output) {\n"
+               "          put(\"</error>\\n\");\n"
+               "        }\n"
+               "      }\n"
+               "      index++;\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this liveness property's scope
+        out << "    }\n";
+
+        ++index;
       }
     }
     out << "  }\n"
@@ -838,103 +910,92 @@ void generate_model(std::ostream &out, const Model &m) {
 
   // Write initialisation
   {
-    out << "static void init(void) {\n"
+    out << "EXPORT void init(void) {\n"
            "  static const char *rule_name __attribute__((unused)) = NULL;\n"
            "  size_t queue_id = 0;\n"
            "  uint64_t rule_taken = 1;\n";
 
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-        for (const Ptr<Rule> &r : rs) {
-          if (isa<StartState>(r)) {
-
-            assert(index < start_index &&
-                   "miscounted start states during model generation");
-
-            // open a scope so we do not have to think about name collisions
-            out << "  {\n";
-
-            //  Define the state variable because the code emitted for
-            // quantifiers expects it. They do not need a non-NULL value.
-            out << "    struct state *s = NULL;\n";
-
-            // set up quantifiers
-            for (const Quantifier &q : r->quantifiers)
-              generate_quantifier_header(out, q);
-
-            out
-                // use a dummy do-while to give us 'break' as a local goto
-                << "    do {\n"
-
-                   "      s = state_new();\n"
-                   "      memset(s, 0, sizeof(*s));\n"
-                   "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
-                   "      state_rule_taken_set(s, rule_taken);\n"
-                   "#endif\n"
-                   "      if (!startstate"
-                << index << "(s";
-            for (const Quantifier &q : r->quantifiers)
-              out << ", ru_" << q.name;
-            out << ")) {\n"
-                   "        /* startstate triggered an error */\n"
-                   "        state_free(s);\n"
-                   "        break;\n"
-                   "      }\n"
-                   "      state_canonicalise(s);\n"
-                   "      if (!check_assumptions(s)) {\n"
-                   "        /* assumption violated */\n"
-                   "        state_free(s);\n"
-                   "        break;\n"
-                   "      }\n"
-                   "      if (!check_invariants(s)) {\n"
-                   "        /* invariant violated */\n"
-                   "        state_free(s);\n"
-                   "        break;\n"
-                   "      }\n"
-                   "      size_t size;\n"
-                   "      if (set_insert(s, &size)) {\n"
-                   "        if (!check_covers(s)) {\n"
-                   "          /* one of the cover properties triggered an "
-                   "error */\n"
-                   "          break;\n"
-                   "        }\n"
-                   "#if LIVENESS_COUNT > 0\n"
-                   "        if (!check_liveness(s)) {\n"
-                   "          /* one of the liveness properties triggered an "
-                   "error */\n"
-                   "          break;\n"
-                   "        }\n"
-                   "#endif\n"
-                   "        (void)queue_enqueue(s, queue_id);\n"
-                   "        queue_id = (queue_id + 1) % (sizeof(q) / "
-                   "sizeof(q[0]));\n"
-                   "      } else {\n"
-                   "        state_free(s);\n"
-                   "      }\n"
-                   "    } while (0);\n"
-                   "    rule_taken++;\n";
-
-            // close the quantifier loops
-            for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
-                 it++)
-              generate_quantifier_footer(out, *it);
-
-            // close this startstate's scope
-            out << "  }\n";
-
-            ++index;
-          }
-        }
-      }
+    for (const Ptr<Rule> &r : flat.start_states) {
+      // open a scope so we do not have to think about name collisions
+      out << "  {\n";
+
+      //  Define the state variable because the code emitted for
+      // quantifiers expects it. They do not need a non-NULL value.
+      out << "    struct state *s = NULL;\n";
+
+      // set up quantifiers
+      for (const Quantifier &q : r->quantifiers)
+        generate_quantifier_header(out, q);
+
+      out
+          // use a dummy do-while to give us 'break' as a local goto
+          << "    do {\n"
+
+             "      s = state_new();\n"
+             "      memset(s, 0, sizeof(*s));\n"
+             "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+             "      state_rule_taken_set(s, rule_taken);\n"
+             "#endif\n"
+             "      if (!startstate"
+          << index << "(s";
+      for (const Quantifier &q : r->quantifiers)
+        out << ", ru_" << q.name;
+      out << ")) {\n"
+             "        /* startstate triggered an error */\n"
+             "        state_free(s);\n"
+             "        break;\n"
+             "      }\n"
+             "      state_reset_dead(s);\n"
+             "      state_canonicalise(s);\n"
+             "      if (!check_assumptions(s)) {\n"
+             "        /* assumption violated */\n"
+             "        state_free(s);\n"
+             "        break;\n"
+             "      }\n"
+             "      if (!check_invariants(s)) {\n"
+             "        /* invariant violated */\n"
+             "        state_free(s);\n"
+             "        break;\n"
+             "      }\n"
+             "      size_t size;\n"
+             "      if (set_insert(s, &size)) {\n"
+             "        if (!check_covers(s)) {\n"
+             "          /* one of the cover properties triggered an "
+             "error */\n"
+             "          break;\n"
+             "        }\n"
+             "#if LIVENESS_COUNT > 0\n"
+             "        if (!check_liveness(s)) {\n"
+             "          /* one of the liveness properties triggered an "
+             "error */\n"
+             "          break;\n"
+             "        }\n"
+             "#endif\n"
+             "        (void)pending_enqueue(s, queue_id);\n"
+             "        queue_id = (queue_id + 1) % thread_count;\n"
+             "      } else {\n"
+             "        state_free(s);\n"
+             "      }\n"
+             "    } while (0);\n"
+             "    rule_taken++;\n";
+
+      // close the quantifier loops
+      for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+           it++)
+        generate_quantifier_footer(out, *it);
+
+      // close this startstate's scope
+      out << "  }\n";
+
+      ++index;
     }
     out << "}\n\n";
   }
 
   // Write exploration logic
   {
-    out << "static void explore(void) {\n"
+    out << "EXPORT void explore(void) {\n"
            "\n"
            "  /* Used when writing to quantifier variables. */\n"
            "  static const char *rule_name __attribute__((unused)) = NULL;\n"
@@ -947,12 +1008,12 @@ void generate_model(std::ostream &out, const Model &m) {
            "  for (;;) {\n"
            "\n"
            "    if (THREADS > 1 && __atomic_load_n(&error_count,\n"
-           "        __ATOMIC_ACQUIRE) >= MAX_ERRORS) {\n"
+           "        __ATOMIC_ACQUIRE) >= max_errors) {\n"
            "      /* Another thread found an error. */\n"
            "      break;\n"
            "    }\n"
            "\n"
-           "    const struct state *s = queue_dequeue(&queue_id);\n"
+           "    const struct state *s = pending_dequeue(&queue_id);\n"
            "    if (s == NULL) {\n"
            "      break;\n"
            "    }\n"
@@ -960,153 +1021,143 @@ void generate_model(std::ostream &out, const Model &m) {
            "    bool possible_deadlock = true;\n"
            "    uint64_t rule_taken = 1;\n";
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-        for (const Ptr<Rule> &r : rs) {
-          if (isa<SimpleRule>(r)) {
-
-            assert(index < rule_index &&
-                   "miscounted simple rules during model generation");
-
-            // open a scope so we do not have to think about name collisions
-            out << "    {\n";
-
-            for (const Quantifier &q : r->quantifiers)
-              generate_quantifier_header(out, q);
-
-            out
-                // use a dummy do-while to give us 'break' as a local goto
-                << "      do {\n"
-                   "        struct state *n = state_dup(s);\n"
-                   "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
-                   "        state_rule_taken_set(n, rule_taken);\n"
-                   "#endif\n"
-                   "        int g = guard"
-                << index << "(n";
-            for (const Quantifier &q : r->quantifiers)
-              out << ", ru_" << q.name;
-            out << ");\n"
-                   "        if (g == -1) {\n"
-                   "          /* error() was called */\n"
-                   "          state_free(n);\n"
-                   "          break;\n"
-                   "        } else if (g == 1) {\n"
-                   "          if (!rule"
-                << index << "(n";
-            for (const Quantifier &q : r->quantifiers)
-              out << ", ru_" << q.name;
-            out << ")) {\n"
-                   "            /* this rule triggered an error */\n"
-                   "            state_free(n);\n"
-                   "            break;\n"
-                   "          }\n"
-                   "          rules_fired_local++;\n"
-                   "          if (DEADLOCK_DETECTION != "
-                   "DEADLOCK_DETECTION_STUTTERING || !state_eq(s, n)) {\n"
-                   "            possible_deadlock = false;\n"
-                   "          }\n"
-                   "          state_canonicalise(n);\n"
-                   "          if (!check_assumptions(n)) {\n"
-                   "            /* assumption violated */\n"
-                   "            state_free(n);\n"
-                   "            break;\n"
-                   "          }\n"
-                   "          if (!check_invariants(n)) {\n"
-                   "            /* invariant violated */\n"
-                   "            state_free(n);\n"
-                   "            break;\n"
-                   "          }\n"
-                   "          size_t size;\n"
-                   "          if (set_insert(n, &size)) {\n"
-                   "\n"
-                   "            if (!check_covers(n)) {\n"
-                   "              /* one of the cover properties triggered an "
-                   "error */\n"
-                   "              break;\n"
-                   "            }\n"
-                   "#if LIVENESS_COUNT > 0\n"
-                   "            if (!check_liveness(n)) {\n"
-                   "              /* one of the liveness properties triggered "
-                   "an error */\n"
-                   "              break;\n"
-                   "            }\n"
-                   "#endif\n"
-                   "\n"
-                   "#if BOUND > 0\n"
-                   "            if (state_bound_get(n) < BOUND) {\n"
-                   "#endif\n"
-                   "            size_t queue_size = queue_enqueue(n, "
-                   "thread_id);\n"
-                   "            queue_id = thread_id;\n"
-                   "\n"
-                   "            if (size % 10000 == 0 && ftrylockfile(stdout) "
-                   "== 0) {\n"
-                   "              if (MACHINE_READABLE_OUTPUT) {\n"
-                   "                put(\"<progress states=\\\"\");\n"
-                   "                put_uint(size);\n"
-                   "                put(\"\\\" duration_seconds=\\\"\");\n"
-                   "                put_uint(gettime());\n"
-                   "                put(\"\\\" rules_fired=\\\"\");\n"
-                   "                put_uint(rules_fired_local);\n"
-                   "                put(\"\\\" queue_size=\\\"\");\n"
-                   "                put_uint(queue_size);\n"
-                   "                put(\"\\\" thread_id=\\\"\");\n"
-                   "                put_uint(thread_id);\n"
-                   "                put(\"\\\"/>\\n\");\n"
-                   "              } else {\n"
-                   "                put(\"\\t \");\n"
-                   "                if (THREADS > 1) {\n"
-                   "                  put(\"thread \");\n"
-                   "                  put_uint(thread_id);\n"
-                   "                  put(\": \");\n"
-                   "                }\n"
-                   "                put_uint(size);\n"
-                   "                put(\" states explored in \");\n"
-                   "                put_uint(gettime());\n"
-                   "                put(\"s, with \");\n"
-                   "                put_uint(rules_fired_local);\n"
-                   "                put(\" rules fired and \");\n"
-                   "                put(queue_size > last_queue_size ? "
-                   "yellow() : green());\n"
-                   "                put_uint(queue_size);\n"
-                   "                put(reset());\n"
-                   "                put(\" states in the queue.\\n\");\n"
-                   "              }\n"
-                   "              funlockfile(stdout);\n"
-                   "              last_queue_size = queue_size;\n"
-                   "            }\n"
-                   "\n"
-                   "            if (THREADS > 1 && thread_id == 0 && phase == "
-                   "WARMUP && queue_size > 20) {\n"
-                   "              start_secondary_threads();\n"
-                   "              phase = RUN;\n"
-                   "            }\n"
-                   "\n"
-                   "#if BOUND > 0\n"
-                   "            }\n"
-                   "#endif\n"
-                   "          } else {\n"
-                   "            state_free(n);\n"
-                   "          }\n"
-                   "        } else {\n"
-                   "          state_free(n);\n"
-                   "        }\n"
-                   "      } while (0);\n"
-                   "      rule_taken++;\n";
-
-            // close the quantifier loops
-            for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
-                 it++)
-              generate_quantifier_footer(out, *it);
-
-            // close this rule's scope
-            out << "}\n";
-
-            ++index;
-          }
-        }
-      }
+    for (const Ptr<Rule> &r : flat.rules) {
+      // open a scope so we do not have to think about name collisions
+      out << "    {\n";
+
+      for (const Quantifier &q : r->quantifiers)
+        generate_quantifier_header(out, q);
+
+      out
+          // use a dummy do-while to give us 'break' as a local goto
+          << "      do {\n"
+             "        struct state *n = state_dup(s);\n"
+             "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+             "        state_rule_taken_set(n, rule_taken);\n"
+             "#endif\n"
+             "        int g = guard"
+          << index << "(n";
+      for (const Quantifier &q : r->quantifiers)
+        out << ", ru_" << q.name;
+      out << ");\n"
+             "        if (g == -1) {\n"
+             "          /* error() was called */\n"
+             "          state_free(n);\n"
+             "          break;\n"
+             "        } else if (g == 1) {\n"
+             "          if (!rule"
+          << index << "(n";
+      for (const Quantifier &q : r->quantifiers)
+        out << ", ru_" << q.name;
+      out << ")) {\n"
+             "            /* this rule triggered an error */\n"
+             "            state_free(n);\n"
+             "            break;\n"
+             "          }\n"
+             "          state_reset_dead(n);\n"
+             "          rules_fired_local++;\n"
+             "          if (DEADLOCK_DETECTION != "
+             "DEADLOCK_DETECTION_STUTTERING || !state_eq(s, n)) {\n"
+             "            possible_deadlock = false;\n"
+             "          }\n"
+             "          state_canonicalise(n);\n"
+             "          if (!check_assumptions(n)) {\n"
+             "            /* assumption violated */\n"
+             "            state_free(n);\n"
+             "            break;\n"
+             "          }\n"
+             "          if (!check_invariants(n)) {\n"
+             "            /* invariant violated */\n"
+             "            state_free(n);\n"
+             "            break;\n"
+             "          }\n"
+             "          size_t size;\n"
+             "          if (set_insert(n, &size)) {\n"
+             "\n"
+             "            if (!check_covers(n)) {\n"
+             "              /* one of the cover properties triggered an "
+             "error */\n"
+             "              break;\n"
+             "            }\n"
+             "#if LIVENESS_COUNT > 0\n"
+             "            if (!check_liveness(n)) {\n"
+             "              /* one of the liveness properties triggered "
+             "an error */\n"
+             "              break;\n"
+             "            }\n"
+             "#endif\n"
+             "\n"
+             "#if BOUND > 0\n"
+             "            if (state_bound_get(n) < BOUND) {\n"
+             "#endif\n"
+             "            size_t queue_size = pending_enqueue(n, "
+             "thread_id);\n"
+             "            queue_id = thread_id;\n"
+             "\n"
+             "            if (size % 10000 == 0 && ftrylockfile(stdout) "
+             "== 0) {\n"
+             "              if (machine_readable_output) {\n"
+             "                put(\"<progress states=\\\"\");\n"
+             "                put_uint(size);\n"
+             "                put(\"\\\" duration_seconds=\\\"\");\n"
+             "                put_uint(gettime());\n"
+             "                put(\"\\\" rules_fired=\\\"\");\n"
+             "                put_uint(rules_fired_local);\n"
+             "                put(\"\\\" queue_size=\\\"\");\n"
+             "                put_uint(queue_size);\n"
+             "                put(\"\\\" thread_id=\\\"\");\n"
+             "                put_uint(thread_id);\n"
+             "                put(\"\\\"/>\\n\");\n"
+             "              } else {\n"
+             "                put(\"\\t \");\n"
+             "                if (thread_count > 1) {\n"
+             "                  put(\"thread \");\n"
+             "                  put_uint(thread_id);\n"
+             "                  put(\": \");\n"
+             "                }\n"
+             "                put_uint(size);\n"
+             "                put(\" states explored in \");\n"
+             "                put_uint(gettime());\n"
+             "                put(\"s, with \");\n"
+             "                put_uint(rules_fired_local);\n"
+             "                put(\" rules fired and \");\n"
+             "                put(queue_size > last_queue_size ? "
+             "yellow() : green());\n"
+             "                put_uint(queue_size);\n"
+             "                put(reset());\n"
+             "                put(\" states in the queue.\\n\");\n"
+             "              }\n"
+             "              funlockfile(stdout);\n"
+             "              last_queue_size = queue_size;\n"
+             "            }\n"
+             "\n"
+             "            if (thread_count > 1 && thread_id == 0 && "
+             "phase == WARMUP && queue_size > 20) {\n"
+             "              start_secondary_threads();\n"
+             "              phase = RUN;\n"
+             "            }\n"
+             "\n"
+             "#if BOUND > 0\n"
+             "            }\n"
+             "#endif\n"
+             "          } else {\n"
+             "            state_free(n);\n"
+             "          }\n"
+             "        } else {\n"
+             "          state_free(n);\n"
+             "        }\n"
+             "      } while (0);\n"
+             "      rule_taken++;\n";
+
+      // close the quantifier loops
+      for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+           it++)
+        generate_quantifier_footer(out, *it);
+
+      // close this rule's scope
+      out << "}\n";
+
+      ++index;
     }
     out << "    /* If we did not toggle 'possible_deadlock' off by this point, "
            "we\n"
@@ -1122,8 +1173,340 @@ void generate_model(std::ostream &out, const Model &m) {
            "}\n\n";
   }
 
+  // Write random walk simulation and swarm verification logic
+  {
+    // emit code for each start state or simple rule, surrounded by its
+    // quantifier loops and followed by an increment of the rule counter,
+    // optionally as cases of a switch on the rule's index
+    auto for_each = [&](bool start, const std::string &indent,
+                        const std::function<void(size_t, const Rule &)> &body,
+                        bool as_cases = false) {
+      size_t index = 0;
+      for (const Ptr<Rule> &r : start ? flat.start_states : flat.rules) {
+        if (as_cases)
+          out << indent << "case " << index << ":\n";
+
+        // open a scope so we do not have to think about name collisions
+        out << indent << "{\n";
+
+        for (const Quantifier &q : r->quantifiers)
+          generate_quantifier_header(out, q);
+
+        body(index, *r);
+        out << indent << "  rule_taken++;\n";
+
+        // close the quantifier loops
+        for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+             it++)
+          generate_quantifier_footer(out, *it);
+
+        // close this rule's scope
+        out << indent << "}\n";
+
+        if (as_cases)
+          out << indent << "break;\n";
+
+        ++index;
+      }
+    };
+
+    // emit the arguments for the given rule's quantifiers
+    auto args = [&](const Rule &r) {
+      std::string a;
+      for (const Quantifier &q : r.quantifiers)
+        a += ", ru_" + q.name;
+      return a;
+    };
+
+    out << "EXPORT void simulate(void) {\n"
+           "\n"
+           "  /* Used when writing to quantifier variables. */\n"
+           "  static const char *rule_name __attribute__((unused)) = NULL;\n"
+           "\n"
+           "  rng_init();\n"
+           "\n"
+           "  const struct state *s = NULL;\n"
+           "  uint64_t rule_taken;\n"
+           "  uint64_t count;\n"
+           "  uint64_t choice;\n"
+           "\n"
+           "  /* choose a start state */\n"
+           "  rule_taken = 1;\n";
+    for_each(true, "  ", [&](size_t, const Rule &) {});
+    out << "  count = rule_taken - 1;\n"
+           "  choice = rng_below(count);\n"
+           "  rule_taken = 1;\n";
+    for_each(true, "  ", [&](size_t index, const Rule &r) {
+      out << "    if (rule_taken == choice + 1) {\n"
+             "      struct state *n = state_new();\n"
+             "      memset(n, 0, sizeof(*n));\n"
+             "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+             "      state_rule_taken_set(n, rule_taken);\n"
+             "#endif\n"
+             "      if (!startstate"
+          << index << "(n" << args(r)
+          << ")) {\n"
+             "        /* startstate triggered an error */\n"
+             "        goto done;\n"
+             "      }\n"
+             "      state_reset_dead(n);\n"
+             "      state_canonicalise(n);\n"
+             "      if (!check_assumptions(n)) {\n"
+             "        /* assumption violated */\n"
+             "        goto done;\n"
+             "      }\n"
+             "      if (!check_invariants(n)) {\n"
+             "        /* invariant violated */\n"
+             "        goto done;\n"
+             "      }\n"
+             "      s = n;\n"
+             "      goto walk;\n"
+             "    }\n";
+    });
+    out << "  ASSERT(!\"start state not found\");\n"
+           "\n"
+           "walk:\n"
+           "  for (uint64_t step = 0;; step++) {\n"
+           "\n"
+           "    states_visited_local++;\n"
+           "\n"
+           "    if (step == SIMULATE_STEPS) {\n"
+           "      break;\n"
+           "    }\n"
+           "\n"
+           "    if (THREADS > 1 && __atomic_load_n(&error_count,\n"
+           "        __ATOMIC_ACQUIRE) >= max_errors) {\n"
+           "      /* Another thread found an error. */\n"
+           "      break;\n"
+           "    }\n"
+           "\n"
+           "#if BOUND > 0\n"
+           "    if (state_bound_get(s) >= BOUND) {\n"
+           "      break;\n"
+           "    }\n"
+           "#endif\n"
+           "\n"
+           "    /* Guards only read the state, so they can all be evaluated\n"
+           "     * on the one successor-to-be, which saves duplicating the\n"
+           "     * state for every rule.\n"
+           "     */\n"
+           "    struct state *g = state_dup(s);\n"
+           "\n"
+           "    /* count the enabled transitions */\n"
+           "    count = 0;\n"
+           "    rule_taken = 1;\n";
+    for_each(false, "    ", [&](size_t index, const Rule &r) {
+      out << "      {\n"
+             "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+             "        state_rule_taken_set(g, rule_taken);\n"
+             "#endif\n"
+             "        int enabled = guard"
+          << index << "(g" << args(r)
+          << ");\n"
+             "        if (enabled == -1) {\n"
+             "          /* error() was called */\n"
+             "          goto done;\n"
+             "        } else if (enabled == 1) {\n"
+             "          count++;\n"
+             "        }\n"
+             "      }\n";
+    });
+    out << "\n"
+           "    /* Without any enabled transition, we have a deadlock. We\n"
+           "     * cannot tell whether every enabled transition stutters\n"
+           "     * without firing them all, so this is detected as for\n"
+           "     * --deadlock-detection stuck.\n"
+           "     */\n"
+           "    if (count == 0) {\n"
+           "      state_free(g);\n"
+           "      if (DEADLOCK_DETECTION != DEADLOCK_DETECTION_OFF) {\n"
+           "        deadlock(s);\n"
+           "      }\n"
+           "      break;\n"
+           "    }\n"
+           "\n"
+           "    /* choose and fire one of them */\n"
+           "    choice = rng_below(count);\n"
+           "    count = 0;\n"
+           "    rule_taken = 1;\n";
+    for_each(false, "    ", [&](size_t index, const Rule &r) {
+      out << "      {\n"
+             "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+             "        state_rule_taken_set(g, rule_taken);\n"
+             "#endif\n"
+             "        if (guard"
+          << index << "(g" << args(r)
+          << ") == 1 && count++ == choice) {\n"
+             "          struct state *n = g;\n"
+             "          if (!rule"
+          << index << "(n" << args(r)
+          << ")) {\n"
+             "            /* this rule triggered an error */\n"
+             "            goto done;\n"
+             "          }\n"
+             "          state_reset_dead(n);\n"
+             "          rules_fired_local++;\n"
+             "          state_canonicalise(n);\n"
+             "          if (!check_assumptions(n)) {\n"
+             "            /* assumption violated */\n"
+             "            goto done;\n"
+             "          }\n"
+             "          if (!check_invariants(n)) {\n"
+             "            /* invariant violated */\n"
+             "            goto done;\n"
+             "          }\n"
+             "          s = n;\n"
+             "          goto next;\n"
+             "        }\n"
+             "      }\n";
+    });
+    out << "    ASSERT(!\"enabled transition not found\");\n"
+           "\n"
+           "  next:;\n"
+           "  }\n"
+           "\n"
+           "done:\n"
+           "  exit_with(EXIT_SUCCESS);\n"
+           "}\n\n";
+
+    // the number of each rule's first transition, which depends only on the
+    // quantifier ranges of the rules before it
+    out << "static const uint64_t swarm_rule_base[] = {\n";
+    {
+      mpz_class base = 1;
+      for (const Ptr<Rule> &r : flat.rules) {
+        out << "  " << base << "ull,\n";
+        mpz_class inc = 1;
+        for (const Quantifier &q : r->quantifiers)
+          inc *= q.count();
+        base += inc;
+      }
+      out << "  " << base << "ull,\n";
+    }
+    out << "};\n"
+           "\n"
+           "EXPORT size_t swarm_start(void) {\n"
+           "\n"
+           "  /* Used when writing to quantifier variables. */\n"
+           "  static const char *rule_name __attribute__((unused)) = NULL;\n"
+           "\n"
+           "  /* Define the state variable because the code emitted for\n"
+           "   * quantifiers expects it. It does not need a non-NULL value.\n"
+           "   */\n"
+           "  const struct state *s __attribute__((unused)) = NULL;\n"
+           "\n"
+           "  /* add the start states to the current frame */\n"
+           "  uint64_t rule_taken = 1;\n";
+    for_each(true, "  ", [&](size_t index, const Rule &r) {
+      out << "    do {\n"
+             "      struct state *n = state_new();\n"
+             "      memset(n, 0, sizeof(*n));\n"
+             "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+             "      state_rule_taken_set(n, rule_taken);\n"
+             "#endif\n"
+             "      if (!startstate"
+          << index << "(n" << args(r)
+          << ")) {\n"
+             "        /* startstate triggered an error */\n"
+             "        state_free(n);\n"
+             "        break;\n"
+             "      }\n"
+             "      state_reset_dead(n);\n"
+             "      state_canonicalise(n);\n"
+             "      if (!check_assumptions(n)) {\n"
+             "        /* assumption violated */\n"
+             "        state_free(n);\n"
+             "        break;\n"
+             "      }\n"
+             "      if (!check_invariants(n)) {\n"
+             "        /* invariant violated */\n"
+             "        state_free(n);\n"
+             "        break;\n"
+             "      }\n"
+             "      if (bitstate_insert(n)) {\n"
+             "        swarm_push(n);\n"
+             "      } else {\n"
+             "        state_free(n);\n"
+             "      }\n"
+             "    } while (0);\n";
+    });
+    out << "\n"
+           "  return "
+        << flat.rules.size()
+        << ";\n"
+           "}\n"
+           "\n"
+           "EXPORT void swarm_expand(const struct state *NONNULL s, size_t "
+           "rule,\n"
+           "                         bool *NONNULL possible_deadlock) {\n"
+           "\n"
+           "  /* Used when writing to quantifier variables. */\n"
+           "  static const char *rule_name __attribute__((unused)) = NULL;\n"
+           "\n"
+           "  (void)s;\n"
+           "  (void)possible_deadlock;\n"
+           "\n"
+           "  uint64_t rule_taken = swarm_rule_base[rule];\n"
+           "  switch (rule) {\n";
+    for_each(
+        false, "  ",
+        [&](size_t index, const Rule &r) {
+          out << "    do {\n"
+                 "      struct state *n = state_dup(s);\n"
+                 "#if COUNTEREXAMPLE_TRACE != CEX_OFF\n"
+                 "      state_rule_taken_set(n, rule_taken);\n"
+                 "#endif\n"
+                 "      int g = guard"
+              << index << "(n" << args(r)
+              << ");\n"
+                 "      if (g != 1) {\n"
+                 "        /* disabled, or error() was called */\n"
+                 "        state_free(n);\n"
+                 "        break;\n"
+                 "      }\n"
+                 "      if (!rule"
+              << index << "(n" << args(r)
+              << ")) {\n"
+                 "        /* this rule triggered an error */\n"
+                 "        state_free(n);\n"
+                 "        break;\n"
+                 "      }\n"
+                 "      state_reset_dead(n);\n"
+                 "      rules_fired_local++;\n"
+                 "      if (DEADLOCK_DETECTION != "
+                 "DEADLOCK_DETECTION_STUTTERING || !state_eq(s, n)) {\n"
+                 "        *possible_deadlock = false;\n"
+                 "      }\n"
+                 "      state_canonicalise(n);\n"
+                 "      if (!check_assumptions(n)) {\n"
+                 "        /* assumption violated */\n"
+                 "        state_free(n);\n"
+                 "        break;\n"
+                 "      }\n"
+                 "      if (!check_invariants(n)) {\n"
+                 "        /* invariant violated */\n"
+                 "        state_free(n);\n"
+                 "        break;\n"
+                 "      }\n"
+                 "      if (bitstate_insert(n)) {\n"
+                 "        swarm_push(n);\n"
+                 "      } else {\n"
+                 "        state_free(n);\n"
+                 "      }\n"
+                 "    } while (0);\n";
+        },
+        true);
+    out << "  }\n"
+           "}\n\n";
+  }
+
+}
+
+static void generate_printing(std::ostream &out, const Model &m,
+                              const FlatRules &flat) {
+
   // Write a function to print the state.
-  out << "static void state_print(const struct state *previous, const struct "
+  out << "EXPORT void state_print(const struct state *previous, const struct "
          "state *NONNULL s) {\n";
   /* Output the state variable handles so we can reference them within this
    * function.
@@ -1142,7 +1525,7 @@ void generate_model(std::ostream &out, const Model &m) {
   out << "}\n\n";
 
   // Write a function to print state transitions.
-  out << "static void print_transition(const struct state *NONNULL s "
+  out << "EXPORT void print_transition(const struct state *NONNULL s "
          "__attribute__((unused))) {\n"
          "  ASSERT(s != NULL);\n"
          "  static const char *rule_name __attribute__((unused)) = NULL;\n"
@@ -1159,160 +1542,148 @@ void generate_model(std::ostream &out, const Model &m) {
     mpz_class base = 1;
 
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-        for (const Ptr<Rule> &r : rs) {
-          if (isa<StartState>(r)) {
-
-            assert(index < start_index &&
-                   "miscounted start states during model generation");
-
-            // set up quantifiers
-            out << "    {\n";
-            for (const Quantifier &q : r->quantifiers)
-              generate_quantifier_header(out, q);
-
-            out << "  if (state_rule_taken_get(s) == rule_taken) {\n"
-                   "    if (MACHINE_READABLE_OUTPUT) {\n"
-                   "      put(\"<transition>\");\n"
-                   "      xml_printf(\"Startstate "
-                << rule_name_string(*r, index)
-                << "\");\n"
-                   "    } else {\n"
-                   "      put(\"Startstate "
-                << rule_name_string(*r, index)
-                << "\");\n"
-                   "    }\n";
-            {
-              size_t i = 0;
-              for (const Quantifier &q : r->quantifiers) {
-                out << "    {\n"
-                       "      value_t v = (value_t)((rule_taken - "
-                    << base << ") / (1";
-                size_t j = r->quantifiers.size() - 1;
-                for (auto it = r->quantifiers.rbegin();
-                     it != r->quantifiers.rend(); it++) {
-                  if (i == j)
-                    break;
-                  out << " * " << it->count();
-                  j--;
-                }
-                out << ") % " << q.count() << ") + " << q.lower_bound()
-                    << ";\n"
-
-                       "      if (MACHINE_READABLE_OUTPUT) {\n"
-                       "        put(\"<parameter name=\\\"\");\n"
-                       "        xml_printf(\""
-                    << q.name
-                    << "\");\n"
-                       "        put(\"\\\">\");\n"
-                       "      } else {\n"
-                       "        put(\", "
-                    << q.name
-                    << ": \");\n"
-                       "      }\n";
-
-                const Ptr<TypeExpr> t = q.type->resolve();
-                if (auto e = dynamic_cast<const Enum *>(t.get())) {
-                  size_t member_index = 0;
-                  for (const std::pair<std::string, location> &member :
-                       e->members) {
-                    out << "      ";
-                    if (member_index > 0)
-                      out << "else ";
-                    out << "if (v == VALUE_C(" << member_index
-                        << ")) {\n"
-                           "        if (MACHINE_READABLE_OUTPUT) {\n"
-                           "          xml_printf(\""
-                        << member.first
-                        << "\");\n"
-                           "        } else {\n"
-                           "          put(\""
-                        << member.first
-                        << "\");\n"
-                           "        }\n"
-                           "      }\n";
-                    member_index++;
-                  }
-                  out << "      else {\n"
-                         "        ASSERT(!\"illegal value for "
-                      << q.name
-                      << "\");\n"
-                         "      }\n";
-                } else if (isa<Scalarset>(t)) {
-
-                  // figure out if this is a named scalarset (i.e. ony eligible
-                  // for symmetry reduction)
-                  auto id = dynamic_cast<const TypeExprID *>(q.type.get());
-
-                  if (id != nullptr) {
-
-                    // remove any levels of indirection (TypeExprIDs of
-                    // TypeExprIDs)
-                    while (auto inner = dynamic_cast<const TypeExprID *>(
-                               id->referent->value.get()))
-                      id = inner;
-
-                    // We do not need to do any schedule reversal because this
-                    // is a start state. I.e. the implicit schedule under which
-                    // this parameter was chosen is the identity permutation.
-
-                    // dump the symbolic value of this parameter
-                    out << "        if (USE_SCALARSET_SCHEDULES) {\n"
-                           "          put(\""
-                        << escape(id->name)
-                        << "_\");\n"
-                           "          put_val(v);\n"
-                           "        } else {\n"
-                           "          put_val(v);\n"
-                           "        }\n";
-
-                  } else {
-                    // this scalarset seems not eligible for symmetry reduction
-                    // (declared inline rather than as a TypeDecl), so fall back
-                    // on just printing its value
-                    out << "      put_val(v);\n";
-                  }
-
-                } else {
-                  out << "      put_val(v);\n";
-                }
-
-                out << "      if (MACHINE_READABLE_OUTPUT) {\n"
-                       "        put(\"</parameter>\");\n"
-                       "      }\n"
-                       "    }\n";
-                i++;
-              }
+    for (const Ptr<Rule> &r : flat.start_states) {
+      // set up quantifiers
+      out << "    {\n";
+      for (const Quantifier &q : r->quantifiers)
+        generate_quantifier_header(out, q);
+
+      out << "  if (state_rule_taken_get(s) == rule_taken) {\n"
+             "    if (machine_readable_output) {\n"
+             "      put(\"<transition>\");\n"
+             "      xml_printf(\"Startstate "
+          << rule_name_string(*r, index)
+          << "\");\n"
+             "    } else {\n"
+             "      put(\"Startstate "
+          << rule_name_string(*r, index)
+          << "\");\n"
+             "    }\n";
+      {
+        size_t i = 0;
+        for (const Quantifier &q : r->quantifiers) {
+          out << "    {\n"
+                 "      value_t v = (value_t)((rule_taken - "
+              << base << ") / (1";
+          size_t j = r->quantifiers.size() - 1;
+          for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+               it++) {
+            if (i == j)
+              break;
+            out << " * " << it->count();
+            j--;
+          }
+          out << ") % " << q.count() << ") + " << q.lower_bound()
+              << ";\n"
+
+                 "      if (machine_readable_output) {\n"
+                 "        put(\"<parameter name=\\\"\");\n"
+                 "        xml_printf(\""
+              << q.name
+              << "\");\n"
+                 "        put(\"\\\">\");\n"
+                 "      } else {\n"
+                 "        put(\", "
+              << q.name
+              << ": \");\n"
+                 "      }\n";
+
+          const Ptr<TypeExpr> t = q.type->resolve();
+          if (auto e = dynamic_cast<const Enum *>(t.get())) {
+            size_t member_index = 0;
+            for (const std::pair<std::string, location> &member : e->members) {
+              out << "      ";
+              if (member_index > 0)
+                out << "else ";
+              out << "if (v == VALUE_C(" << member_index
+                  << ")) {\n"
+                     "        if (machine_readable_output) {\n"
+                     "          xml_printf(\""
+                  << member.first
+                  << "\");\n"
+                     "        } else {\n"
+                     "          put(\""
+                  << member.first
+                  << "\");\n"
+                     "        }\n"
+                     "      }\n";
+              member_index++;
             }
-            out << "    if (MACHINE_READABLE_OUTPUT) {\n"
-                   "      put(\"</transition>\\n\");\n"
-                   "    } else {\n"
-                   "      put(\" fired.\\n\");\n"
-                   "    }\n"
-                   "    return;\n"
-                   "  }\n";
-
-            out << "      rule_taken++;\n";
-
-            // close the quantifier loops
-            for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
-                 it++)
-              generate_quantifier_footer(out, *it);
-            out << "    }\n";
-
-            // update base for future comparison against rule_taken
-            mpz_class inc = 1;
-            for (const Quantifier &q : r->quantifiers) {
-              inc *= q.count();
+            out << "      else {\n"
+                   "        ASSERT(!\"illegal value for "
+                << q.name
+                << "\");\n"
+                   "      }\n";
+          } else if (isa<Scalarset>(t)) {
+
+            // figure out if this is a named scalarset (i.e. ony eligible
+            // for symmetry reduction)
+            auto id = dynamic_cast<const TypeExprID *>(q.type.get());
+
+            if (id != nullptr) {
+
+              // remove any levels of indirection (TypeExprIDs of
+              // TypeExprIDs)
+              while (auto inner = dynamic_cast<const TypeExprID *>(
+                         id->referent->value.get()))
+                id = inner;
+
+              // We do not need to do any schedule reversal because this
+              // is a start state. I.e. the implicit schedule under which
+              // this parameter was chosen is the identity permutation.
+
+              // dump the symbolic value of this parameter
+              out << "        if (USE_SCALARSET_SCHEDULES) {\n"
+                     "          put(\""
+                  << escape(id->name)
+                  << "_\");\n"
+                     "          put_val(v);\n"
+                     "        } else {\n"
+                     "          put_val(v);\n"
+                     "        }\n";
+
+            } else {
+              // this scalarset seems not eligible for symmetry reduction
+              // (declared inline rather than as a TypeDecl), so fall back
+              // on just printing its value
+              out << "      put_val(v);\n";
             }
-            base += inc;
 
-            ++index;
+          } else {
+            out << "      put_val(v);\n";
           }
+
+          out << "      if (machine_readable_output) {\n"
+                 "        put(\"</parameter>\");\n"
+                 "      }\n"
+                 "    }\n";
+          i++;
         }
       }
+      out << "    if (machine_readable_output) {\n"
+             "      put(\"</transition>\\n\");\n"
+             "    } else {\n"
+             "      put(\" fired.\\n\");\n"
+             "    }\n"
+             "    return;\n"
+             "  }\n";
+
+      out << "      rule_taken++;\n";
+
+      // close the quantifier loops
+      for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+           it++)
+        generate_quantifier_footer(out, *it);
+      out << "    }\n";
+
+      // update base for future comparison against rule_taken
+      mpz_class inc = 1;
+      for (const Quantifier &q : r->quantifiers) {
+        inc *= q.count();
+      }
+      base += inc;
+
+      ++index;
     }
   }
 
@@ -1323,199 +1694,186 @@ void generate_model(std::ostream &out, const Model &m) {
     mpz_class base = 1;
 
     size_t index = 0;
-    for (const Ptr<Node> &c : m.children) {
-      if (auto rule = dynamic_cast<const Rule *>(c.get())) {
-        const std::vector<Ptr<Rule>> rs = rule->flatten();
-        for (const Ptr<Rule> &r : rs) {
-          if (isa<SimpleRule>(r)) {
-
-            assert(index < rule_index &&
-                   "miscounted simple rules during model generation");
-
-            // set up quantifiers
-            out << "    {\n";
-            for (const Quantifier &q : r->quantifiers)
-              generate_quantifier_header(out, q);
-
-            out << "  if (state_rule_taken_get(s) == rule_taken) {\n"
-                   "    if (MACHINE_READABLE_OUTPUT) {\n"
-                   "      put(\"<transition>\");\n"
-                   "      xml_printf(\"Rule "
-                << rule_name_string(*r, index)
-                << "\");\n"
-                   "    } else {\n"
-                   "      put(\"Rule "
-                << rule_name_string(*r, index)
-                << "\");\n"
-                   "    }\n";
-            {
-              size_t i = 0;
-              for (const Quantifier &q : r->quantifiers) {
-                out << "    {\n"
-                       "      value_t v = (value_t)((rule_taken - "
-                    << base << ") / (1";
-                size_t j = r->quantifiers.size() - 1;
-                for (auto it = r->quantifiers.rbegin();
-                     it != r->quantifiers.rend(); it++) {
-                  if (i == j)
-                    break;
-                  out << " * " << it->count();
-                  j--;
-                }
-                out << ") % " << q.count() << ") + " << q.lower_bound()
-                    << ";\n"
-
-                       "      if (MACHINE_READABLE_OUTPUT) {\n"
-                       "        put(\"<parameter name=\\\"\");\n"
-                       "        xml_printf(\""
-                    << q.name
-                    << "\");\n"
-                       "        put(\"\\\">\");\n"
-                       "      } else {\n"
-                       "        put(\", "
-                    << q.name
-                    << ": \");\n"
-                       "      }\n";
-
-                const Ptr<TypeExpr> t = q.type->resolve();
-                if (auto e = dynamic_cast<const Enum *>(t.get())) {
-                  size_t member_index = 0;
-                  for (const std::pair<std::string, location> &member :
-                       e->members) {
-                    out << "      ";
-                    if (member_index > 0)
-                      out << "else ";
-                    out << "if (v == VALUE_C(" << member_index
-                        << ")) {\n"
-                           "        if (MACHINE_READABLE_OUTPUT) {\n"
-                           "          xml_printf(\""
-                        << member.first
-                        << "\");\n"
-                           "        } else {\n"
-                           "          put(\""
-                        << member.first
-                        << "\");\n"
-                           "        }\n"
-                           "      }\n";
-                    member_index++;
-                  }
-                  out << "      else {\n"
-                         "        ASSERT(!\"illegal value for "
-                      << q.name
-                      << "\");\n"
-                         "      }\n";
-                } else if (auto s = dynamic_cast<const Scalarset *>(t.get())) {
-
-                  // open a scope to contain the schedule computation variables
-                  out << "      {\n";
-
-                  const std::string b = "((size_t)" +
-                                        s->bound->constant_fold().get_str() +
-                                        "ull)";
-
-                  // figure out if this is a named scalarset (i.e. ony eligible
-                  // for symmetry reduction)
-                  auto id = dynamic_cast<const TypeExprID *>(q.type.get());
-
-                  if (id != nullptr) {
-
-                    // remove any levels of indirection (TypeExprIDs of
-                    // TypeExprIDs)
-                    while (auto inner = dynamic_cast<const TypeExprID *>(
-                               id->referent->value.get()))
-                      id = inner;
-
-                    // generate schedule retrieval
-                    out << "        size_t schedule[" << b
-                        << "];\n"
-                           "        /* setup a default identity mapping for "
-                           "when\n"
-                           "         * symmetry reduction is off\n"
-                           "         */\n"
-                           "        for (size_t i = 0; i < "
-                        << b
-                        << "; ++i) {\n"
-                           "          schedule[i] = i;\n"
-                           "        }\n"
-                           "        if (USE_SCALARSET_SCHEDULES) {\n"
-                           // note that we read from the *previous* state’s
-                           // schedule here because that is what this value is
-                           // relative to
-                           "          size_t index = schedule_read_"
-                        << id->name
-                        << "(state_previous_get(s));\n"
-                           "          size_t stack["
-                        << b
-                        << "];\n"
-                           "          index_to_permutation(index, schedule, "
-                           "stack, "
-                        << b
-                        << ");\n"
-                           "        }\n";
-
-                    // map the parameter value through the retrieved permutation
-                    out << "        assert((size_t)v < " << b
-                        << " && \"illegal scalarset "
-                           " parameter recorded\");\n"
-                           "        v = (value_t)schedule[(size_t)v];\n";
-
-                    // dump the resulting value
-                    out << "        if (USE_SCALARSET_SCHEDULES) {\n"
-                           "          put(\""
-                        << escape(id->name)
-                        << "_\");\n"
-                           "          put_val(v);\n"
-                           "        } else {\n"
-                           "          put_val(v);\n"
-                           "        }\n";
-
-                  } else {
-                    // this scalarset seems not eligible for symmetry reduction
-                    // (declared inline rather than as a TypeDecl), so fall back
-                    // on just printing its value
-                    out << "      put_val(v);\n";
-                  }
-
-                  out << "}\n";
-
-                } else {
-                  out << "      put_val(v);\n";
-                }
-
-                out << "      if (MACHINE_READABLE_OUTPUT) {\n"
-                       "        put(\"</parameter>\");\n"
-                       "      }\n"
-                       "    }\n";
-                i++;
-              }
+    for (const Ptr<Rule> &r : flat.rules) {
+      // set up quantifiers
+      out << "    {\n";
+      for (const Quantifier &q : r->quantifiers)
+        generate_quantifier_header(out, q);
+
+      out << "  if (state_rule_taken_get(s) == rule_taken) {\n"
+             "    if (machine_readable_output) {\n"
+             "      put(\"<transition>\");\n"
+             "      xml_printf(\"Rule "
+          << rule_name_string(*r, index)
+          << "\");\n"
+             "    } else {\n"
+             "      put(\"Rule "
+          << rule_name_string(*r, index)
+          << "\");\n"
+             "    }\n";
+      {
+        size_t i = 0;
+        for (const Quantifier &q : r->quantifiers) {
+          out << "    {\n"
+                 "      value_t v = (value_t)((rule_taken - "
+              << base << ") / (1";
+          size_t j = r->quantifiers.size() - 1;
+          for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+               it++) {
+            if (i == j)
+              break;
+            out << " * " << it->count();
+            j--;
+          }
+          out << ") % " << q.count() << ") + " << q.lower_bound()
+              << ";\n"
+
+                 "      if (machine_readable_output) {\n"
+                 "        put(\"<parameter name=\\\"\");\n"
+                 "        xml_printf(\""
+              << q.name
+              << "\");\n"
+                 "        put(\"\\\">\");\n"
+                 "      } else {\n"
+                 "        put(\", "
+              << q.name
+              << ": \");\n"
+                 "      }\n";
+
+          const Ptr<TypeExpr> t = q.type->resolve();
+          if (auto e = dynamic_cast<const Enum *>(t.get())) {
+            size_t member_index = 0;
+            for (const std::pair<std::string, location> &member : e->members) {
+              out << "      ";
+              if (member_index > 0)
+                out << "else ";
+              out << "if (v == VALUE_C(" << member_index
+                  << ")) {\n"
+                     "        if (machine_readable_output) {\n"
+                     "          xml_printf(\""
+                  << member.first
+                  << "\");\n"
+                     "        } else {\n"
+                     "          put(\""
+                  << member.first
+                  << "\");\n"
+                     "        }\n"
+                     "      }\n";
+              member_index++;
             }
-            out << "    if (MACHINE_READABLE_OUTPUT) {\n"
-                   "      put(\"</transition>\\n\");\n"
-                   "    } else {\n"
-                   "      put(\" fired.\\n\");\n"
-                   "    }\n"
-                   "    return;\n"
-                   "  }\n";
-
-            out << "      rule_taken++;\n";
-
-            // Close the quantifier loops.
-            for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
-                 it++)
-              generate_quantifier_footer(out, *it);
-            out << "    }\n";
-
-            // update base for future comparison against rule_taken
-            mpz_class inc = 1;
-            for (const Quantifier &q : r->quantifiers) {
-              inc *= q.count();
+            out << "      else {\n"
+                   "        ASSERT(!\"illegal value for "
+                << q.name
+                << "\");\n"
+                   "      }\n";
+          } else if (auto s = dynamic_cast<const Scalarset *>(t.get())) {
+
+            // open a scope to contain the schedule computation variables
+            out << "      {\n";
+
+            const std::string b = "((size_t)" +
+                                  s->bound->constant_fold().get_str() + "ull)";
+
+            // figure out if this is a named scalarset (i.e. ony eligible
+            // for symmetry reduction)
+            auto id = dynamic_cast<const TypeExprID *>(q.type.get());
+
+            if (id != nullptr) {
+
+              // remove any levels of indirection (TypeExprIDs of
+              // TypeExprIDs)
+              while (auto inner = dynamic_cast<const TypeExprID *>(
+                         id->referent->value.get()))
+                id = inner;
+
+              // generate schedule retrieval
+              out << "        size_t schedule[" << b
+                  << "];\n"
+                     "        /* setup a default identity mapping for "
+                     "when\n"
+                     "         * symmetry reduction is off\n"
+                     "         */\n"
+                     "        for (size_t i = 0; i < "
+                  << b
+                  << "; ++i) {\n"
+                     "          schedule[i] = i;\n"
+                     "        }\n"
+                     "        if (USE_SCALARSET_SCHEDULES) {\n"
+                     // note that we read from the *previous* state’s
+                     // schedule here because that is what this value is
+                     // relative to
+                     "          size_t index = schedule_read_"
+                  << id->name
+                  << "(state_previous_get(s));\n"
+                     "          size_t stack["
+                  << b
+                  << "];\n"
+                     "          index_to_permutation(index, schedule, "
+                     "stack, "
+                  << b
+                  << ");\n"
+                     "        }\n";
+
+              // map the parameter value through the retrieved permutation
+              out << "        assert((size_t)v < " << b
+                  << " && \"illegal scalarset "
+                     " parameter recorded\");\n"
+                     "        v = (value_t)schedule[(size_t)v];\n";
+
+              // dump the resulting value
+              out << "        if (USE_SCALARSET_SCHEDULES) {\n"
+                     "          put(\""
+                  << escape(id->name)
+                  << "_\");\n"
+                     "          put_val(v);\n"
+                     "        } else {\n"
+                     "          put_val(v);\n"
+                     "        }\n";
+
+            } else {
+              // this scalarset seems not eligible for symmetry reduction
+              // (declared inline rather than as a TypeDecl), so fall back
+              // on just printing its value
+              out << "      put_val(v);\n";
             }
-            base += inc;
 
-            ++index;
+            out << "}\n";
+
+          } else {
+            out << "      put_val(v);\n";
           }
+
+          out << "      if (machine_readable_output) {\n"
+                 "        put(\"</parameter>\");\n"
+                 "      }\n"
+                 "    }\n";
+          i++;
         }
       }
+      out << "    if (machine_readable_output) {\n"
+             "      put(\"</transition>\\n\");\n"
+             "    } else {\n"
+             "      put(\" fired.\\n\");\n"
+             "    }\n"
+             "    return;\n"
+             "  }\n";
+
+      out << "      rule_taken++;\n";
+
+      // Close the quantifier loops.
+      for (auto it = r->quantifiers.rbegin(); it != r->quantifiers.rend();
+           it++)
+        generate_quantifier_footer(out, *it);
+      out << "    }\n";
+
+      // update base for future comparison against rule_taken
+      mpz_class inc = 1;
+      for (const Quantifier &q : r->quantifiers) {
+        inc *= q.count();
+      }
+      base += inc;
+
+      ++index;
     }
   }
 
@@ -1530,7 +1888,7 @@ void generate_model(std::ostream &out, const Model &m) {
          "}\n\n";
 
   // Generate a function used during debugging
-  out << "static void state_print_field_offsets(void) {\n"
+  out << "EXPORT void state_print_field_offsets(void) {\n"
          "  put(\"\t* state struct is \");\n"
          "  put_uint(__alignof__(struct state));\n"
          "  put(\"-byte aligned\\n\");\n";
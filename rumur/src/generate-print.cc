@@ -334,7 +334,7 @@ public:
          << ");\n"
          << "  }\n"
          << "  if (previous == NULL || v != v_previous) {\n"
-         << "    if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+         << "    if (" << support_xml << " && machine_readable_output) {\n"
          << "      put(\"<state_component name=\\\"\");\n"
          << "      " << prefix.str() << ";\n"
          << "      put(\"\\\" value=\\\"\");\n"
@@ -353,7 +353,7 @@ public:
     *out << "    } else {\n"
          << "      assert(!\"illegal value for enum\");\n"
          << "    }\n"
-         << "    if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+         << "    if (" << support_xml << " && machine_readable_output) {\n"
          << "      put(\"\\\"/>\");\n"
          << "    }\n"
          << "    put(\"\\n\");\n"
@@ -376,7 +376,7 @@ public:
          << ");\n"
          << "  }\n"
          << "  if (previous == NULL || v != v_previous) {\n"
-         << "    if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+         << "    if (" << support_xml << " && machine_readable_output) {\n"
          << "      put(\"<state_component name=\\\"\");\n"
          << "      " << prefix.str() << ";\n"
          << "      put(\"\\\" value=\\\"\");\n"
@@ -389,7 +389,7 @@ public:
          << "    } else {\n"
          << "      put_val(decode_value(" << lb << ", " << ub << ", v));\n"
          << "    }\n"
-         << "    if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+         << "    if (" << support_xml << " && machine_readable_output) {\n"
          << "      put(\"\\\"/>\");\n"
          << "    }\n"
          << "    put(\"\\n\");\n"
@@ -454,7 +454,7 @@ public:
 
     *out << "  }\n"
          << "  if (previous == NULL || v != v_previous) {\n"
-         << "    if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+         << "    if (" << support_xml << " && machine_readable_output) {\n"
          << "      put(\"<state_component name=\\\"\");\n"
          << "      " << prefix.str() << ";\n"
          << "      put(\"\\\" value=\\\"\");\n"
@@ -483,7 +483,7 @@ public:
            << "      size_t stack[" << bound << "];\n"
            << "      index_to_permutation(index, schedule, stack, " << bound
            << ");\n"
-           << "      if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+           << "      if (" << support_xml << " && machine_readable_output) {\n"
            << "        xml_printf(\"" << escape(schedule_type->name) << "\");\n"
            << "      } else {\n"
            << "        put(\"" << escape(schedule_type->name) << "\");\n"
@@ -498,7 +498,7 @@ public:
     *out << "    } else {\n"
          << "      put_val(v - 1);\n"
          << "    }\n"
-         << "    if (" << support_xml << " && MACHINE_READABLE_OUTPUT) {\n"
+         << "    if (" << support_xml << " && machine_readable_output) {\n"
          << "      put(\"\\\"/>\");\n"
          << "    }\n"
          << "    put(\"\\n\");\n"
@@ -1,3 +1,4 @@
+#include "../../common/isa.h"
 #include "generate.h"
 #include <cstddef>
 #include <iostream>
@@ -8,3 +9,73 @@ using namespace rumur;
 void generate_property(std::ostream &out, const Property &p) {
   generate_rvalue(out, *p.expr);
 }
+
+// can we compute a numeric distance between the operands of this comparison?
+static bool is_numeric(const BinaryExpr &e) {
+  return e.lhs->type()->is_simple() && e.rhs->type()->is_simple();
+}
+
+/* Generate a distance to the given expression evaluating to the given value.
+ * Conjunctions sum the distances to their operands and disjunctions take the
+ * minimum, so that e.g. x = 20 & y = 20 is closer to true the closer both x and
+ * y are to 20. Expressions we cannot see inside are 0 or 1.
+ */
+static void generate_distance(std::ostream &out, const Expr &e, bool want) {
+
+  if (auto n = dynamic_cast<const Not *>(&e)) {
+    generate_distance(out, *n->rhs, !want);
+    return;
+  }
+
+  if (isa<And>(&e) || isa<Or>(&e) || isa<Implication>(&e)) {
+    auto b = dynamic_cast<const BinaryExpr *>(&e);
+    // a -> b is equivalent to !a | b
+    bool lhs_want = isa<Implication>(&e) ? !want : want;
+    bool conjunction = isa<And>(&e) == want;
+    out << (conjunction ? "distance_add(" : "distance_min(");
+    generate_distance(out, *b->lhs, lhs_want);
+    out << ", ";
+    generate_distance(out, *b->rhs, want);
+    out << ")";
+    return;
+  }
+
+  if (auto b = dynamic_cast<const BinaryExpr *>(&e)) {
+    if ((isa<Eq>(&e) || isa<Neq>(&e)) && is_numeric(*b)) {
+      bool eq = isa<Eq>(&e) == want;
+      out << (eq ? "distance_eq(" : "distance_neq(") << "(";
+      generate_rvalue(out, *b->lhs);
+      out << "), (";
+      generate_rvalue(out, *b->rhs);
+      out << "))";
+      return;
+    }
+
+    if (isa<Lt>(&e) || isa<Leq>(&e) || isa<Gt>(&e) || isa<Geq>(&e)) {
+      // normalise to a < b or a <= b, where the negation of a < b is b <= a
+      bool swap = isa<Gt>(&e) || isa<Geq>(&e);
+      bool strict = isa<Lt>(&e) || isa<Gt>(&e);
+      if (!want) {
+        swap = !swap;
+        strict = !strict;
+      }
+      const Expr &lhs = swap ? *b->rhs : *b->lhs;
+      const Expr &rhs = swap ? *b->lhs : *b->rhs;
+      out << (strict ? "distance_lt(" : "distance_leq(") << "(";
+      generate_rvalue(out, lhs);
+      out << "), (";
+      generate_rvalue(out, rhs);
+      out << "))";
+      return;
+    }
+  }
+
+  out << "((";
+  generate_rvalue(out, e);
+  out << ") ? UINT64_C(" << (want ? 0 : 1) << ") : UINT64_C("
+      << (want ? 1 : 0) << "))";
+}
+
+void generate_distance(std::ostream &out, const Property &p) {
+  generate_distance(out, *p.expr, false);
+}
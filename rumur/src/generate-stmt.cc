@@ -1,6 +1,7 @@
 #include "../../common/escape.h"
 #include "../../common/isa.h"
 #include "generate.h"
+#include "interval-analysis.h"
 #include "options.h"
 #include "utils.h"
 #include <cassert>
@@ -88,9 +89,11 @@ class Generator : public ConstStmtTraversal {
 
 private:
   std::ostream *out;
+  bool in_function; // are we generating the body of a function/procedure?
 
 public:
-  Generator(std::ostream &o) : out(&o) {}
+  Generator(std::ostream &o, bool in_function_)
+      : out(&o), in_function(in_function_) {}
 
   void visit_aliasstmt(const AliasStmt &s) final {
     *out << "  {\n";
@@ -103,7 +106,7 @@ public:
 
     for (auto &st : s.body) {
       *out << "    ";
-      generate_stmt(*out, *st);
+      dispatch(*st);
       *out << ";\n";
     }
 
@@ -116,6 +119,19 @@ public:
       const std::string lb = s.lhs->type()->lower_bound().get_str();
       const std::string ub = s.lhs->type()->upper_bound().get_str();
 
+      // if the value being written is known to be within the bounds of the
+      // destination, we can skip the range check
+      if (is_in_range(*s.rhs, *s.lhs->type())) {
+        elided_checks++;
+        *out << "handle_write_unchecked(s, VALUE_C(" << lb << "), VALUE_C("
+             << ub << "), ";
+        generate_lvalue(*out, *s.lhs);
+        *out << ", ";
+        generate_rvalue(*out, *s.rhs);
+        *out << ")";
+        return;
+      }
+
       *out << "handle_write(" << to_C_string(s.loc) << ", rule_name, "
            << to_C_string(*s.lhs) << ", s, VALUE_C(" << lb << "), VALUE_C("
            << ub << "), ";
@@ -152,7 +168,7 @@ public:
     generate_quantifier_header(*out, s.quantifier);
     for (auto &st : s.body) {
       *out << "  ";
-      generate_stmt(*out, *st);
+      dispatch(*st);
       *out << ";\n";
     }
     generate_quantifier_footer(*out, s.quantifier);
@@ -197,7 +213,7 @@ public:
       }
       *out << " {\n";
       for (auto &st : c.body) {
-        generate_stmt(*out, *st);
+        dispatch(*st);
         *out << ";\n";
       }
       *out << "}\n";
@@ -231,11 +247,20 @@ public:
     case Property::ASSUMPTION:
       *out << "if (__builtin_expect(!";
       generate_property(*out, s.property);
-      *out << ", 0)) {\n"
-           << "  assert(JMP_BUF_NEEDED && \"longjmping without a setup "
-              "jmp_buf\");\n"
-           << "  siglongjmp(checkpoint, 1);\n"
-           << "}";
+      *out << ", 0)) {\n";
+      if (in_function) {
+        /* We have no way of signalling failure to our caller through the
+         * return value of a function, so we need to longjmp back to the
+         * containing rule.
+         */
+        *out << "  assert(JMP_BUF_NEEDED && \"longjmping without a setup "
+                "jmp_buf\");\n"
+             << "  siglongjmp(checkpoint, 1);\n";
+      } else {
+        // otherwise we can directly signal to the caller to discard this state
+        *out << "  return false;\n";
+      }
+      *out << "}";
       break;
 
     case Property::COVER:
@@ -382,7 +407,7 @@ public:
     *out << ") {\n";
     for (auto &st : s.body) {
       *out << "  ";
-      generate_stmt(*out, *st);
+      dispatch(*st);
       *out << ";\n";
     }
     *out << "}";
@@ -391,7 +416,7 @@ public:
 
 } // namespace
 
-void generate_stmt(std::ostream &out, const Stmt &s) {
-  Generator g(out);
+void generate_stmt(std::ostream &out, const Stmt &s, bool in_function) {
+  Generator g(out, in_function);
   g.dispatch(s);
 }
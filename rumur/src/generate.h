@@ -2,6 +2,7 @@
 
 #include "ValueType.h"
 #include <cstddef>
+#include <functional>
 #include <gmpxx.h>
 #include <memory>
 #include <rumur/rumur.h>
@@ -26,7 +27,47 @@ void generate_decl(std::ostream &out, const rumur::Decl &d);
 void generate_function(std::ostream &out, const rumur::Function &f,
                        const std::vector<const rumur::Decl *> &decls);
 
-void generate_model(std::ostream &out, const rumur::Model &m);
+// Destinations for the pieces of a generated model. When the checker is emitted
+// as a single file, these all refer to the same stream.
+struct ModelOutput {
+
+  // constants and functions from the model, visible to all the others
+  std::ostream &common;
+
+  // exploration logic
+  std::ostream &runtime;
+
+  // state and counterexample printing
+  std::ostream &print;
+
+  // start states, properties and rules, given their index among all the
+  // flattened rules of the model
+  std::function<std::ostream &(size_t)> rules;
+
+  // whether to write prototypes of the rules to the common stream, for use
+  // from other translation units
+  bool prototypes;
+};
+
+// The rules of a model after flattening (see `rumur::Rule::flatten`). This is
+// computed once and shared by all parts of checker generation. The position of
+// a rule within its kind's list is its index in the generated checker, e.g. the
+// `N` of `ruleN`, and is also how `rule_taken` is decoded when printing
+// counterexample traces.
+struct FlatRules {
+
+  // every flattened rule in model order, with the top level rule it came from
+  std::vector<std::pair<const rumur::Rule *, rumur::Ptr<rumur::Rule>>> all;
+
+  std::vector<rumur::Ptr<rumur::Rule>> start_states;
+  std::vector<rumur::Ptr<rumur::Rule>> properties;
+  std::vector<rumur::Ptr<rumur::Rule>> rules;
+
+  explicit FlatRules(const rumur::Model &m);
+};
+
+void generate_model(const ModelOutput &output, const rumur::Model &m,
+                    const FlatRules &flat);
 
 // Generate C code to print the value of the given type at the given handle.
 void generate_print(std::ostream &out, const rumur::TypeExpr &e,
@@ -35,12 +76,21 @@ void generate_print(std::ostream &out, const rumur::TypeExpr &e,
 
 void generate_property(std::ostream &out, const rumur::Property &p);
 
+/* Generate an expression for a heuristic estimate of how far the current state
+ * is from violating the given invariant. This is 0 when the invariant is
+ * violated.
+ */
+void generate_distance(std::ostream &out, const rumur::Property &p);
+
 void generate_lvalue(std::ostream &out, const rumur::Expr &e);
 void generate_rvalue(std::ostream &out, const rumur::Expr &e);
 
 void generate_quantifier_header(std::ostream &out, const rumur::Quantifier &q);
 void generate_quantifier_footer(std::ostream &out, const rumur::Quantifier &q);
 
-void generate_stmt(std::ostream &out, const rumur::Stmt &s);
+/* Generate a statement. The in_function parameter indicates whether this
+ * statement is within a function/procedure or within a rule/startstate.
+ */
+void generate_stmt(std::ostream &out, const rumur::Stmt &s, bool in_function);
 
 void generate_cover_array(std::ostream &out, const rumur::Model &model);
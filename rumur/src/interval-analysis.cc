@@ -0,0 +1,173 @@
+#include "interval-analysis.h"
+#include "../../common/isa.h"
+#include "ValueType.h"
+#include <cassert>
+#include <cstddef>
+#include <gmpxx.h>
+#include <rumur/rumur.h>
+
+using namespace rumur;
+
+unsigned long elided_checks;
+
+// bounds of value_t in the verifier being generated
+static bool value_range_set;
+static Interval value_range;
+
+void set_value_range(const ValueType &value_type) {
+  value_range = Interval{value_type.min, value_type.max};
+  value_range_set = true;
+}
+
+static bool fits_value_type(const Interval &i) {
+  assert(value_range_set && "interval analysis used before set_value_range()");
+  return i.lb >= value_range.lb && i.ub <= value_range.ub;
+}
+
+// get the bounds of a simple type, if known
+static bool get_type_interval(const TypeExpr &t, Interval &result) {
+
+  if (!t.is_simple())
+    return false;
+
+  const Ptr<TypeExpr> resolved = t.resolve();
+
+  // the range type inferred for a loop counter with non-constant bounds has no
+  // usable limits
+  if (auto r = dynamic_cast<const Range *>(resolved.get())) {
+    if (r->min == nullptr || r->max == nullptr)
+      return false;
+    if (!r->min->constant() || !r->max->constant())
+      return false;
+  }
+
+  result = Interval{resolved->lower_bound(), resolved->upper_bound()};
+  return true;
+}
+
+bool get_interval(const Expr &e, Interval &result) {
+
+  if (auto n = dynamic_cast<const Number *>(&e)) {
+    result = Interval{n->value, n->value};
+    return true;
+  }
+
+  if (auto n = dynamic_cast<const ExprID *>(&e)) {
+    if (n->value == nullptr)
+      return false;
+
+    // a reference to a constant or enum member
+    if (auto c = dynamic_cast<const ConstDecl *>(n->value.get())) {
+      const mpz_class v = c->value->constant_fold();
+      result = Interval{v, v};
+      return true;
+    }
+
+    // an alias to a non-lvalue is just the aliased expression
+    if (auto a = dynamic_cast<const AliasDecl *>(n->value.get())) {
+      if (!a->value->is_lvalue())
+        return get_interval(*a->value, result);
+    }
+  }
+
+  /* A read of a variable, including quantified variables, record fields and
+   * array elements, is range checked on read so yields a value within the
+   * bounds of its type.
+   */
+  if (isa<ExprID>(&e) || isa<Field>(&e) || isa<Element>(&e)) {
+    if (!e.is_lvalue())
+      return false;
+    const Ptr<TypeExpr> t = e.type();
+    if (t == nullptr)
+      return false;
+    return get_type_interval(*t, result);
+  }
+
+  // boolean-valued expressions
+  if (isa<BooleanBinaryExpr>(&e) || isa<ComparisonBinaryExpr>(&e) ||
+      isa<EquatableBinaryExpr>(&e) || isa<Not>(&e) || isa<Exists>(&e) ||
+      isa<Forall>(&e) || isa<IsUndefined>(&e)) {
+    result = Interval{0, 1};
+    return true;
+  }
+
+  if (auto n = dynamic_cast<const Add *>(&e)) {
+    Interval l, r;
+    if (!get_interval(*n->lhs, l) || !get_interval(*n->rhs, r))
+      return false;
+    result = Interval{l.lb + r.lb, l.ub + r.ub};
+    return true;
+  }
+
+  if (auto n = dynamic_cast<const Sub *>(&e)) {
+    Interval l, r;
+    if (!get_interval(*n->lhs, l) || !get_interval(*n->rhs, r))
+      return false;
+    result = Interval{l.lb - r.ub, l.ub - r.lb};
+    return true;
+  }
+
+  if (auto n = dynamic_cast<const Mul *>(&e)) {
+    Interval l, r;
+    if (!get_interval(*n->lhs, l) || !get_interval(*n->rhs, r))
+      return false;
+    // the extremes of the result are found at the products of the extremes of
+    // the operands
+    const mpz_class products[] = {l.lb * r.lb, l.lb * r.ub, l.ub * r.lb,
+                                  l.ub * r.ub};
+    result = Interval{products[0], products[0]};
+    for (const mpz_class &p : products) {
+      if (p < result.lb)
+        result.lb = p;
+      if (p > result.ub)
+        result.ub = p;
+    }
+    return true;
+  }
+
+  if (auto n = dynamic_cast<const Negative *>(&e)) {
+    Interval r;
+    if (!get_interval(*n->rhs, r))
+      return false;
+    result = Interval{-r.ub, -r.lb};
+    return true;
+  }
+
+  if (auto n = dynamic_cast<const Ternary *>(&e)) {
+    Interval l, r;
+    if (!get_interval(*n->lhs, l) || !get_interval(*n->rhs, r))
+      return false;
+    result = Interval{l.lb < r.lb ? l.lb : r.lb, l.ub > r.ub ? l.ub : r.ub};
+    return true;
+  }
+
+  // anything else (function calls, division, bitwise operations, ...) we make
+  // no attempt to reason about
+  return false;
+}
+
+bool is_overflow_free(const Expr &e) {
+
+  assert((isa<Add>(&e) || isa<Sub>(&e) || isa<Mul>(&e) ||
+          isa<Negative>(&e)) &&
+         "is_overflow_free() called on non-arithmetic expression");
+
+  Interval i;
+  if (!get_interval(e, i))
+    return false;
+
+  return fits_value_type(i);
+}
+
+bool is_in_range(const Expr &e, const TypeExpr &dest) {
+
+  Interval d;
+  if (!get_type_interval(dest, d))
+    return false;
+
+  Interval i;
+  if (!get_interval(e, i))
+    return false;
+
+  return i.lb >= d.lb && i.ub <= d.ub && fits_value_type(i);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ValueType.h"
+#include <cstddef>
+#include <gmpxx.h>
+#include <rumur/rumur.h>
+
+/* A simple interval analysis over the numerical expressions of a model. This
+ * is used during code generation to identify arithmetic that can never overflow
+ * and assignments that can never exceed the bounds of their destination. The
+ * runtime checks for these can then be omitted from the generated verifier.
+ */
+
+// inclusive bounds on the values an expression may take
+struct Interval {
+  mpz_class lb;
+  mpz_class ub;
+};
+
+/* Set the bounds of value_t in the verifier being generated. This must be
+ * called before any of the following functions are used.
+ */
+void set_value_range(const ValueType &value_type);
+
+/* Try to determine bounds on the values a simple typed expression can evaluate
+ * to, assuming evaluation of the expression does not raise an error. Returns
+ * false if no useful bounds could be established.
+ */
+bool get_interval(const rumur::Expr &e, Interval &result);
+
+/* Can the result of this arithmetic expression (add, subtract, multiply or
+ * negate) be computed without an overflow check?
+ */
+bool is_overflow_free(const rumur::Expr &e);
+
+/* Can a value of this expression be written into a location of the given type
+ * without a range check?
+ */
+bool is_in_range(const rumur::Expr &e, const rumur::TypeExpr &dest);
+
+// number of runtime checks that have been omitted from the generated code
+extern unsigned long elided_checks;
@@ -1,19 +1,17 @@
 #include "../../common/environ.h"
 #include "../../common/help.h"
 #include "ValueType.h"
-#include "check.h"
 #include "generate.h"
-#include "has-start-state.h"
 #include "log.h"
-#include "optimise-field-ordering.h"
 #include "options.h"
+#include "prepare-model.h"
 #include "resources.h"
-#include "smt/except.h"
-#include "smt/simplify.h"
 #include "utils.h"
 #include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -51,24 +49,36 @@ static void parse_args(int argc, char **argv) {
 
   for (;;) {
     enum {
-      OPT_BOUND = 128,
+      OPT_AUTO_UNDEFINE = 128,
+      OPT_BOUND,
+      OPT_CANONICALISATION_CACHE,
       OPT_COLOUR,
       OPT_COUNTEREXAMPLE_TRACE,
       OPT_DEADLOCK_DETECTION,
+      OPT_DEEPEN,
       OPT_MAX_ERRORS,
       OPT_MONOPOLISE,
+      OPT_MULTI_REPRESENTATIVE_ROUNDS,
       OPT_OUTPUT_FORMAT,
       OPT_PACK_STATE,
       OPT_POINTER_BITS,
       OPT_REORDER_FIELDS,
       OPT_SANDBOX,
       OPT_SCALARSET_SCHEDULES,
+      OPT_SEARCH,
+      OPT_SEED,
+      OPT_SIMULATE,
+      OPT_SLICE_STATE,
       OPT_SMT_ARG,
       OPT_SMT_BITVECTORS,
       OPT_SMT_BUDGET,
+      OPT_SMT_CACHE,
+      OPT_SMT_JOBS,
       OPT_SMT_PATH,
       OPT_SMT_PRELUDE,
       OPT_SMT_SIMPLIFICATION,
+      OPT_SPLIT,
+      OPT_SWARM,
       OPT_SYMMETRY_REDUCTION,
       OPT_TRACE,
       OPT_VALUE_TYPE,
@@ -76,17 +86,25 @@ static void parse_args(int argc, char **argv) {
     };
 
     static struct option opts[] = {
+        {"auto-undefine", required_argument, 0, OPT_AUTO_UNDEFINE},
         {"bound", required_argument, 0, OPT_BOUND},
+        {"canonicalisation-cache", required_argument, 0,
+         OPT_CANONICALISATION_CACHE},
+        {"canonicalization-cache", required_argument, 0,
+         OPT_CANONICALISATION_CACHE},
         {"color", required_argument, 0, OPT_COLOUR},
         {"colour", required_argument, 0, OPT_COLOUR},
         {"counterexample-trace", required_argument, 0,
          OPT_COUNTEREXAMPLE_TRACE},
         {"deadlock-detection", required_argument, 0, OPT_DEADLOCK_DETECTION},
         {"debug", no_argument, 0, 'd'},
+        {"deepen", required_argument, 0, OPT_DEEPEN},
         {"help", no_argument, 0, 'h'},
         {"max-errors", required_argument, 0, OPT_MAX_ERRORS},
         {"monopolise", no_argument, 0, OPT_MONOPOLISE},
         {"monopolize", no_argument, 0, OPT_MONOPOLISE},
+        {"multi-representative-rounds", required_argument, 0,
+         OPT_MULTI_REPRESENTATIVE_ROUNDS},
         {"output", required_argument, 0, 'o'},
         {"output-format", required_argument, 0, OPT_OUTPUT_FORMAT},
         {"pack-state", required_argument, 0, OPT_PACK_STATE},
@@ -95,14 +113,22 @@ static void parse_args(int argc, char **argv) {
         {"reorder-fields", required_argument, 0, OPT_REORDER_FIELDS},
         {"sandbox", required_argument, 0, OPT_SANDBOX},
         {"scalarset-schedules", required_argument, 0, OPT_SCALARSET_SCHEDULES},
+        {"search", required_argument, 0, OPT_SEARCH},
+        {"seed", required_argument, 0, OPT_SEED},
         {"set-capacity", required_argument, 0, 's'},
         {"set-expand-threshold", required_argument, 0, 'e'},
+        {"simulate", required_argument, 0, OPT_SIMULATE},
+        {"slice-state", required_argument, 0, OPT_SLICE_STATE},
         {"smt-arg", required_argument, 0, OPT_SMT_ARG},
         {"smt-bitvectors", required_argument, 0, OPT_SMT_BITVECTORS},
         {"smt-budget", required_argument, 0, OPT_SMT_BUDGET},
+        {"smt-cache", required_argument, 0, OPT_SMT_CACHE},
+        {"smt-jobs", required_argument, 0, OPT_SMT_JOBS},
         {"smt-path", required_argument, 0, OPT_SMT_PATH},
         {"smt-prelude", required_argument, 0, OPT_SMT_PRELUDE},
         {"smt-simplification", required_argument, 0, OPT_SMT_SIMPLIFICATION},
+        {"split", required_argument, 0, OPT_SPLIT},
+        {"swarm", required_argument, 0, OPT_SWARM},
         {"symmetry-reduction", required_argument, 0, OPT_SYMMETRY_REDUCTION},
         {"threads", required_argument, 0, 't'},
         {"trace", required_argument, 0, OPT_TRACE},
@@ -314,6 +340,8 @@ static void parse_args(int argc, char **argv) {
         options.symmetry_reduction = SymmetryReduction::HEURISTIC;
       } else if (strcmp(optarg, "exhaustive") == 0) {
         options.symmetry_reduction = SymmetryReduction::EXHAUSTIVE;
+      } else if (strcmp(optarg, "multi") == 0) {
+        options.symmetry_reduction = SymmetryReduction::MULTI;
       } else {
         std::cerr << "invalid argument to --symmetry-reduction, \"" << optarg
                   << "\"\n";
@@ -344,6 +372,21 @@ static void parse_args(int argc, char **argv) {
       }
       break;
 
+    case OPT_SEARCH: // --search ...
+      if (strcmp(optarg, "bfs") == 0) {
+        options.search = Search::BFS;
+      } else if (strcmp(optarg, "best-first") == 0) {
+        options.search = Search::BEST_FIRST;
+      } else if (strcmp(optarg, "bfs-layered") == 0) {
+        options.search = Search::BFS_LAYERED;
+      } else if (strcmp(optarg, "dfs") == 0) {
+        options.search = Search::DFS;
+      } else {
+        std::cerr << "invalid argument to --search, \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+
     case OPT_MAX_ERRORS: { // --max-errors ...
       bool valid = true;
       try {
@@ -392,6 +435,18 @@ static void parse_args(int argc, char **argv) {
       std::cout << "Rumur version " << rumur_get_version() << '\n';
       exit(EXIT_SUCCESS);
 
+    case OPT_AUTO_UNDEFINE: // --auto-undefine ...
+      if (strcmp(optarg, "on") == 0) {
+        options.auto_undefine = true;
+      } else if (strcmp(optarg, "off") == 0) {
+        options.auto_undefine = false;
+      } else {
+        std::cerr << "invalid argument to --auto-undefine, \"" << optarg
+                  << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+
     case OPT_BOUND: { // --bound ...
       bool valid = true;
       try {
@@ -408,6 +463,120 @@ static void parse_args(int argc, char **argv) {
       break;
     }
 
+    case OPT_DEEPEN: { // --deepen ...
+      bool valid = true;
+      try {
+        options.deepen = optarg;
+        if (options.deepen < 0)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --deepen argument \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
+    case OPT_CANONICALISATION_CACHE: { // --canonicalisation-cache ...
+      bool valid = true;
+      try {
+        options.canonicalisation_cache = optarg;
+        if (options.canonicalisation_cache < 0)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --canonicalisation-cache argument \"" << optarg
+                  << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
+    case OPT_MULTI_REPRESENTATIVE_ROUNDS: { // --multi-representative-rounds ...
+      bool valid = true;
+      try {
+        options.multi_representative_rounds = optarg;
+        if (options.multi_representative_rounds < 0)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --multi-representative-rounds argument \""
+                  << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
+    case OPT_SEED: { // --seed ...
+      bool valid = true;
+      try {
+        options.seed = optarg;
+        if (options.seed < 0 || options.seed > UINT64_MAX)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --seed argument \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
+    case OPT_SIMULATE: { // --simulate ...
+      bool valid = true;
+      try {
+        options.simulate = optarg;
+        if (options.simulate < 0 || options.simulate > UINT64_MAX)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --simulate argument \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
+    case OPT_SPLIT: { // --split ...
+      bool valid = true;
+      try {
+        options.split = optarg;
+        if (options.split < 0 || options.split > UINT64_MAX)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --split argument \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
+    case OPT_SWARM: { // --swarm ...
+      bool valid = true;
+      try {
+        options.swarm = optarg;
+        if (options.swarm < 0 || options.swarm > UINT64_MAX / CHAR_BIT)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --swarm argument \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+    }
+
     case OPT_VALUE_TYPE: // --value-type ...
       options.value_type = optarg;
       break;
@@ -424,6 +593,18 @@ static void parse_args(int argc, char **argv) {
       }
       break;
 
+    case OPT_SLICE_STATE: // --slice-state ...
+      if (strcmp(optarg, "on") == 0) {
+        options.slice_state = true;
+      } else if (strcmp(optarg, "off") == 0) {
+        options.slice_state = false;
+      } else {
+        std::cerr << "invalid argument to --slice-state, \"" << optarg
+                  << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      break;
+
     case OPT_SMT_ARG: // --smt-arg ...
       options.smt.args.emplace_back(optarg);
       if (options.smt.simplification == SmtSimplification::AUTO) {
@@ -465,6 +646,32 @@ static void parse_args(int argc, char **argv) {
       break;
     }
 
+    case OPT_SMT_CACHE: // --smt-cache ...
+      options.smt.cache = optarg;
+      if (options.smt.simplification == SmtSimplification::AUTO) {
+        options.smt.simplification = SmtSimplification::ON;
+      }
+      break;
+
+    case OPT_SMT_JOBS: { // --smt-jobs ...
+      bool valid = true;
+      try {
+        options.smt.jobs = optarg;
+        if (options.smt.jobs <= 0)
+          valid = false;
+      } catch (std::invalid_argument &) {
+        valid = false;
+      }
+      if (!valid) {
+        std::cerr << "invalid --smt-jobs argument \"" << optarg << "\"\n";
+        exit(EXIT_FAILURE);
+      }
+      if (options.smt.simplification == SmtSimplification::AUTO) {
+        options.smt.simplification = SmtSimplification::ON;
+      }
+      break;
+    }
+
     case OPT_SMT_PATH: // --smt-path ...
       options.smt.path = optarg;
       if (options.smt.simplification == SmtSimplification::AUTO) {
@@ -525,21 +732,11 @@ static void parse_args(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
-  if (options.threads == 0) {
-    // automatic
-    long r = sysconf(_SC_NPROCESSORS_ONLN);
-    if (r < 1) {
-      options.threads = 1;
-    } else {
-      options.threads = r;
-    }
-  }
-
-  if (options.smt.simplification == SmtSimplification::ON &&
-      options.smt.path == "") {
-    *warn << "SMT simplification was enabled but no path was provided to the "
-          << "solver (--smt-path ...), so it will be disabled\n";
-    options.smt.simplification = SmtSimplification::OFF;
+  try {
+    validate_options();
+  } catch (std::runtime_error &e) {
+    std::cerr << e.what() << '\n';
+    exit(EXIT_FAILURE);
   }
 }
 
@@ -648,34 +845,8 @@ int main(int argc, char **argv) {
 
   assert(m != nullptr);
 
-  /* Re-index the model (assign unique identifiers to each node that are used in
-   * generation of the verifier).
-   */
-  *debug << "re-indexing...\n";
-  m->reindex();
-
-  // resolve symbolic references and validate the model
-  try {
-    *debug << "resolving symbols...\n";
-    resolve_symbols(*m);
-    *debug << "validating AST...\n";
-    validate(*m);
-  } catch (Error &e) {
-    std::cerr << white() << bold() << input_filename << ':' << e.loc << ':'
-              << reset() << ' ' << red() << bold() << "error:" << reset() << ' '
-              << white() << bold() << e.what() << reset() << '\n';
-    print_location(input_filename, e.loc);
-    return EXIT_FAILURE;
-  }
-
-  // Check whether we have a start state.
-  if (!has_start_state(*m))
-    *warn << "warning: model has no start state\n";
-
-  // check whether the model uses unsupported things
   try {
-    *debug << "checking for use of unsupported features...\n";
-    check(*m);
+    prepare_model(*m);
   } catch (Error &e) {
     std::cerr << white() << bold() << input_filename << ':' << e.loc << ':'
               << reset() << ' ' << red() << bold() << "error:" << reset() << ' '
@@ -684,26 +855,6 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
-  // run SMT simplification if the user enabled it
-  if (options.smt.simplification == SmtSimplification::ON) {
-    *debug << "SMT simplification...\n";
-    try {
-      smt::simplify(*m);
-    } catch (smt::BudgetExhausted &) {
-      *info << "SMT solver budget (" << options.smt.budget << "ms) exhausted\n";
-    } catch (smt::Unsupported &e) {
-      if (e.expr != nullptr)
-        *info << e.expr->loc << ": ";
-      *info << e.what() << '\n';
-    }
-  }
-
-  // re-order fields to optimise access to them
-  if (options.reorder_fields) {
-    *debug << "optimising field ordering...\n";
-    optimise_field_ordering(*m);
-  }
-
   // get value_t to use in the checker
   *debug << "determining value_t type...\n";
   std::pair<ValueType, ValueType> value_types;
@@ -94,48 +94,14 @@ class Reorderer : public Traversal {
 public:
   // The default traversal does not descend into the referent of ExprIDs.
   // However, we do need to because they may have a copy of a record type whose
-  // fields we have reordered. We need to also encounter the copy and reorder
-  // its fields the same way.
+  // fields we reorder. We need to also encounter the copy and reorder its
+  // fields the same way.
+  //
+  // Records are commonly shared between many references. Reaching each of them
+  // through its owning `Ptr` unshares it before we reorder it, so copies of the
+  // AST held elsewhere are unaffected.
   void visit_exprid(ExprID &n) final { dispatch(*n.value); }
 
-  void visit_model(Model &n) final {
-
-    // first act on our children
-    for (Ptr<Node> &c : n.children)
-      dispatch(*c);
-
-    // extract out the VarDecls
-    std::vector<Ptr<VarDecl>> vars;
-    for (Ptr<Node> &c : n.children) {
-      if (auto v = dynamic_cast<VarDecl *>(c.get())) {
-        auto vp = Ptr<VarDecl>::make(*v);
-        vars.push_back(vp);
-      }
-    }
-
-    const std::vector<std::string> original = get_names(vars);
-
-    // sort the variables
-    sort(vars);
-
-    notify_changes(original, vars);
-
-    // the offset of each variable within the model state is now inaccurate, so
-    // calculate the new VarDecl -> offset mapping
-    mpz_class offset = 0;
-    std::unordered_map<std::string, mpz_class> offsets;
-    for (Ptr<VarDecl> &v : vars) {
-      offsets[v->name] = offset;
-      offset += v->type->width();
-    }
-
-    // apply these updated offsets to the original VarDecls
-    for (Ptr<Node> &c : n.children) {
-      if (auto v = dynamic_cast<VarDecl *>(c.get()))
-        v->offset = offsets[v->name];
-    }
-  }
-
   void visit_record(Record &n) final {
 
     // first act on our children
@@ -156,6 +122,38 @@ public:
 } // namespace
 
 void optimise_field_ordering(Model &m) {
+
   Reorderer r;
   r.dispatch(m);
+
+  // extract out the VarDecls
+  std::vector<Ptr<VarDecl>> vars;
+  for (const Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<const VarDecl *>(c.get())) {
+      auto vp = Ptr<VarDecl>::make(*v);
+      vars.push_back(vp);
+    }
+  }
+
+  const std::vector<std::string> original = get_names(vars);
+
+  // sort the variables
+  sort(vars);
+
+  notify_changes(original, vars);
+
+  // the offset of each variable within the model state is now inaccurate, so
+  // calculate the new VarDecl -> offset mapping
+  mpz_class offset = 0;
+  std::unordered_map<std::string, mpz_class> offsets;
+  for (Ptr<VarDecl> &v : vars) {
+    offsets[v->name] = offset;
+    offset += v->type->width();
+  }
+
+  // apply these updated offsets to the original VarDecls
+  for (Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<VarDecl *>(c.get()))
+      v->offset = offsets[v->name];
+  }
 }
@@ -46,6 +46,14 @@ enum struct SymmetryReduction {
   OFF,
   HEURISTIC,
   EXHAUSTIVE,
+  MULTI,
+};
+
+enum struct Search {
+  BFS,
+  BFS_LAYERED,
+  BEST_FIRST,
+  DFS,
 };
 
 enum struct SmtSimplification {
@@ -73,9 +81,20 @@ struct Options {
   // Deadlock detection enabled?
   DeadlockDetection deadlock_detection = DeadlockDetection::STUTTERING;
 
+  // Order in which to explore the state space
+  Search search = Search::BFS;
+
   // Symmetry reduction enabled?
   SymmetryReduction symmetry_reduction = SymmetryReduction::HEURISTIC;
 
+  // Number of entries in each thread's cache of heuristic canonicalisation
+  // results. 0 means no cache.
+  mpz_class canonicalisation_cache = 0;
+
+  // Maximum number of local search passes over each scalarset when using
+  // multiple-representative symmetry reduction
+  mpz_class multi_representative_rounds = 2;
+
   // Use OS mechanisms to sandbox the checker?
   bool sandbox_enabled = false;
 
@@ -91,6 +110,22 @@ struct Options {
   // Limit for exploration. 0 means unbounded.
   mpz_class bound = 0;
 
+  // Depth increment for iterative deepening up to the bound. 0 means explore
+  // directly to the bound.
+  mpz_class deepen = 0;
+
+  // Number of steps in each random walk when simulating. 0 means perform
+  // exhaustive verification instead.
+  mpz_class simulate = 0;
+
+  // Size in bytes of each worker's bitstate table in swarm verification. 0
+  // means perform a regular search instead.
+  mpz_class swarm = 0;
+
+  // Seed for the pseudo-random number generators used in simulation and swarm
+  // verification. 0 means choose a seed at runtime.
+  mpz_class seed = 0;
+
   // Type used for value_t in the checker
   std::string value_type = "auto";
 
@@ -103,9 +138,19 @@ struct Options {
   // whether to track schedules during scalarset permutation
   bool scalarset_schedules = true;
 
+  // whether to remove state variables that cannot affect the model's behaviour
+  bool slice_state = false;
+
+  // whether to reset state variables that are dead between transitions
+  bool auto_undefine = false;
+
   // number of relevant bits in a pointer on the target platform (0 == auto)
   mpz_class pointer_bits = 0;
 
+  // Maximum number of flattened rules in each translation unit when emitting
+  // the checker as a directory of C files. 0 means emit a single file.
+  mpz_class split = 0;
+
   // options related to SMT solver interaction
   struct {
 
@@ -118,6 +163,13 @@ struct Options {
     // total SMT solver execution time allowed in milliseconds
     mpz_class budget = 30000;
 
+    // number of solver processes to run in parallel
+    mpz_class jobs = 1;
+
+    // directory in which to cache solver results across runs. "" indicates no
+    // caching.
+    std::string cache;
+
     // use SMT solver for expression simplification?
     SmtSimplification simplification = SmtSimplification::AUTO;
 
@@ -1,19 +1,25 @@
-#include "../../common/isa.h"
 #include "ValueType.h"
+#include "always-defined.h"
 #include "assume-statements-count.h"
 #include "generate.h"
+#include "interval-analysis.h"
+#include "log.h"
 #include "max-simple-width.h"
 #include "options.h"
 #include "prints-scalarsets.h"
 #include "resources.h"
 #include "symmetry-reduction.h"
 #include <cassert>
+#include <cerrno>
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <rumur/rumur.h>
 #include <string>
+#include <sys/stat.h>
 #include <utility>
+#include <vector>
 
 using namespace rumur;
 
@@ -69,6 +75,33 @@ static std::ostream &operator<<(std::ostream &out, SymmetryReduction s) {
   case SymmetryReduction::EXHAUSTIVE:
     out << "SYMMETRY_REDUCTION_EXHAUSTIVE";
     break;
+
+  case SymmetryReduction::MULTI:
+    out << "SYMMETRY_REDUCTION_MULTI";
+    break;
+  }
+
+  return out;
+}
+
+static std::ostream &operator<<(std::ostream &out, Search s) {
+  switch (s) {
+
+  case Search::BFS:
+    out << "SEARCH_BFS";
+    break;
+
+  case Search::BFS_LAYERED:
+    out << "SEARCH_BFS_LAYERED";
+    break;
+
+  case Search::BEST_FIRST:
+    out << "SEARCH_BEST_FIRST";
+    break;
+
+  case Search::DFS:
+    out << "SEARCH_DFS";
+    break;
   }
 
   return out;
@@ -94,60 +127,40 @@ static std::ostream &operator<<(std::ostream &out, CounterexampleTrace c) {
 }
 
 // maximum value state.rule_taken can reach in the generated checker, given the
-// guarding predicate
-static mpz_class rule_taken_max(const Model &model,
-                                bool (*predicate)(const Rule &r)) {
+// flattened rules it counts
+static mpz_class rule_taken_max(const std::vector<Ptr<Rule>> &flattened) {
 
   mpz_class total = 0;
 
-  // flatten all rules
-  for (const Ptr<Node> &c : model.children) {
-    if (auto r = dynamic_cast<const Rule *>(c.get())) {
-      const std::vector<Ptr<Rule>> flattened = r->flatten();
-      for (const Ptr<Rule> &f : flattened) {
-
-        // skip anything that does not match our criteria
-        if (!predicate(*f))
-          continue;
-
-        // determine how many rules this generates when quantifiers are expanded
-        mpz_class rules = 1;
-        for (const Quantifier &q : f->quantifiers) {
-          assert(q.constant() &&
-                 "non-constant quantifier used in rule (unvalidated AST?)");
-          rules *= q.count();
-        }
-
-        total += rules;
-      }
+  for (const Ptr<Rule> &f : flattened) {
+
+    // determine how many rules this generates when quantifiers are expanded
+    mpz_class rules = 1;
+    for (const Quantifier &q : f->quantifiers) {
+      assert(q.constant() &&
+             "non-constant quantifier used in rule (unvalidated AST?)");
+      rules *= q.count();
     }
+
+    total += rules;
   }
 
   return total;
 }
 
-// state.rule_taken is overloaded to mean different things depending on whether
-// the containing state is an initial state or a subsequent one, so we need to
-// compute the maximum value either of these can induce
-static mpz_class rule_taken_max_start(const Model &model) {
-  auto is_start = [](const Rule &r) { return isa<StartState>(&r); };
-  return rule_taken_max(model, is_start);
-}
-static mpz_class rule_taken_max_rule(const Model &model) {
-  auto is_rule = [](const Rule &r) { return isa<SimpleRule>(&r); };
-  return rule_taken_max(model, is_rule);
-}
-
 // maximum value needed to be representable in state.rule_taken, accounting for
 // configuration
-static mpz_class rule_taken_limit(const Model &model) {
+static mpz_class rule_taken_limit(const FlatRules &flat) {
 
   // rule taken data is only required when we need counter-example traces
   if (options.counterexample_trace == CounterexampleTrace::OFF)
     return 0;
 
-  mpz_class s_max = rule_taken_max_start(model);
-  mpz_class r_max = rule_taken_max_rule(model);
+  // state.rule_taken is overloaded to mean different things depending on
+  // whether the containing state is an initial state or a subsequent one, so we
+  // need to compute the maximum value either of these can induce
+  mpz_class s_max = rule_taken_max(flat.start_states);
+  mpz_class r_max = rule_taken_max(flat.rules);
 
   return s_max > r_max ? s_max : r_max;
 }
@@ -168,12 +181,10 @@ static mpz_class schedule_bits(const Model &model) {
   return bits;
 }
 
-int output_checker(const std::string &path, const Model &model,
-                   const std::pair<ValueType, ValueType> &value_types) {
-
-  std::ofstream out(path);
-  if (!out)
-    return -1;
+// write everything that precedes the model itself
+static void
+generate_prelude(std::ostream &out, const Model &model, const FlatRules &flat,
+                 const std::pair<ValueType, ValueType> &value_types) {
 
   if (options.log_level < LogLevel::DEBUG)
     out << "#define NDEBUG 1\n\n";
@@ -185,12 +196,13 @@ int output_checker(const std::string &path, const Model &model,
                      resources_includes_c_len)
       << "\n"
 
-      // Settings that are used in header.c
+      // Settings that are used in header.c. Some of these are only defaults
+      // that can be overridden when running the checker.
       << "enum { SET_CAPACITY = " << options.set_capacity << "ul };\n\n"
       << "enum { SET_EXPAND_THRESHOLD = " << options.set_expand_threshold
       << " };\n\n"
-      << "static const enum { OFF, ON, AUTO } COLOR = " << options.color
-      << ";\n\n"
+      << "enum color { OFF, ON, AUTO };\n"
+      << "enum { COLOR = " << options.color << " };\n\n"
       << "enum trace_category_t {\n"
       << "  TC_HANDLE_READS       = " << TC_HANDLE_READS << ",\n"
       << "  TC_HANDLE_WRITES      = " << TC_HANDLE_WRITES << ",\n"
@@ -210,14 +222,26 @@ int output_checker(const std::string &path, const Model &model,
       << "  SYMMETRY_REDUCTION_OFF = 0,\n"
       << "  SYMMETRY_REDUCTION_HEURISTIC = 1,\n"
       << "  SYMMETRY_REDUCTION_EXHAUSTIVE = 2,\n"
+      << "  SYMMETRY_REDUCTION_MULTI = 3,\n"
       << "};\n"
       << "#define SYMMETRY_REDUCTION " << options.symmetry_reduction << "\n\n"
+      << "enum { CANONICALISATION_CACHE_SIZE = "
+      << options.canonicalisation_cache << "ul };\n\n"
+      << "enum { MULTI_REPRESENTATIVE_ROUNDS = "
+      << options.multi_representative_rounds << "ul };\n\n"
+      << "enum {\n"
+      << "  SEARCH_BFS = 0,\n"
+      << "  SEARCH_BFS_LAYERED = 1,\n"
+      << "  SEARCH_BEST_FIRST = 2,\n"
+      << "  SEARCH_DFS = 3,\n"
+      << "};\n"
+      << "#define SEARCH " << options.search << "\n\n"
       << "enum { SANDBOX_ENABLED = " << options.sandbox_enabled << " };\n\n"
       << "enum { MAX_ERRORS = " << options.max_errors << "ul };\n\n"
       << "enum { THREADS = " << options.threads << "ul };\n\n"
       << "enum { STATE_SIZE_BITS = " << model.size_bits() << "ul };\n\n"
-      << "enum { ASSUME_STATEMENTS_COUNT = " << assume_statements_count(model)
-      << "ul };\n\n"
+      << "enum { FUNCTION_ASSUME_STATEMENTS_COUNT = "
+      << function_assume_statements_count(model) << "ul };\n\n"
       << "#define LIVENESS_COUNT " << model.liveness_count() << "\n\n"
       << "#define CEX_OFF 0\n"
       << "#define DIFF 1\n"
@@ -228,6 +252,13 @@ int output_checker(const std::string &path, const Model &model,
       << " };\n\n"
       << "enum { MAX_SIMPLE_WIDTH = " << max_simple_width(model) << " };\n\n"
       << "#define BOUND " << options.bound << "\n\n"
+      << "static const uint64_t DEEPEN_STEP = UINT64_C(" << options.deepen
+      << ");\n"
+      << "static const uint64_t SIMULATE_STEPS = UINT64_C(" << options.simulate
+      << ");\n"
+      << "static const uint64_t SWARM_BITSTATE_SIZE = UINT64_C("
+      << options.swarm << ");\n"
+      << "static const uint64_t SEED = UINT64_C(" << options.seed << ");\n\n"
       << "typedef " << value_types.first.c_type << " value_t;\n"
       << "#define VALUE_MIN " << value_types.first.int_min << "\n"
       << "#define VALUE_MAX " << value_types.first.int_max << "\n"
@@ -237,7 +268,7 @@ int output_checker(const std::string &path, const Model &model,
       << "#define RAW_VALUE_MIN " << value_types.second.int_min << "\n"
       << "#define RAW_VALUE_MAX " << value_types.second.int_max << "\n"
       << "#define PRIRAWVAL " << value_types.second.pri << "\n\n"
-      << "#define RULE_TAKEN_LIMIT " << rule_taken_limit(model) << "\n"
+      << "#define RULE_TAKEN_LIMIT " << rule_taken_limit(flat) << "\n"
       << "#define PACK_STATE " << (options.pack_state ? 1 : 0) << "\n"
       << "#define SCHEDULE_BITS " << schedule_bits(model) << "ul\n"
       << "#define PRINTS_SCALARSETS " << (prints_scalarsets(model) ? "1" : "0")
@@ -249,16 +280,115 @@ int output_checker(const std::string &path, const Model &model,
       << (options.scalarset_schedules ? "1" : "0")
       << " && SYMMETRY_REDUCTION != SYMMETRY_REDUCTION_OFF && \\\n"
       << "  (COUNTEREXAMPLE_TRACE != CEX_OFF || PRINTS_SCALARSETS))\n"
-      << "#define POINTER_BITS " << options.pointer_bits << "\n";
+      << "#define POINTER_BITS " << options.pointer_bits << "\n\n";
+
+  // linkage of state and functions used across translation units
+  if (options.split == 0) {
+    out << "#define RUNTIME_UNIT 1\n"
+        << "#define SHARED static\n"
+        << "#define SHARED_INIT(...) = __VA_ARGS__\n"
+        << "#define EXPORT static\n";
+  } else {
+    out << "/* The checker is split across multiple translation units. Shared "
+           "state is\n"
+        << " * defined in the unit that defines RUNTIME_UNIT and declared in "
+           "the others.\n"
+        << " */\n"
+        << "#ifndef RUNTIME_UNIT\n"
+        << "#define RUNTIME_UNIT 0\n"
+        << "#endif\n"
+        << "#if RUNTIME_UNIT\n"
+        << "#define SHARED\n"
+        << "#define SHARED_INIT(...) = __VA_ARGS__\n"
+        << "#else\n"
+        << "#define SHARED extern\n"
+        << "#define SHARED_INIT(...)\n"
+        << "#endif\n"
+        << "#define EXPORT\n"
+        << "\n"
+        << "/* each unit uses only some of the static definitions here */\n"
+        << "#pragma GCC diagnostic ignored \"-Wunused-function\"\n"
+        << "#pragma GCC diagnostic ignored \"-Wunused-variable\"\n";
+  }
 
   generate_cover_array(out, model);
 
   // Static boiler plate code
   out << std::string((const char *)resources_header_c, resources_header_c_len)
       << "\n";
+}
+
+int output_checker(const std::string &path, const Model &model,
+                   const std::pair<ValueType, ValueType> &value_types) {
+
+  set_value_range(value_types.first);
+  find_always_defined(model);
+
+  // only count the checks elided from this checker
+  elided_checks = 0;
+
+  // flatten the model's rules once, for use by all of the generation below
+  const FlatRules flat(model);
+
+  if (options.split == 0) {
+    std::ofstream out(path);
+    if (!out)
+      return -1;
+
+    generate_prelude(out, model, flat, value_types);
+
+    // the model itself
+    const ModelOutput output = {
+        out, out, out, [&out](size_t) -> std::ostream & { return out; },
+        false};
+    generate_model(output, model, flat);
+
+  } else {
+    // emit a directory of translation units that can be compiled in parallel
+    if (mkdir(path.c_str(), 0777) < 0 && errno != EEXIST)
+      return -1;
+
+    // declarations shared by all units
+    std::ofstream common(path + "/checker.h");
+    common << "#pragma once\n\n";
+    generate_prelude(common, model, flat, value_types);
+
+    // exploration logic and the definitions of shared state
+    std::ofstream runtime(path + "/runtime.c");
+    runtime << "#define RUNTIME_UNIT 1\n"
+            << "#include \"checker.h\"\n\n";
+
+    // rarely executed printing code
+    std::ofstream print(path + "/print.c");
+    print << "#include \"checker.h\"\n\n";
+
+    // rules, sharded by their index
+    const size_t per_unit = options.split.get_ui();
+    std::vector<std::unique_ptr<std::ofstream>> rules;
+    auto rule_unit = [&](size_t index) -> std::ostream & {
+      const size_t unit = index / per_unit;
+      while (rules.size() <= unit) {
+        const std::string name =
+            path + "/rules-" + std::to_string(rules.size()) + ".c";
+        rules.emplace_back(new std::ofstream(name));
+        *rules.back() << "#include \"checker.h\"\n\n";
+      }
+      return *rules[unit];
+    };
+
+    const ModelOutput output = {common, runtime, print, rule_unit, true};
+    generate_model(output, model, flat);
+
+    if (!common || !runtime || !print)
+      return -1;
+    for (const std::unique_ptr<std::ofstream> &r : rules) {
+      if (!*r)
+        return -1;
+    }
+  }
 
-  // the model itself
-  generate_model(out, model);
+  *info << "elided " << elided_checks << " runtime checks that were proven "
+        << "unnecessary\n";
 
   return 0;
 }
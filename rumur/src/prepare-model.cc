@@ -0,0 +1,116 @@
+#include "prepare-model.h"
+#include "check.h"
+#include "cone-of-influence.h"
+#include "dead-variables.h"
+#include "has-start-state.h"
+#include "log.h"
+#include "optimise-field-ordering.h"
+#include "options.h"
+#include "smt/except.h"
+#include "smt/simplify.h"
+#include <rumur/rumur.h>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace rumur;
+
+void validate_options() {
+
+  if (options.threads == 0) {
+    // automatic
+    long r = sysconf(_SC_NPROCESSORS_ONLN);
+    if (r < 1) {
+      options.threads = 1;
+    } else {
+      options.threads = r;
+    }
+  }
+
+  if (options.simulate > 0 && options.swarm > 0)
+    throw std::runtime_error("--simulate and --swarm cannot be used together");
+
+  if (options.deepen > 0) {
+    if (options.bound == 0)
+      throw std::runtime_error("--deepen requires a limit to be set with "
+                               "--bound");
+    if (options.simulate > 0 || options.swarm > 0)
+      throw std::runtime_error("--deepen cannot be used with --simulate or "
+                               "--swarm");
+  }
+
+  if (options.smt.simplification == SmtSimplification::ON &&
+      options.smt.path == "") {
+    *warn << "SMT simplification was enabled but no path was provided to the "
+          << "solver (--smt-path ...), so it will be disabled\n";
+    options.smt.simplification = SmtSimplification::OFF;
+  }
+}
+
+void prepare_model(Model &m) {
+
+  /* Re-index the model (assign unique identifiers to each node that are used in
+   * generation of the verifier).
+   */
+  *debug << "re-indexing...\n";
+  m.reindex();
+
+  // resolve symbolic references and validate the model
+  *debug << "resolving symbols...\n";
+  resolve_symbols(m);
+  *debug << "validating AST...\n";
+  validate(m);
+
+  // Check whether we have a start state.
+  if (!has_start_state(m))
+    *warn << "warning: model has no start state\n";
+
+  // check whether the model uses unsupported things
+  *debug << "checking for use of unsupported features...\n";
+  check(m);
+
+  // run SMT simplification if the user enabled it
+  if (options.smt.simplification == SmtSimplification::ON) {
+    *debug << "SMT simplification...\n";
+    try {
+      smt::simplify(m);
+    } catch (smt::BudgetExhausted &) {
+      *info << "SMT solver budget (" << options.smt.budget << "ms) exhausted\n";
+    } catch (smt::Unsupported &e) {
+      if (e.expr != nullptr)
+        *info << e.expr->loc << ": ";
+      *info << e.what() << '\n';
+    }
+  }
+
+  // remove state variables that cannot influence the model's behaviour
+  if (options.slice_state) {
+    *debug << "slicing state...\n";
+    if (slice_state(m) > 0 &&
+        options.deadlock_detection == DeadlockDetection::STUTTERING) {
+      // a rule that only changed sliced variables now looks like a stutter
+      *warn << "warning: state slicing removed variables whose changes may "
+            << "have prevented stuttering, so deadlock detection is being "
+            << "reduced to \"--deadlock-detection stuck\"\n";
+      options.deadlock_detection = DeadlockDetection::STUCK;
+    }
+  }
+
+  // find state variables that can be reset between transitions
+  if (options.auto_undefine) {
+    *debug << "finding dead state variables...\n";
+    if (find_dead_variables(m) > 0 &&
+        options.deadlock_detection == DeadlockDetection::STUTTERING) {
+      // a rule that only changed dead variables now looks like a stutter
+      *warn << "warning: resetting dead variables may cause some transitions "
+            << "to appear as stutters, so deadlock detection is being "
+            << "reduced to \"--deadlock-detection stuck\"\n";
+      options.deadlock_detection = DeadlockDetection::STUCK;
+    }
+  }
+
+  // re-order fields to optimise access to them
+  if (options.reorder_fields) {
+    *debug << "optimising field ordering...\n";
+    optimise_field_ordering(m);
+  }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <rumur/rumur.h>
+
+/* Resolve automatic settings in the global options, like the number of threads,
+ * and check for settings that conflict. Throws std::runtime_error describing
+ * the first conflict found.
+ */
+void validate_options();
+
+/* Run the analyses and transformations that precede generating a checker for a
+ * freshly parsed model, according to the current options. Throws rumur::Error
+ * if the model is invalid or uses unsupported features.
+ */
+void prepare_model(rumur::Model &m);
@@ -319,6 +319,219 @@ done:
   return ret;
 }
 
+Process::Process(const std::vector<std::string> &args) {
+
+  // setup an argument vector
+  std::vector<char *> argv;
+  for (const std::string &a : args)
+    argv.push_back(const_cast<char *>(a.c_str()));
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t fa;
+  int in_[2] = {-1, -1};
+  int out_[2] = {-1, -1};
+  pid_t pid_;
+  int err = 0;
+
+  err = posix_spawn_file_actions_init(&fa);
+  if (err != 0) {
+    *debug << "failed file_actions_init: " << strerror(err) << '\n';
+    return;
+  }
+
+  // create some pipes we'll use to communicate with the child
+  if (pipe_(in_) < 0 || pipe_(out_) < 0) {
+    *debug << "failed pipe: " << strerror(errno) << '\n';
+    goto done;
+  }
+
+  // set the ends we will use as non-blocking, so we can keep draining the
+  // child's output while writing to it
+  if (fcntl(in_[W_FD], F_SETFL, fcntl(in_[W_FD], F_GETFL) | O_NONBLOCK) ==
+          -1 ||
+      fcntl(out_[R_FD], F_SETFL, fcntl(out_[R_FD], F_GETFL) | O_NONBLOCK) ==
+          -1) {
+    *debug << "failed to set O_NONBLOCK: " << strerror(errno) << '\n';
+    goto done;
+  }
+
+  // replace the child's stdin, stdout and stderr with the pipes
+  err = posix_spawn_file_actions_adddup2(&fa, in_[R_FD], STDIN_FILENO);
+  if (err == 0)
+    err = posix_spawn_file_actions_adddup2(&fa, out_[W_FD], STDOUT_FILENO);
+  if (err == 0)
+    err = posix_spawn_file_actions_adddup2(&fa, out_[W_FD], STDERR_FILENO);
+  if (err != 0) {
+    *debug << "failed file_actions_adddup2: " << strerror(err) << '\n';
+    goto done;
+  }
+
+  // spawn the child
+  err = posix_spawnp(&pid_, argv[0], &fa, nullptr, argv.data(), get_environ());
+  if (err != 0) {
+    *debug << "failed posix_spawnp: " << strerror(err) << '\n';
+    goto done;
+  }
+
+  // retain the ends of the pipes we (the parent) need
+  pid = pid_;
+  in = in_[W_FD];
+  in_[W_FD] = -1;
+  out = out_[R_FD];
+  out_[R_FD] = -1;
+
+done:
+
+  for (int &fd : out_) {
+    if (fd != -1) {
+      (void)close(fd);
+      fd = -1;
+    }
+  }
+
+  for (int &fd : in_) {
+    if (fd != -1) {
+      (void)close(fd);
+      fd = -1;
+    }
+  }
+
+  (void)posix_spawn_file_actions_destroy(&fa);
+}
+
+Process::~Process() {
+
+  if (in != -1)
+    (void)close(in);
+  if (out != -1)
+    (void)close(out);
+
+  // the child should exit when it sees EOF, but do not rely on it
+  if (pid != -1) {
+    (void)kill(pid, SIGTERM);
+    int status;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR)
+      ;
+  }
+}
+
+bool Process::ok() const { return pid != -1 && in != -1 && out != -1; }
+
+int Process::drain() {
+  assert(out != -1 && "reading from a closed pipe");
+
+  for (;;) {
+
+    char buffer[BUFSIZ];
+    ssize_t r = read(out, buffer, sizeof(buffer));
+
+    if (r > 0) {
+      // retain anything we read
+      buffered.append(buffer, (size_t)r);
+      continue;
+    }
+
+    if (r == 0) {
+      *debug << "child closed its output\n";
+      return -1;
+    }
+
+    if (errno == EINTR)
+      continue;
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return 0;
+
+    *debug << "failed to read from child: " << strerror(errno) << '\n';
+    return -1;
+  }
+}
+
+int Process::write(const std::string &data) {
+
+  if (!ok())
+    return -1;
+
+  // ignore SIGPIPE while writing, in case the child has exited
+  struct sigaction ignore, previous;
+  memset(&ignore, 0, sizeof(ignore));
+  ignore.sa_handler = SIG_IGN;
+  sigemptyset(&ignore.sa_mask);
+  (void)sigaction(SIGPIPE, &ignore, &previous);
+
+  int ret = 0;
+  size_t offset = 0;
+  while (offset < data.size()) {
+
+    // wait until we can write, or the child has output we need to read to
+    // avoid it blocking on us
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(out, &readfds);
+    fd_set writefds;
+    FD_ZERO(&writefds);
+    FD_SET(in, &writefds);
+    if (select(std::max(in, out) + 1, &readfds, &writefds, nullptr, nullptr) <
+        0) {
+      assert(errno == EAGAIN || errno == EINTR);
+      continue;
+    }
+
+    if (FD_ISSET(out, &readfds)) {
+      if (drain() < 0) {
+        ret = -1;
+        break;
+      }
+    }
+
+    if (FD_ISSET(in, &writefds)) {
+      ssize_t w = ::write(in, data.c_str() + offset, data.size() - offset);
+      if (w == -1 && errno != EAGAIN && errno != EINTR) {
+        *debug << "failed to write to child: " << strerror(errno) << '\n';
+        ret = -1;
+        break;
+      }
+      if (w > 0)
+        offset += (size_t)w;
+    }
+  }
+
+  (void)sigaction(SIGPIPE, &previous, nullptr);
+
+  // if communication failed, stop any further attempts
+  if (ret != 0) {
+    (void)close(in);
+    in = -1;
+  }
+
+  return ret;
+}
+
+int Process::fd() const { return out; }
+
+int Process::poll_line(std::string &line) {
+
+  size_t newline = buffered.find('\n');
+
+  // if we do not already have a complete line, see if more output is waiting
+  if (newline == std::string::npos && ok()) {
+    if (drain() < 0) {
+      // stop any further attempts, but return any complete lines remaining
+      (void)close(out);
+      out = -1;
+    }
+    newline = buffered.find('\n');
+  }
+
+  if (newline != std::string::npos) {
+    line = buffered.substr(0, newline);
+    buffered.erase(0, newline + 1);
+    return 1;
+  }
+
+  return ok() ? 0 : -1;
+}
+
 static int __attribute__((unused)) test_process(int argc, char **argv) {
 
   if (argc < 2 || strcmp(argv[1], "--help") == 0 ||
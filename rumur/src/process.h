@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <string>
+#include <sys/types.h>
 #include <vector>
 
 /* Run an external process, pass it the given input on stdin and wait for it to
@@ -10,3 +11,43 @@
  */
 int run(const std::vector<std::string> &args, const std::string &input,
         std::string &output);
+
+/* An external process that runs for as long as this object lives, for
+ * interactive use. Its stdout and stderr are merged into what can be read back.
+ */
+class Process {
+
+private:
+  pid_t pid = -1;
+  int in = -1;  // write end of the child's stdin
+  int out = -1; // read end of the child's stdout and stderr
+
+  // output read from the child but not yet returned by poll_line()
+  std::string buffered;
+
+  // read whatever is available from the child without waiting
+  int drain();
+
+public:
+  explicit Process(const std::vector<std::string> &args);
+  ~Process();
+
+  Process(const Process &) = delete;
+  Process &operator=(const Process &) = delete;
+
+  // was the process successfully started and has no communication failed?
+  bool ok() const;
+
+  // send data to the process's stdin
+  int write(const std::string &data);
+
+  // descriptor that becomes readable when the process has output, for use with
+  // select()
+  int fd() const;
+
+  /* read the next line of output, without its trailing newline, if one is
+   * available without waiting. Returns 1 if a line was read, 0 if none is
+   * available yet, or -1 if the process's output has ended.
+   */
+  int poll_line(std::string &line);
+};
@@ -0,0 +1,163 @@
+#include "cache.h"
+#include "../log.h"
+#include "../options.h"
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace smt {
+
+// can this character appear in an SMT-LIB simple symbol?
+static bool is_symbol_char(char c) {
+  return isalnum(static_cast<unsigned char>(c)) ||
+         strchr("~!@$%^&*_-+=<>.?/", c) != nullptr;
+}
+
+/* Renumber the symbols Rumur generates (see mangle()) in order of their first
+ * appearance. Two queries that differ only in these numbers are the same query
+ * up to renaming and so have the same result.
+ */
+static std::string canonicalise(const std::string &query) {
+
+  std::unordered_map<std::string, size_t> renaming;
+  std::string result;
+
+  for (size_t i = 0; i < query.size();) {
+
+    // copy anything that is not the start of a symbol
+    if (!is_symbol_char(query[i]) || (i > 0 && is_symbol_char(query[i - 1]))) {
+      result += query[i];
+      i++;
+      continue;
+    }
+
+    size_t end = i;
+    while (end < query.size() && is_symbol_char(query[end]))
+      end++;
+    const std::string symbol = query.substr(i, end - i);
+    i = end;
+
+    // is this one of ours, 's' followed by digits?
+    bool generated = symbol.size() > 1 && symbol[0] == 's';
+    for (size_t j = 1; generated && j < symbol.size(); j++)
+      generated = isdigit(static_cast<unsigned char>(symbol[j]));
+
+    if (!generated) {
+      result += symbol;
+      continue;
+    }
+
+    auto it = renaming.find(symbol);
+    if (it == renaming.end())
+      it = renaming.insert({symbol, renaming.size()}).first;
+    result += "s" + std::to_string(it->second);
+  }
+
+  return result;
+}
+
+// FNV-1a, used only to choose a file name as entries store their full query
+static uint64_t hash(const std::string &s) {
+  uint64_t h = UINT64_C(0xcbf29ce484222325);
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= UINT64_C(0x100000001b3);
+  }
+  return h;
+}
+
+// the text identifying a query, including which solver answers it
+static std::string key(const std::string &query) {
+  std::ostringstream k;
+  k << "; " << options.smt.path;
+  for (const std::string &arg : options.smt.args)
+    k << " " << arg;
+  k << "\n" << canonicalise(query);
+  return k.str();
+}
+
+static std::string path_for(const std::string &k) {
+  char name[sizeof("0123456789abcdef")];
+  snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash(k));
+  return options.smt.cache + "/" + name;
+}
+
+bool cache_lookup(const std::string &query, bool &unsat) {
+
+  if (options.smt.cache == "")
+    return false;
+
+  const std::string k = key(query);
+  std::ifstream in(path_for(k));
+  if (!in)
+    return false;
+
+  std::string result;
+  if (!std::getline(in, result))
+    return false;
+
+  const std::string content((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+
+  // guard against a hash collision
+  if (content != k)
+    return false;
+
+  if (result == "sat") {
+    unsat = false;
+  } else if (result == "unsat") {
+    unsat = true;
+  } else {
+    return false;
+  }
+
+  *debug << "using cached SMT result \"" << result << "\"\n";
+  return true;
+}
+
+void cache_store(const std::string &query, bool unsat) {
+
+  if (options.smt.cache == "")
+    return;
+
+  if (mkdir(options.smt.cache.c_str(), 0777) < 0 && errno != EEXIST) {
+    *debug << "failed to create SMT cache directory: " << strerror(errno)
+           << "\n";
+    return;
+  }
+
+  const std::string k = key(query);
+  const std::string path = path_for(k);
+
+  // write to a temporary file and rename it into place, so a concurrent run
+  // never sees a partial entry
+  const std::string tmp = path + "." + std::to_string(getpid());
+  {
+    std::ofstream out(tmp);
+    out << (unsat ? "unsat" : "sat") << "\n" << k;
+    if (!out) {
+      *debug << "failed to write SMT cache entry " << tmp << "\n";
+      (void)remove(tmp.c_str());
+      return;
+    }
+  }
+
+  if (rename(tmp.c_str(), path.c_str()) < 0) {
+    *debug << "failed to write SMT cache entry " << path << ": "
+           << strerror(errno) << "\n";
+    (void)remove(tmp.c_str());
+  }
+}
+
+} // namespace smt
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace smt {
+
+/* A cache of solver results that persists across runs, stored as one file per
+ * query in the directory given by --smt-cache. Queries are identified by their
+ * full text, with symbol names renumbered so that a query is still found when
+ * unrelated edits to the model shift the identifiers Rumur assigns.
+ */
+
+// look up a previous result for this query, returning true if one was found
+bool cache_lookup(const std::string &query, bool &unsat);
+
+// record the result of a query
+void cache_store(const std::string &query, bool unsat);
+
+} // namespace smt
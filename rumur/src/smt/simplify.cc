@@ -10,13 +10,18 @@
 #include "typeexpr-to-smt.h"
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <rumur/rumur.h>
 #include <string>
+#include <unordered_set>
 
 using namespace rumur;
 
 namespace smt {
 
+// unique IDs of array accesses whose index has been proven in bounds
+static std::unordered_set<size_t> in_bounds;
+
 /* Simplification logic. We only attempt to replace tautologies with true and
  * contradictions with false, rather than going further and removing unreachable
  * code. We assume the C compiler building the generated verifier is clever
@@ -106,6 +111,8 @@ public:
 
     simplify(n.array);
     simplify(n.index);
+
+    prove_in_bounds(n);
   }
 
   void visit_enum(Enum &) final {
@@ -448,13 +455,53 @@ private:
       return;
     }
 
-    if (solver->is_true(claim)) {
-      *info << "simplifying \"" << e->to_string() << "\" to true\n";
-      e = make_true();
-    } else if (solver->is_false(claim)) {
-      *info << "simplifying \"" << e->to_string() << "\" to false\n";
-      e = make_false();
+    /* These checks are answered later, once the whole model has been
+     * traversed. Any subexpressions of e are checked before e itself, so e
+     * remains valid until its own checks are answered.
+     */
+    solver->is_true(claim, [&e](bool proven) {
+      if (proven) {
+        *info << "simplifying \"" << e->to_string() << "\" to true\n";
+        e = make_true();
+      }
+    });
+    solver->is_false(claim, [&e](bool proven) {
+      if (proven && !e->is_literal_true()) {
+        *info << "simplifying \"" << e->to_string() << "\" to false\n";
+        e = make_false();
+      }
+    });
+  }
+
+  // try to prove the index of an array access is always within its bounds
+  void prove_in_bounds(const Element &e) {
+
+    const Ptr<TypeExpr> t = e.array->type()->resolve();
+    auto a = dynamic_cast<const Array *>(t.get());
+    assert(a != nullptr && "array access to something that is not an array");
+
+    const Ptr<TypeExpr> index_type = a->index_type->resolve();
+    if (!index_type->constant())
+      return;
+
+    std::string index;
+    try {
+      index = translate(*e.index);
+    } catch (Unsupported &) {
+      return;
     }
+
+    const std::string lb = numeric_literal(index_type->lower_bound());
+    const std::string ub = numeric_literal(index_type->upper_bound());
+    const std::string claim = "(and (" + geq() + " " + index + " " + lb +
+                              ") (" + leq() + " " + index + " " + ub + "))";
+
+    solver->is_true(claim, [&e](bool proven) {
+      if (proven) {
+        *info << "proved index of \"" << e.to_string() << "\" is in bounds\n";
+        in_bounds.insert(e.unique_id);
+      }
+    });
   }
 
   // invent a reference to "true"
@@ -616,14 +663,32 @@ private:
 };
 } // namespace
 
+bool is_index_in_bounds(const Element &e) {
+  if (e.unique_id == SIZE_MAX)
+    return false;
+  return in_bounds.find(e.unique_id) != in_bounds.end();
+}
+
 void simplify(Model &m) {
 
+  // discard anything proven about a previous model
+  in_bounds.clear();
+
   // establish our connection to the solver
   Solver solver;
 
-  // recursively traverse the model, simplifying as we go
+  // recursively traverse the model, collecting what to ask the solver
   Simplifier simplifier(solver);
-  simplifier.dispatch(m);
+  try {
+    simplifier.dispatch(m);
+  } catch (Unsupported &) {
+    // apply what we can learn from the checks made before giving up
+    solver.flush();
+    throw;
+  }
+
+  // ask the solver and simplify based on its answers
+  solver.flush();
 }
 
 } // namespace smt
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <rumur/rumur.h>
 
 namespace smt {
@@ -9,4 +10,9 @@ namespace smt {
  */
 void simplify(rumur::Model &model);
 
+/* Was the index of this array access proven to always be within the bounds of
+ * the array during simplify()?
+ */
+bool is_index_in_bounds(const rumur::Element &e);
+
 } // namespace smt
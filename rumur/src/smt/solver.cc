@@ -2,15 +2,22 @@
 #include "../log.h"
 #include "../options.h"
 #include "../process.h"
+#include "cache.h"
 #include "except.h"
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <gmpxx.h>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <sys/select.h>
+#include <utility>
+#include <vector>
 
 namespace smt {
 
@@ -26,76 +33,237 @@ static mpz_class get_duration(const timestamp_t &start,
   return duration.count() * 1000;
 }
 
-Solver::Result Solver::solve(const std::string &claim, bool expectation) {
+// a marker the solver echoes back after each response
+static const char SENTINEL[] = "rumur-end-of-response";
 
-  if (time_used >= options.smt.budget)
-    throw BudgetExhausted();
+void Solver::queue(const std::string &claim, bool expectation,
+                   const std::function<void(bool)> &done) {
+
+  // note how far each open scope has been written, as later additions are not
+  // part of this query
+  context_t context;
+  for (const std::shared_ptr<std::ostringstream> &scope : prelude)
+    context.emplace_back(scope, static_cast<size_t>(scope->tellp()));
+
+  pending.push_back(Query{context, claim, expectation, done, INCONCLUSIVE});
+}
+
+std::string Solver::canonical(const Query &query) const {
+
+  std::ostringstream text;
+
+  for (const std::string &t : options.smt.prelude)
+    text << t << "\n";
+
+  for (const auto &scope : query.context)
+    text << scope.first->str().substr(0, scope.second);
+
+  text << "(assert " << (query.expectation ? "(not " : "") << query.claim
+       << (query.expectation ? ")" : "") << ")\n"
+       << "(check-sat)\n";
+
+  return text.str();
+}
 
+bool Solver::send(Session &session, size_t index) {
+
+  const Query &q = pending[index];
   std::ostringstream query;
 
-  // disable printing of "success" in response to commands
-  query << "(set-option :print-success false)\n";
+  if (session.process == nullptr) {
 
-  // write any prelude the user requested
-  for (const std::string &text : options.smt.prelude) {
-    query << text << "\n";
-  }
+    // construct the call to the solver
+    std::vector<std::string> args;
+    assert(options.smt.path != "" &&
+           "calling SMT solver without having supplied a path to it");
+    args.push_back(options.smt.path);
+    std::copy(options.smt.args.begin(), options.smt.args.end(),
+              std::back_inserter(args));
 
-  // append the declarations etc
-  for (const std::shared_ptr<std::ostringstream> &scope : prelude)
-    query << scope->str();
+    session.process.reset(new Process(args));
+    if (!session.process->ok()) {
+      *debug << "failed to start SMT solver\n";
+      session.process.reset();
+      return false;
+    }
 
-  // set up the main claim
-  query << "(assert " << (expectation ? "(not " : "") << claim
-        << (expectation ? ")" : "") << ")\n"
-        << "(check-sat)\n";
+    // the solver has seen nothing yet
+    session.sent.clear();
 
-  *debug << "checking SMT problem:\n" << query.str();
+    // disable printing of "success" in response to commands
+    query << "(set-option :print-success false)\n";
 
-  // construct the call to the solver
-  std::vector<std::string> args;
-  assert(options.smt.path != "" &&
-         "calling SMT solver without having supplied a path to it");
-  args.push_back(options.smt.path);
-  std::copy(options.smt.args.begin(), options.smt.args.end(),
-            std::back_inserter(args));
+    // write any prelude the user requested
+    for (const std::string &text : options.smt.prelude) {
+      query << text << "\n";
+    }
+  }
 
-  auto start = get_timestamp();
+  // discard any scopes the solver has that this query is not within
+  size_t common = 0;
+  while (common < session.sent.size() && common < q.context.size() &&
+         session.sent[common].first == q.context[common].first)
+    common++;
+  for (size_t i = common; i < session.sent.size(); i++)
+    query << "(pop 1)\n";
+  session.sent.resize(common);
 
-  std::string output;
-  int r = run(args, query.str(), output);
+  // append the declarations etc the solver has not yet seen
+  for (size_t i = 0; i < q.context.size(); i++) {
+    if (i == session.sent.size()) {
+      query << "(push 1)\n";
+      session.sent.emplace_back(q.context[i].first, 0);
+    }
+    const size_t length = q.context[i].second;
+    if (length > session.sent[i].second) {
+      query << q.context[i].first->str().substr(
+          session.sent[i].second, length - session.sent[i].second);
+      session.sent[i].second = length;
+    }
+  }
 
-  auto end = get_timestamp();
+  // name the main claim so we can check it without asserting it
+  const std::string name = "claim" + std::to_string(claims++);
+  query << "(declare-fun " << name << " () Bool)\n"
+        << "(assert (= " << name << " " << q.claim << "))\n"
+        << "(check-sat-assuming (" << (q.expectation ? "(not " : "") << name
+        << (q.expectation ? ")" : "") << "))\n"
+        << "(echo \"" << SENTINEL << "\")\n";
 
-  time_used += get_duration(start, end);
+  *debug << "checking SMT problem:\n" << query.str();
+
+  session.start = get_timestamp();
 
-  if (r < 0) {
+  if (session.process->write(query.str()) < 0) {
     *debug << "SMT solver error\n";
-    return INCONCLUSIVE;
+    session.process.reset();
+    return false;
   }
 
-  *debug << "SMT solver said:\n" << output;
+  session.query = index;
+  return true;
+}
+
+bool Solver::receive(Session &session) {
+
+  assert(session.query < pending.size() && "receiving for no query");
+  Query &q = pending[session.query];
 
-  // look for a "sat" or "unsat" line
-  std::istringstream ss(output);
-  for (std::string line; std::getline(ss, line);) {
+  for (;;) {
+
+    std::string line;
+    int r = session.process->poll_line(line);
+
+    if (r == 0)
+      return false;
+
+    if (r < 0) {
+      *debug << "SMT solver exited\n";
+      session.process.reset();
+      q.result = INCONCLUSIVE;
+      return true;
+    }
+
+    *debug << "SMT solver said: " << line << "\n";
+
+    if (line == SENTINEL || line == std::string("\"") + SENTINEL + "\"")
+      return true;
+
+    // look for a "sat" or "unsat" line
     if (line == "sat")
-      return SAT;
+      q.result = SAT;
     if (line == "unsat")
-      return UNSAT;
+      q.result = UNSAT;
   }
+}
+
+void Solver::flush() {
+
+  if (sessions.empty())
+    sessions.resize(options.smt.jobs.get_ui());
+
+  bool exhausted = false;
+
+  size_t next = 0;
+  for (;;) {
+
+    // hand out queries to idle solvers
+    for (Session &session : sessions) {
+      while (session.query == SIZE_MAX && next < pending.size()) {
+        Query &q = pending[next];
 
-  *debug << "inconclusive result from SMT solver\n";
+        bool unsat;
+        if (options.smt.cache != "" && cache_lookup(canonical(q), unsat)) {
+          q.result = unsat ? UNSAT : SAT;
+        } else if (time_used >= options.smt.budget) {
+          exhausted = true;
+        } else if (!send(session, next)) {
+          q.result = INCONCLUSIVE;
+        }
+        next++;
+      }
+    }
 
-  return INCONCLUSIVE;
+    // collect what responses we can
+    bool busy = false;
+    bool progressed = false;
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    int nfds = -1;
+    for (Session &session : sessions) {
+      if (session.query == SIZE_MAX)
+        continue;
+
+      if (receive(session)) {
+        time_used += get_duration(session.start, get_timestamp());
+
+        const Query &q = pending[session.query];
+        if (q.result == INCONCLUSIVE) {
+          *debug << "inconclusive result from SMT solver\n";
+        } else if (options.smt.cache != "") {
+          cache_store(canonical(q), q.result == UNSAT);
+        }
+
+        session.query = SIZE_MAX;
+        progressed = true;
+        continue;
+      }
+
+      busy = true;
+      FD_SET(session.process->fd(), &readfds);
+      nfds = std::max(nfds, session.process->fd());
+    }
+
+    if (!busy && next == pending.size())
+      break;
+
+    // wait for a solver to say something
+    if (!progressed && busy) {
+      if (select(nfds + 1, &readfds, nullptr, nullptr, nullptr) < 0) {
+        // if our select call is correct, any “error” should be an interrupt
+        assert(errno == EAGAIN || errno == EINTR);
+      }
+    }
+  }
+
+  // report results in the order the checks were made
+  std::vector<Query> answered;
+  answered.swap(pending);
+  for (const Query &q : answered)
+    q.done(q.result == UNSAT);
+
+  if (exhausted)
+    throw BudgetExhausted();
 }
 
-bool Solver::is_true(const std::string &claim) {
-  return solve(claim, true) == UNSAT;
+void Solver::is_true(const std::string &claim,
+                     const std::function<void(bool)> &done) {
+  queue(claim, true, done);
 }
 
-bool Solver::is_false(const std::string &claim) {
-  return solve(claim, false) == UNSAT;
+void Solver::is_false(const std::string &claim,
+                      const std::function<void(bool)> &done) {
+  queue(claim, false, done);
 }
 
 Solver &Solver::operator<<(const std::string &s) {
@@ -104,11 +272,6 @@ Solver &Solver::operator<<(const std::string &s) {
   return *this;
 }
 
-/* you might think we could just use "(push)" and "(pop)" for scoping, but some
- * SMT solvers only support these in incremental mode and we're calling the
- * solver in one-shot mode
- */
-
 void Solver::open_scope() {
   prelude.push_back(std::make_shared<std::ostringstream>());
 }
@@ -1,11 +1,16 @@
 #pragma once
 
+#include "../process.h"
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <gmpxx.h>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace smt {
@@ -16,24 +21,73 @@ private:
   std::vector<std::shared_ptr<std::ostringstream>> prelude;
   mpz_class time_used = 0;
 
+  /* The prelude as it stood when a query was made: each scope that was open and
+   * how much had been written to it.
+   */
+  typedef std::vector<std::pair<std::shared_ptr<std::ostringstream>, size_t>>
+      context_t;
+
   enum Result { SAT, UNSAT, INCONCLUSIVE };
 
-  /* Using the accrued prelude setup declarations, try to prove that the claim
-   * expression is the expectation. I.e. prove the claim true or false depending
-   * on whether expectation is true or false. For those unfamiliar with SMT
-   * solvers, the way to interpret the result is:
+  /* A query waiting to be answered. Using the context's setup declarations, try
+   * to prove that the claim expression is the expectation. I.e. prove the claim
+   * true or false depending on whether expectation is true or false. For those
+   * unfamiliar with SMT solvers, the way to interpret the result is:
    *  SAT - there is a value(s) for which claim != expectation (proof failed)
    *  UNSAT - for all values claim == expectation (proof succeeded)
    *  INCONCLUSIVE - resource exhaustion, e.g. timeout
    */
-  Result solve(const std::string &claim, bool expectation);
+  struct Query {
+    context_t context;
+    std::string claim;
+    bool expectation;
+    std::function<void(bool)> done;
+    Result result;
+  };
+  std::vector<Query> pending;
+
+  /* A solver process, started when first needed and reused for later queries.
+   * Each scope of the context it was last sent is mirrored by a (push) in the
+   * solver, along with how much of that scope the solver has seen.
+   */
+  struct Session {
+    std::unique_ptr<Process> process;
+    context_t sent;
+    size_t query = SIZE_MAX; // index of the query in progress, if any
+    std::chrono::time_point<std::chrono::system_clock> start;
+  };
+  std::vector<Session> sessions;
+
+  // number of claims checked, used to name them
+  size_t claims = 0;
+
+  void queue(const std::string &claim, bool expectation,
+             const std::function<void(bool)> &done);
+
+  // the text of a query as it would be sent to a fresh solver
+  std::string canonical(const Query &query) const;
+
+  // start a session working on a query, returning false on failure
+  bool send(Session &session, size_t index);
+
+  // read what is available of a session's response, returning true once it is
+  // complete
+  bool receive(Session &session);
 
 public:
-  // can this expression be proven always-true?
-  bool is_true(const std::string &claim);
+  /* queue a check of whether this expression can be proven always-true. The
+   * callback is called with the outcome during flush().
+   */
+  void is_true(const std::string &claim, const std::function<void(bool)> &done);
+
+  // queue a check of whether this expression can be proven always-false
+  void is_false(const std::string &claim,
+                const std::function<void(bool)> &done);
 
-  // can this expression be proven always-false?
-  bool is_false(const std::string &claim);
+  /* answer all queued checks, running up to --smt-jobs solvers in parallel, and
+   * call their callbacks in the order they were queued
+   */
+  void flush();
 
   // add something to the prelude (e.g. a declaration "(declare-fun v () Int)")
   Solver &operator<<(const std::string &s);
@@ -8,6 +8,8 @@
 #include <iostream>
 #include <memory>
 #include <rumur/rumur.h>
+#include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -57,99 +59,38 @@ mpz_class get_schedule_width(const TypeDecl &t) {
   return bit_width(perm);
 }
 
-// Generate application of a swap of two state components
-static void generate_apply_swap(std::ostream &out, const std::string &offset_a,
-                                const std::string &offset_b,
-                                const TypeExpr &type, size_t depth = 0) {
-
-  const Ptr<TypeExpr> t = type.resolve();
-
-  const std::string indent = std::string((depth + 1) * 2, ' ');
-
-  if (t->is_simple()) {
-
-    out << indent << "if (" << offset_a << " != " << offset_b << ") {\n"
-        << indent << "  raw_value_t a = handle_read_raw(s, state_handle(s, "
-        << offset_a << ", " << t->width() << "ull));\n"
-        << indent << "  raw_value_t b = handle_read_raw(s, state_handle(s, "
-        << offset_b << ", " << t->width() << "ull));\n"
-        << indent << "  handle_write_raw(s, state_handle(s, " << offset_b
-        << ", " << t->width() << "ull), a);\n"
-        << indent << "  handle_write_raw(s, state_handle(s, " << offset_a
-        << ", " << t->width() << "ull), b);\n"
-        << indent << "}\n";
-    return;
-  }
-
-  if (auto a = dynamic_cast<const Array *>(t.get())) {
-    const std::string var = "i" + std::to_string(depth);
-    mpz_class ic = a->index_type->count() - 1;
-    const std::string len = "((size_t)" + ic.get_str() + "ull)";
-    const std::string width =
-        "((size_t)" + a->element_type->width().get_str() + "ull)";
-
-    out << indent << "for (size_t " << var << " = 0; " << var << " < " << len
-        << "; " << var << "++) {\n";
-
-    const std::string off_a = offset_a + " + " + var + " * " + width;
-    const std::string off_b = offset_b + " + " + var + " * " + width;
-
-    generate_apply_swap(out, off_a, off_b, *a->element_type, depth + 1);
-
-    out << indent << "}\n";
-    return;
-  }
-
-  if (auto r = dynamic_cast<const Record *>(t.get())) {
-    std::string off_a = offset_a;
-    std::string off_b = offset_b;
-
-    for (const Ptr<VarDecl> &f : r->fields) {
-      generate_apply_swap(out, off_a, off_b, *f->type, depth);
+static bool is_pivot(const TypeDecl &pivot, const TypeExpr *t) {
 
-      off_a += " + ((size_t)" + f->width().get_str() + "ull)";
-      off_b += " + ((size_t)" + f->width().get_str() + "ull)";
-    }
-    return;
-  }
+  if (t == nullptr)
+    return false;
 
-  assert(!isa<Union>(t) && "union type not rejected before symmetry reduction");
+  auto s = dynamic_cast<const TypeExprID *>(t);
+  if (s == nullptr)
+    return false;
 
-  assert(!"missed case in generate_apply_swap");
+  return pivot.name == s->name;
 }
 
-static void generate_swap_chunk(std::ostream &out, const TypeExpr &t,
-                                const std::string &offset,
-                                const TypeDecl &pivot, size_t depth = 0) {
-
-  const std::string indent((depth + 1) * 2, ' ');
+namespace {
 
-  if (t.is_simple()) {
+/* The parts of the state affected by swapping two elements of a scalarset. Each
+ * range is the offset and width of element 0 of an array indexed by the
+ * scalarset. Each run of values is the offset, count and stride of state
+ * components holding values of the scalarset.
+ */
+struct SwapTable {
+  std::vector<std::pair<mpz_class, mpz_class>> ranges;
+  std::vector<std::tuple<mpz_class, mpz_class, mpz_class>> values;
+};
 
-    if (auto s = dynamic_cast<const TypeExprID *>(&t)) {
-      if (s->name == pivot.name) {
-        /* This state component has the same type as the pivot. If its value is
-         * one of the pair we are swapping, we need to change it to the other.
-         */
-
-        const std::string w = "((size_t)" + t.width().get_str() + "ull)";
-        const std::string h = "state_handle(s, " + offset + ", " + w + ")";
-
-        out << indent << "if (x != y) {\n"
-            << indent << "  raw_value_t v = handle_read_raw(s, " << h << ");\n"
-            << indent << "  if (v != 0) {\n"
-            << indent << "    if (v - 1 == (raw_value_t)x) {\n"
-            << indent << "      handle_write_raw(s, " << h << ", y + 1);\n"
-            << indent << "    } else if (v - 1 == (raw_value_t)y) {\n"
-            << indent << "      handle_write_raw(s, " << h << ", x + 1);\n"
-            << indent << "    }\n"
-            << indent << "  }\n"
-            << indent << "}\n";
-      }
-    }
+} // namespace
 
-    // A component of any other simple type is irrelevant.
+static void collect_swaps(SwapTable &table, const TypeExpr &t,
+                          const mpz_class &offset, const TypeDecl &pivot) {
 
+  if (t.is_simple()) {
+    if (is_pivot(pivot, &t))
+      table.values.emplace_back(offset, 1, 0);
     return;
   }
 
@@ -157,45 +98,59 @@ static void generate_swap_chunk(std::ostream &out, const TypeExpr &t,
 
   if (auto a = dynamic_cast<const Array *>(type.get())) {
 
-    const std::string w =
-        "((size_t)" + a->element_type->width().get_str() + "ull)";
-
-    // If this array is indexed by our pivot type, swap the relevant elements
-    auto s = dynamic_cast<const TypeExprID *>(a->index_type.get());
-    if (s != nullptr && s->name == pivot.name) {
+    const mpz_class w = a->element_type->width();
+    const mpz_class count = a->index_type->count() - 1;
 
-      const std::string off_x = offset + " + x * " + w;
-      const std::string off_y = offset + " + y * " + w;
+    // if this array is indexed by our pivot type, its elements need to be
+    // swapped
+    if (is_pivot(pivot, a->index_type.get()))
+      table.ranges.emplace_back(offset, w);
 
-      generate_apply_swap(out, off_x, off_y, *a->element_type, depth);
+    // an array of simple elements can be described by a single run
+    if (a->element_type->is_simple()) {
+      if (is_pivot(pivot, a->element_type.get()))
+        table.values.emplace_back(offset, count, w);
+      return;
     }
 
-    // Descend into its element to allow further swapping
-
-    const std::string i = "i" + std::to_string(depth);
-    mpz_class ic = a->index_type->count() - 1;
-    const std::string len = "((size_t)" + ic.get_str() + "ull)";
-
-    out << indent << "for (size_t " << i << " = 0; " << i << " < " << len
-        << "; " << i << "++) {\n";
-
-    const std::string off = offset + " + " + i + " * " + w;
-
-    generate_swap_chunk(out, *a->element_type, off, pivot, depth + 1);
+    // otherwise find what needs swapping within a single element
+    SwapTable element;
+    collect_swaps(element, *a->element_type, 0, pivot);
+
+    if (element.ranges.empty()) {
+      for (const auto &v : element.values) {
+        const mpz_class &off = std::get<0>(v);
+
+        // a value that occurs once per element is a single run across the
+        // elements
+        if (std::get<1>(v) == 1) {
+          table.values.emplace_back(offset + off, count, w);
+          continue;
+        }
+
+        // a run within a nested array needs repeating for each element
+        for (mpz_class i = 0; i < count; ++i)
+          table.values.emplace_back(offset + i * w + off, std::get<1>(v),
+                                    std::get<2>(v));
+      }
+      return;
+    }
 
-    out << indent << "}\n";
+    // arrays indexed by the pivot within the elements need a range for each
+    // element
+    for (mpz_class i = 0; i < count; ++i)
+      collect_swaps(table, *a->element_type, offset + i * w, pivot);
 
     return;
   }
 
   if (auto r = dynamic_cast<const Record *>(type.get())) {
 
-    std::string off = offset;
+    mpz_class off = offset;
 
     for (const Ptr<VarDecl> &f : r->fields) {
-      generate_swap_chunk(out, *f->type, off, pivot, depth);
-
-      off += " + ((size_t)" + f->width().get_str() + "ull)";
+      collect_swaps(table, *f->type, off, pivot);
+      off += f->width();
     }
     return;
   }
@@ -203,22 +158,83 @@ static void generate_swap_chunk(std::ostream &out, const TypeExpr &t,
   assert(!isa<Union>(type) &&
          "union type not rejected before symmetry reduction");
 
-  assert(!"missed case in generate_swap_chunk");
+  assert(!"missed case in collect_swaps");
 }
 
+/* Generate a function to swap two elements of the pivot scalarset. The state
+ * components this moves are computed upfront into tables, so the swap itself
+ * is a pass over these that moves each array element as a single bit range.
+ */
 static void generate_swap(const Model &m, std::ostream &out,
                           const TypeDecl &pivot) {
 
-  out << "static void swap_" << pivot.name << "("
+  SwapTable table;
+  for (const Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<const VarDecl *>(c.get()))
+      collect_swaps(table, *v->type, v->offset, pivot);
+  }
+
+  const std::string &name = pivot.name;
+
+  if (!table.ranges.empty()) {
+    out << "/* offset and width of element 0 of each array indexed by " << name
+        << " */\n"
+        << "static const size_t swap_ranges_" << name << "[][2] = {\n";
+    for (const auto &r : table.ranges)
+      out << "  {" << r.first.get_str() << "ul, " << r.second.get_str()
+          << "ul},\n";
+    out << "};\n\n";
+  }
+
+  if (!table.values.empty()) {
+    out << "/* offset, count and stride of each run of " << name
+        << " values */\n"
+        << "static const size_t swap_values_" << name << "[][3] = {\n";
+    for (const auto &v : table.values)
+      out << "  {" << std::get<0>(v).get_str() << "ul, "
+          << std::get<1>(v).get_str() << "ul, " << std::get<2>(v).get_str()
+          << "ul},\n";
+    out << "};\n\n";
+  }
+
+  out << "static void swap_" << name << "("
       << "struct state *s __attribute__((unused)), "
       << "size_t x __attribute__((unused)), "
       << "size_t y __attribute__((unused))) {\n";
 
-  for (const Ptr<Node> &c : m.children) {
-    if (auto v = dynamic_cast<const VarDecl *>(c.get())) {
-      std::string offset = "((size_t)" + v->offset.get_str() + "ull)";
-      generate_swap_chunk(out, *v->type, offset, pivot);
-    }
+  if (!table.ranges.empty() || !table.values.empty())
+    out << "  if (x == y) {\n"
+        << "    return;\n"
+        << "  }\n";
+
+  if (!table.ranges.empty())
+    out << "  for (size_t i = 0; i < sizeof(swap_ranges_" << name
+        << ") / sizeof(swap_ranges_" << name << "[0]); ++i) {\n"
+        << "    const size_t offset = swap_ranges_" << name << "[i][0];\n"
+        << "    const size_t width = swap_ranges_" << name << "[i][1];\n"
+        << "    state_swap_bits(s, offset + x * width, offset + y * width, "
+           "width);\n"
+        << "  }\n";
+
+  if (!table.values.empty()) {
+    const Ptr<TypeExpr> type = pivot.value->resolve();
+    const std::string w = "((size_t)" + type->width().get_str() + "ull)";
+    out << "  for (size_t i = 0; i < sizeof(swap_values_" << name
+        << ") / sizeof(swap_values_" << name << "[0]); ++i) {\n"
+        << "    for (size_t j = 0; j < swap_values_" << name
+        << "[i][1]; ++j) {\n"
+        << "      struct handle h = state_handle(s, swap_values_" << name
+        << "[i][0] + j * swap_values_" << name << "[i][2], " << w << ");\n"
+        << "      raw_value_t v = handle_read_raw(s, h);\n"
+        << "      if (v != 0) {\n"
+        << "        if (v - 1 == (raw_value_t)x) {\n"
+        << "          handle_write_raw(s, h, y + 1);\n"
+        << "        } else if (v - 1 == (raw_value_t)y) {\n"
+        << "          handle_write_raw(s, h, x + 1);\n"
+        << "        }\n"
+        << "      }\n"
+        << "    }\n"
+        << "  }\n";
   }
 
   out << "}\n\n";
@@ -248,119 +264,282 @@ static void generate_schedule_writer(std::ostream &out, const TypeDecl &pivot,
       << "}\n";
 }
 
-static void generate_loop_header(const TypeDecl &scalarset, size_t index,
-                                 size_t level, std::ostream &out) {
+// is this type one of the scalarsets eligible for symmetry reduction?
+static bool is_scalarset(const std::vector<const TypeDecl *> &scalarsets,
+                         const TypeExpr *t) {
+  for (const TypeDecl *s : scalarsets) {
+    if (is_pivot(*s, t))
+      return true;
+  }
+  return false;
+}
 
-  const std::string indent(level * 2, ' ');
+/* Generate part of a function to compute a signature for a scalarset element.
+ * The signature is invariant under permutation of any of the scalarsets, so
+ * two elements that can be distinguished by it can never be mapped to one
+ * another by a permutation.
+ */
+static void
+generate_signature_chunk(std::ostream &out, const TypeExpr &t,
+                         const std::string &offset, const TypeDecl &pivot,
+                         const std::vector<const TypeDecl *> &scalarsets,
+                         const std::string &acc, size_t depth = 0) {
 
-  const Ptr<TypeExpr> type = scalarset.value->resolve();
-  auto s = dynamic_cast<const Scalarset *>(type.get());
-  assert(s != nullptr);
+  const std::string indent((depth + 1) * 2, ' ');
 
-  const std::string bound =
-      "((size_t)" + s->bound->constant_fold().get_str() + "ull)";
-  const std::string i = "i" + std::to_string(index);
-
-  out << indent << "if (state_cmp(&candidate, s) < 0) {\n"
-      << indent << "  /* Found a more canonical representation. */\n"
-      << indent << "  memcpy(s, &candidate, sizeof(*s));\n"
-      << indent << "}\n\n"
-
-      << indent << "{\n"
-      << indent << "  size_t stack_" << scalarset.name << "[" << bound
-      << "] = { 0 };\n\n"
-
-      << indent << "  size_t schedule_" << scalarset.name << "[" << bound
-      << "] = { 0 };\n"
-      << indent << "  if (USE_SCALARSET_SCHEDULES) {\n"
-      << indent << "    size_t stack[" << bound << "];\n"
-      << indent << "    size_t index = schedule_read_" << scalarset.name
-      << "(&candidate);\n"
-      << indent << "    index_to_permutation(index, schedule_" << scalarset.name
-      << ", stack, " << bound << ");\n"
-      << indent << "  }\n\n"
-
-      << indent << "  for (size_t " << i << " = 0; " << i << " < " << bound
-      << "; ) {\n"
-      << indent << "    if (stack_" << scalarset.name << "[" << i << "] < " << i
-      << ") {\n"
-      << indent << "      if (" << i << " % 2 == 0) {\n"
-      << indent << "        swap_" << scalarset.name << "(&candidate, 0, " << i
-      << ");\n"
-      << indent << "        size_t tmp = schedule_" << scalarset.name
-      << "[0];\n"
-      << indent << "        schedule_" << scalarset.name << "[0] = schedule_"
-      << scalarset.name << "[" << i << "];\n"
-      << indent << "        schedule_" << scalarset.name << "[" << i
-      << "] = tmp;\n"
-      << indent << "      } else {\n"
-      << indent << "        swap_" << scalarset.name << "(&candidate, stack_"
-      << scalarset.name << "[" << i << "], " << i << ");\n"
-      << indent << "        size_t tmp = schedule_" << scalarset.name
-      << "[stack_" << scalarset.name << "[" << i << "]];\n"
-      << indent << "        schedule_" << scalarset.name << "[stack_"
-      << scalarset.name << "[" << i << "]] = schedule_" << scalarset.name << "["
-      << i << "];\n"
-      << indent << "        schedule_" << scalarset.name << "[" << i
-      << "] = tmp;\n"
-      << indent << "      }\n"
-      << indent
-      << "      /* save selected schedule to map this back for later more\n"
-      << indent << "       * comprehensible counterexample traces\n"
-      << indent << "       */\n"
-      << indent << "      if (USE_SCALARSET_SCHEDULES) {\n"
-      << indent << "        size_t stack[" << bound << "];\n"
-      << indent << "        size_t working[" << bound << "];\n"
-      << indent << "        size_t index = permutation_to_index(schedule_"
-      << scalarset.name << ", stack, working, " << bound << ");\n"
-      << indent << "        schedule_write_" << scalarset.name
-      << "(&candidate, index);\n"
-      << indent << "      }\n";
-}
+  if (t.is_simple()) {
 
-static void generate_loop_footer(const TypeDecl &scalarset, size_t index,
-                                 size_t level, std::ostream &out) {
+    const std::string w = "((size_t)" + t.width().get_str() + "ull)";
+
+    out << indent << "{\n"
+        << indent << "  raw_value_t v = handle_read_raw(s, state_handle(s, "
+        << offset << ", " << w << "));\n"
+        << indent << "  " << acc << " = signature_mix(" << acc << ", ";
+
+    if (is_pivot(pivot, &t)) {
+      // a reference to ourselves, or to another element in a given cell
+      out << "v == 0 ? 0 : v - 1 == (raw_value_t)x ? 1 : 2 + (prev == NULL ? "
+             "0 : prev[(size_t)(v - 1)])";
+    } else if (is_scalarset(scalarsets, &t)) {
+      // the value of another scalarset is arbitrary, so use only whether it is
+      // defined
+      out << "v != 0";
+    } else {
+      out << "(uint64_t)v";
+    }
 
-  const std::string indent(level * 2, ' ');
+    out << ");\n" << indent << "}\n";
+    return;
+  }
 
-  assert(isa<Scalarset>(scalarset.value->resolve()));
+  const Ptr<TypeExpr> type = t.resolve();
 
-  const std::string i = "i" + std::to_string(index);
+  if (auto a = dynamic_cast<const Array *>(type.get())) {
 
-  out << indent << "      stack_" << scalarset.name << "[" << i << "]++;\n"
-      << indent << "      " << i << " = 0;\n"
-      << indent << "    } else {\n"
-      << indent << "      stack_" << scalarset.name << "[" << i << "] = 0;\n"
-      << indent << "      " << i << "++;\n"
-      << indent << "    }\n"
-      << indent << "  }\n"
-      << indent << "}\n";
-}
+    const std::string w =
+        "((size_t)" + a->element_type->width().get_str() + "ull)";
+    mpz_class ic = a->index_type->count() - 1;
+    const std::string len = "((size_t)" + ic.get_str() + "ull)";
+    const std::string i = "i" + std::to_string(depth);
+    const std::string off = offset + " + " + i + " * " + w;
 
-static void generate_loop(const std::vector<const TypeDecl *> &scalarsets,
-                          size_t index, size_t level, std::ostream &out) {
+    if (!is_scalarset(scalarsets, a->index_type.get())) {
+      // the order of elements is fixed, so combine them in order
+      out << indent << "for (size_t " << i << " = 0; " << i << " < " << len
+          << "; " << i << "++) {\n";
+      generate_signature_chunk(out, *a->element_type, off, pivot, scalarsets,
+                               acc, depth + 1);
+      out << indent << "}\n";
+      return;
+    }
 
-  if (index < scalarsets.size() - 1)
-    generate_loop(scalarsets, index + 1, level, out);
+    /* The order of elements changes under permutation, so combine them
+     * commutatively. Each element is tagged with its relationship to the
+     * element whose signature we are computing.
+     */
+    const std::string sum = "sum" + std::to_string(depth);
+    const std::string e = "e" + std::to_string(depth);
+    out << indent << "{\n"
+        << indent << "  uint64_t " << sum << " = 0;\n"
+        << indent << "  for (size_t " << i << " = 0; " << i << " < " << len
+        << "; " << i << "++) {\n"
+        << indent << "    uint64_t " << e << " = ";
+    if (is_pivot(pivot, a->index_type.get())) {
+      out << i << " == x ? 1 : 2 + (prev == NULL ? 0 : prev[" << i << "])";
+    } else {
+      out << "0";
+    }
+    out << ";\n";
+    generate_signature_chunk(out, *a->element_type, off, pivot, scalarsets, e,
+                             depth + 2);
+    out << indent << "    " << sum << " += signature_mix(0, " << e << ");\n"
+        << indent << "  }\n"
+        << indent << "  " << acc << " = signature_mix(" << acc << ", " << sum
+        << ");\n"
+        << indent << "}\n";
+    return;
+  }
+
+  if (auto r = dynamic_cast<const Record *>(type.get())) {
 
-  generate_loop_header(*scalarsets[index], index, level, out);
+    std::string off = offset;
 
-  if (index < scalarsets.size() - 1) {
-    generate_loop(scalarsets, index + 1, level + 3, out);
-  } else {
-    const std::string indent((level + 3) * 2, ' ');
+    for (const Ptr<VarDecl> &f : r->fields) {
+      generate_signature_chunk(out, *f->type, off, pivot, scalarsets, acc,
+                               depth);
+
+      off += " + ((size_t)" + f->width().get_str() + "ull)";
+    }
+    return;
+  }
+
+  assert(!isa<Union>(type) &&
+         "union type not rejected before symmetry reduction");
+
+  assert(!"missed case in generate_signature_chunk");
+}
+
+/* Generate a function to compute the signature of an element of the given
+ * scalarset. If prev is non-null, it contains the signatures of all elements
+ * from a prior round, and is used to refine the result.
+ */
+static void generate_signature(std::ostream &out, const TypeDecl &pivot,
+                               const std::vector<const TypeDecl *> &scalarsets,
+                               const Model &m) {
+
+  out << "static uint64_t signature_" << pivot.name
+      << "(const struct state *NONNULL s, size_t x, "
+      << "const uint64_t *prev __attribute__((unused))) {\n"
+      << "\n"
+      << "  uint64_t h = prev == NULL ? 0 : prev[x];\n"
+      << "\n";
 
-    out << indent << "if (state_cmp(&candidate, s) < 0) {\n"
-        << indent << "  /* Found a more canonical representation. */\n"
-        << indent << "  memcpy(s, &candidate, sizeof(*s));\n"
-        << indent << "}\n\n";
+  for (const Ptr<Node> &c : m.children) {
+    if (auto v = dynamic_cast<const VarDecl *>(c.get())) {
+      const std::string offset = "((size_t)" + v->offset.get_str() + "ull)";
+      generate_signature_chunk(out, *v->type, offset, pivot, scalarsets, "h");
+    }
   }
 
-  generate_loop_footer(*scalarsets[index], index, level, out);
+  out << "\n"
+      << "  return h;\n"
+      << "}\n\n";
+}
+
+/* Generate a function to compute the signatures of all elements of the given
+ * scalarset, iteratively refining them until this no longer distinguishes any
+ * further elements.
+ */
+static void generate_refine(std::ostream &out, const TypeDecl &pivot) {
+
+  const Ptr<TypeExpr> type = pivot.value->resolve();
+  auto s = dynamic_cast<const Scalarset *>(type.get());
+  assert(s != nullptr);
+
+  const std::string bound =
+      "((size_t)" + s->bound->constant_fold().get_str() + "ull)";
+
+  out << "static void refine_" << pivot.name
+      << "(const struct state *NONNULL s, uint64_t *NONNULL signature) {\n"
+      << "  for (size_t x = 0; x < " << bound << "; ++x) {\n"
+      << "    signature[x] = signature_" << pivot.name << "(s, x, NULL);\n"
+      << "  }\n"
+      << "  size_t cells = count_distinct(signature, " << bound << ");\n"
+      << "  while (cells < " << bound << ") {\n"
+      << "    uint64_t prev[" << bound << "];\n"
+      << "    memcpy(prev, signature, sizeof(prev));\n"
+      << "    for (size_t x = 0; x < " << bound << "; ++x) {\n"
+      << "      signature[x] = signature_" << pivot.name << "(s, x, prev);\n"
+      << "    }\n"
+      << "    size_t c = count_distinct(signature, " << bound << ");\n"
+      << "    if (c <= cells) {\n"
+      << "      break;\n"
+      << "    }\n"
+      << "    cells = c;\n"
+      << "  }\n"
+      << "}\n\n";
+}
+
+/* Generate a function to enumerate permutations of a scalarset that only
+ * exchange elements with equal signatures.
+ */
+static void generate_permute(std::ostream &out, const TypeDecl &pivot,
+                             const std::vector<const TypeDecl *> &scalarsets,
+                             size_t index) {
+
+  const Ptr<TypeExpr> type = pivot.value->resolve();
+  auto s = dynamic_cast<const Scalarset *>(type.get());
+  assert(s != nullptr);
+
+  const std::string bound =
+      "((size_t)" + s->bound->constant_fold().get_str() + "ull)";
+  const std::string &name = pivot.name;
+
+  out << "static void permute_" << name
+      << "(struct state *NONNULL candidate, struct state *NONNULL best, "
+      << "size_t i) {\n"
+      << "  if (i == " << bound << ") {\n";
+  if (index + 1 < scalarsets.size()) {
+    out << "    permute_" << scalarsets[index + 1]->name
+        << "(candidate, best, 0);\n";
+  } else {
+    out << "    if (state_cmp(candidate, best) < 0) {\n"
+        << "      /* Found a more canonical representation. */\n"
+        << "      memcpy(best->data, candidate->data, sizeof(best->data));\n";
+    for (const TypeDecl *t : scalarsets)
+      out << "      memcpy(best_schedule_" << t->name << ", schedule_"
+          << t->name << ", sizeof(best_schedule_" << t->name << "));\n";
+    out << "    }\n";
+  }
+  out << "    return;\n"
+      << "  }\n"
+      << "  unsigned char original[sizeof(candidate->data)];\n"
+      << "  memcpy(original, candidate->data, sizeof(original));\n"
+      << "  for (size_t j = i; j < " << bound << " && cell_" << name
+      << "[j] == cell_" << name << "[i]; ++j) {\n"
+      << "    if (j != i) {\n"
+      << "      swap_" << name << "(candidate, i, j);\n"
+      << "      size_t tmp = schedule_" << name << "[i];\n"
+      << "      schedule_" << name << "[i] = schedule_" << name << "[j];\n"
+      << "      schedule_" << name << "[j] = tmp;\n"
+      << "    }\n"
+      << "    /* If exchanging these elements has no effect, they are\n"
+      << "     * interchangeable and this branch would only repeat the first.\n"
+      << "     */\n"
+      << "    if (j == i || memcmp(original, candidate->data, "
+      << "sizeof(original)) != 0) {\n"
+      << "      permute_" << name << "(candidate, best, i + 1);\n"
+      << "    }\n"
+      << "    if (j != i) {\n"
+      << "      swap_" << name << "(candidate, i, j);\n"
+      << "      size_t tmp = schedule_" << name << "[i];\n"
+      << "      schedule_" << name << "[i] = schedule_" << name << "[j];\n"
+      << "      schedule_" << name << "[j] = tmp;\n"
+      << "    }\n"
+      << "  }\n"
+      << "}\n\n";
 }
 
+/* Exhaustive symmetry reduction uses a partition refinement approach. Each
+ * scalarset's elements are assigned a signature that is invariant under
+ * permutation. The elements are then sorted by signature, splitting them into
+ * cells of elements with equal signatures. Only permutations within these
+ * cells are tried, selecting the least resulting state. As any permutation of
+ * a state yields the same set of candidates, the result is an exact canonical
+ * representation, but when elements are distinguishable by their signatures
+ * far fewer than the factorial number of permutations need to be tried.
+ */
 static void generate_canonicalise_exhaustive(
-    const std::vector<const TypeDecl *> &scalarsets, std::ostream &out) {
+    const Model &m, const std::vector<const TypeDecl *> &scalarsets,
+    std::ostream &out) {
+
+  for (const TypeDecl *t : scalarsets) {
+
+    const Ptr<TypeExpr> type = t->value->resolve();
+    auto s = dynamic_cast<const Scalarset *>(type.get());
+    assert(s != nullptr);
+
+    const std::string bound =
+        "((size_t)" + s->bound->constant_fold().get_str() + "ull)";
+
+    out << "/* first position of the cell each position belongs to */\n"
+        << "static _Thread_local size_t cell_" << t->name << "[" << bound
+        << "];\n"
+        << "/* permutation applied to the current candidate */\n"
+        << "static _Thread_local size_t schedule_" << t->name << "[" << bound
+        << "];\n"
+        << "/* permutation applied to the best candidate found */\n"
+        << "static _Thread_local size_t best_schedule_" << t->name << "["
+        << bound << "];\n\n";
+
+    generate_signature(out, *t, scalarsets, m);
+    generate_refine(out, *t);
+  }
+
+  // generate the enumeration functions in reverse so each is defined before
+  // its caller
+  for (size_t i = scalarsets.size(); i > 0; --i)
+    generate_permute(out, *scalarsets[i - 1], scalarsets, i - 1);
 
   // Write the function prelude
   out << "static void state_canonicalise_exhaustive(struct state *s "
@@ -376,23 +555,93 @@ static void generate_canonicalise_exhaustive(
         << "  memcpy(&candidate, s, sizeof(candidate));\n"
         << "\n";
 
-    generate_loop(scalarsets, 0, 1, out);
-  }
+    for (const TypeDecl *t : scalarsets) {
 
-  // Write the function coda
-  out << "}\n\n";
-}
+      const Ptr<TypeExpr> type = t->value->resolve();
+      auto s = dynamic_cast<const Scalarset *>(type.get());
+      assert(s != nullptr);
+
+      const std::string bound =
+          "((size_t)" + s->bound->constant_fold().get_str() + "ull)";
+      const std::string &name = t->name;
+
+      out << "  {\n"
+          << "    uint64_t signature[" << bound << "];\n"
+          << "    refine_" << name << "(&candidate, signature);\n"
+          << "\n"
+          << "    for (size_t i = 0; i < " << bound << "; ++i) {\n"
+          << "      schedule_" << name << "[i] = i;\n"
+          << "    }\n"
+          << "    if (USE_SCALARSET_SCHEDULES) {\n"
+          << "      size_t stack[" << bound << "];\n"
+          << "      size_t index = schedule_read_" << name
+          << "(&candidate);\n"
+          << "      index_to_permutation(index, schedule_" << name
+          << ", stack, " << bound << ");\n"
+          << "    }\n"
+          << "\n"
+          << "    /* order the elements by their signatures */\n"
+          << "    for (size_t i = 0; i < " << bound << "; ++i) {\n"
+          << "      size_t min = i;\n"
+          << "      for (size_t j = i + 1; j < " << bound << "; ++j) {\n"
+          << "        if (signature[j] < signature[min]) {\n"
+          << "          min = j;\n"
+          << "        }\n"
+          << "      }\n"
+          << "      if (min != i) {\n"
+          << "        swap_" << name << "(&candidate, i, min);\n"
+          << "        uint64_t tmp = signature[i];\n"
+          << "        signature[i] = signature[min];\n"
+          << "        signature[min] = tmp;\n"
+          << "        size_t tmp2 = schedule_" << name << "[i];\n"
+          << "        schedule_" << name << "[i] = schedule_" << name
+          << "[min];\n"
+          << "        schedule_" << name << "[min] = tmp2;\n"
+          << "      }\n"
+          << "    }\n"
+          << "\n"
+          << "    /* group elements with equal signatures into cells */\n"
+          << "    for (size_t i = 0; i < " << bound << "; ++i) {\n"
+          << "      cell_" << name << "[i] = i > 0 && signature[i] == "
+          << "signature[i - 1] ? cell_" << name << "[i - 1] : i;\n"
+          << "    }\n"
+          << "\n"
+          << "    memcpy(best_schedule_" << name << ", schedule_" << name
+          << ", sizeof(best_schedule_" << name << "));\n"
+          << "  }\n"
+          << "\n";
+    }
 
-static bool is_pivot(const TypeDecl &pivot, const TypeExpr *t) {
+    out << "  /* try all permutations within the cells */\n"
+        << "  memcpy(s->data, candidate.data, sizeof(s->data));\n"
+        << "  permute_" << scalarsets[0]->name << "(&candidate, s, 0);\n"
+        << "\n"
+        << "  /* save selected schedules to map this back for later more\n"
+        << "   * comprehensible counterexample traces\n"
+        << "   */\n"
+        << "  if (USE_SCALARSET_SCHEDULES) {\n";
+    for (const TypeDecl *t : scalarsets) {
 
-  if (t == nullptr)
-    return false;
+      const Ptr<TypeExpr> type = t->value->resolve();
+      auto s = dynamic_cast<const Scalarset *>(type.get());
+      assert(s != nullptr);
 
-  auto s = dynamic_cast<const TypeExprID *>(t);
-  if (s == nullptr)
-    return false;
+      const std::string bound =
+          "((size_t)" + s->bound->constant_fold().get_str() + "ull)";
 
-  return pivot.name == s->name;
+      out << "    {\n"
+          << "      size_t stack[" << bound << "];\n"
+          << "      size_t working[" << bound << "];\n"
+          << "      size_t index = permutation_to_index(best_schedule_"
+          << t->name << ", stack, working, " << bound << ");\n"
+          << "      schedule_write_" << t->name << "(s, index);\n"
+          << "    }\n";
+    }
+    out << "  }\n";
+  }
+
+  // Write the function coda
+  out << "}\n\n";
 }
 
 // Generate application of a comparison of two state components
@@ -671,6 +920,55 @@ static void generate_sort(std::ostream &out, const TypeDecl &pivot) {
       << "}\n";
 }
 
+// the number of elements in each scalarset, as C code strings
+static std::vector<std::string>
+get_bounds(const std::vector<const TypeDecl *> &scalarsets) {
+  std::vector<std::string> bounds;
+  for (const TypeDecl *t : scalarsets) {
+    const Ptr<TypeExpr> type = t->value->resolve();
+    auto s = dynamic_cast<const Scalarset *>(type.get());
+    assert(s != nullptr);
+    mpz_class bound = s->count() - 1;
+    bounds.push_back("((size_t)" + bound.get_str() + "ull)");
+  }
+  return bounds;
+}
+
+/* Generate code to fold the permutation_<scalarset> arrays, the permutation
+ * canonicalisation applied to each scalarset, into the state's schedules.
+ */
+static void
+generate_schedule_update(std::ostream &out,
+                         const std::vector<const TypeDecl *> &scalarsets,
+                         const std::vector<std::string> &bounds) {
+
+  out << "  /* save selected schedule to map this back for later more\n"
+      << "   * comprehensible counterexample traces\n"
+      << "   */\n"
+      << "  if (USE_SCALARSET_SCHEDULES) {\n";
+
+  for (size_t i = 0; i < scalarsets.size(); ++i) {
+    const std::string &name = scalarsets[i]->name;
+    const std::string &b = bounds[i];
+    out << "    {\n"
+        << "      size_t schedule[" << b << "];\n"
+        << "      size_t stack[" << b << "];\n"
+        << "      size_t index = schedule_read_" << name << "(s);\n"
+        << "      index_to_permutation(index, schedule, stack, " << b << ");\n"
+        << "      size_t composed[" << b << "];\n"
+        << "      for (size_t i = 0; i < " << b << "; ++i) {\n"
+        << "        composed[i] = schedule[permutation_" << name << "[i]];\n"
+        << "      }\n"
+        << "      size_t working[" << b << "];\n"
+        << "      index = permutation_to_index(composed, stack, working, " << b
+        << ");\n"
+        << "      schedule_write_" << name << "(s, index);\n"
+        << "    }\n";
+  }
+
+  out << "  }\n";
+}
+
 static void
 generate_canonicalise_heuristic(const Model &m,
                                 const std::vector<const TypeDecl *> &scalarsets,
@@ -681,46 +979,166 @@ generate_canonicalise_heuristic(const Model &m,
     generate_sort(out, *t);
   }
 
+  const std::vector<std::string> bounds = get_bounds(scalarsets);
+
+  /* Generate a cache of canonicalisation results. Each entry records a state
+   * and the permutation of each scalarset that canonicalised it, as well as
+   * the resulting canonical state.
+   */
+  const bool use_cache = !scalarsets.empty() &&
+                         options.canonicalisation_cache > 0;
+
+  if (!scalarsets.empty()) {
+    out << "struct canonicalisation_cache_entry {\n"
+        << "  bool valid;\n"
+        << "  uint8_t raw[sizeof(((struct state *)NULL)->data)];\n"
+        << "  uint8_t canonical[sizeof(((struct state *)NULL)->data)];\n";
+    for (size_t i = 0; i < scalarsets.size(); ++i)
+      out << "  size_t permutation_" << scalarsets[i]->name << "["
+          << bounds[i] << "];\n";
+    out << "};\n\n";
+  }
+
   out << "static void state_canonicalise_heuristic(struct state *s "
          "__attribute__((unused))) {\n"
       << "\n"
       << "  assert(s != NULL && \"attempt to canonicalise NULL state\");\n"
       << "\n";
 
-  for (const TypeDecl *t : scalarsets) {
+  if (!scalarsets.empty()) {
 
-    const Ptr<TypeExpr> type = t->value->resolve();
-    auto s = dynamic_cast<const Scalarset *>(type.get());
-    assert(s != nullptr);
+    out << "  /* the permutation we apply to each scalarset */\n";
+    for (size_t i = 0; i < scalarsets.size(); ++i)
+      out << "  size_t permutation_" << scalarsets[i]->name << "["
+          << bounds[i] << "];\n";
+    out << "\n"
+        << "  struct canonicalisation_cache_entry *entry "
+           "__attribute__((unused)) = NULL;\n";
+    if (use_cache) {
+      out << "\n"
+          << "  /* look for a previous result for this state */\n"
+          << "  if (canonicalisation_cache == NULL) {\n"
+          << "    canonicalisation_cache =\n"
+          << "        xcalloc(CANONICALISATION_CACHE_SIZE,\n"
+          << "                sizeof(canonicalisation_cache[0]));\n"
+          << "  }\n"
+          << "  entry = &canonicalisation_cache[state_hash(s) % "
+             "CANONICALISATION_CACHE_SIZE];\n"
+          << "  canonicalisation_cache_lookups_local++;\n"
+          << "  if (entry->valid && memcmp(entry->raw, s->data, "
+             "sizeof(s->data)) == 0) {\n"
+          << "    canonicalisation_cache_hits_local++;\n"
+          << "    memcpy(s->data, entry->canonical, sizeof(s->data));\n";
+      for (const TypeDecl *t : scalarsets)
+        out << "    memcpy(permutation_" << t->name << ", entry->permutation_"
+            << t->name << ", sizeof(permutation_" << t->name << "));\n";
+      out << "  } else {\n"
+          << "    entry->valid = false;\n"
+          << "    memcpy(entry->raw, s->data, sizeof(s->data));\n"
+          << "  }\n";
+    }
+    out << "\n"
+        << "  if (entry == NULL || !entry->valid) {\n";
+
+    for (size_t i = 0; i < scalarsets.size(); ++i) {
+      const std::string &name = scalarsets[i]->name;
+      out << "    for (size_t i = 0; i < " << bounds[i] << "; ++i) {\n"
+          << "      permutation_" << name << "[i] = i;\n"
+          << "    }\n"
+          << "    sort_" << name << "(s, permutation_" << name << ", 0, "
+          << bounds[i] << " - 1);\n";
+    }
 
-    mpz_class bound = s->count() - 1;
+    if (use_cache) {
+      out << "    memcpy(entry->canonical, s->data, sizeof(s->data));\n";
+      for (const TypeDecl *t : scalarsets)
+        out << "    memcpy(entry->permutation_" << t->name << ", permutation_"
+            << t->name << ", sizeof(permutation_" << t->name << "));\n";
+      out << "    entry->valid = true;\n";
+    }
+    out << "  }\n"
+        << "\n";
+    generate_schedule_update(out, scalarsets, bounds);
+  }
 
-    out << "  {\n"
-        << "    size_t schedule[(size_t)" << bound.get_str() << "ull];\n"
-        << "    for (size_t i = 0; i < sizeof(schedule) / sizeof(schedule[0]); "
-        << "++i) {\n"
-        << "      schedule[i] = i;\n"
-        << "    }\n"
-        << "    if (USE_SCALARSET_SCHEDULES) {\n"
-        << "      size_t index = schedule_read_" << t->name << "(s);\n"
-        << "      size_t stack[(size_t)" << bound.get_str() << "ull];\n"
-        << "      index_to_permutation(index, schedule, stack, "
-        << bound.get_str() << "ull);\n"
-        << "    }\n"
-        << "    sort_" << t->name << "(s, schedule, 0, ((size_t)"
-        << bound.get_str() << "ull) - 1);\n"
-        << "    /* save selected schedule to map this back for later more\n"
-        << "     * comprehensible counterexample traces\n"
-        << "     */\n"
-        << "    if (USE_SCALARSET_SCHEDULES) {\n"
-        << "      size_t stack[(size_t)" << bound.get_str() << "ull];\n"
-        << "      size_t working[(size_t)" << bound.get_str() << "ull];\n"
-        << "      size_t index = permutation_to_index(schedule, stack, "
-           "working, "
-        << bound.get_str() << "ull);\n"
-        << "      schedule_write_" << t->name << "(s, index);\n"
+  out << "}\n\n";
+}
+
+/* Generate a canonicalisation function using multiple representatives. This
+ * starts from the result of the heuristic sort and then performs a bounded
+ * local search, trying to transpose pairs of elements within each run the sort
+ * could not distinguish. Any transposition yielding a smaller state is kept.
+ * Each state maps to one of a small number of representatives of its
+ * equivalence class, rather than the single representative exhaustive
+ * canonicalisation finds. This catches many of the duplicates the heuristic
+ * misses at a fraction of the cost of exhaustive canonicalisation.
+ */
+static void
+generate_canonicalise_multi(const std::vector<const TypeDecl *> &scalarsets,
+                            std::ostream &out) {
+
+  out << "static void state_canonicalise_multi(struct state *s "
+         "__attribute__((unused))) {\n"
+      << "\n"
+      << "  assert(s != NULL && \"attempt to canonicalise NULL state\");\n"
+      << "\n";
+
+  if (!scalarsets.empty()) {
+
+    const std::vector<std::string> bounds = get_bounds(scalarsets);
+
+    out << "  /* the permutation we apply to each scalarset */\n";
+    for (size_t i = 0; i < scalarsets.size(); ++i)
+      out << "  size_t permutation_" << scalarsets[i]->name << "["
+          << bounds[i] << "];\n";
+    out << "\n"
+        << "  /* start from the heuristic's representative */\n";
+    for (size_t i = 0; i < scalarsets.size(); ++i) {
+      const std::string &name = scalarsets[i]->name;
+      out << "  for (size_t i = 0; i < " << bounds[i] << "; ++i) {\n"
+          << "    permutation_" << name << "[i] = i;\n"
+          << "  }\n"
+          << "  sort_" << name << "(s, permutation_" << name << ", 0, "
+          << bounds[i] << " - 1);\n";
+    }
+
+    out << "\n"
+        << "  /* search for a smaller state reachable by transposing elements "
+           "the sort\n"
+        << "   * considered equal, which are adjacent after sorting\n"
+        << "   */\n"
+        << "  uint8_t original[sizeof(s->data)];\n"
+        << "  for (size_t round = 0; round < MULTI_REPRESENTATIVE_ROUNDS; "
+           "++round) {\n"
+        << "    bool improved = false;\n";
+    for (size_t i = 0; i < scalarsets.size(); ++i) {
+      const std::string &name = scalarsets[i]->name;
+      out << "    for (size_t i = 0; i + 1 < " << bounds[i] << "; ++i) {\n"
+          << "      for (size_t j = i + 1; j < " << bounds[i] << "; ++j) {\n"
+          << "        if (compare_" << name << "(s, i, j) != 0) {\n"
+          << "          break;\n"
+          << "        }\n"
+          << "        memcpy(original, s->data, sizeof(s->data));\n"
+          << "        swap_" << name << "(s, i, j);\n"
+          << "        if (memcmp(s->data, original, sizeof(s->data)) < 0) {\n"
+          << "          size_t tmp = permutation_" << name << "[i];\n"
+          << "          permutation_" << name << "[i] = permutation_" << name
+          << "[j];\n"
+          << "          permutation_" << name << "[j] = tmp;\n"
+          << "          improved = true;\n"
+          << "        } else {\n"
+          << "          memcpy(s->data, original, sizeof(s->data));\n"
+          << "        }\n"
+          << "      }\n"
+          << "    }\n";
+    }
+    out << "    if (!improved) {\n"
+        << "      break;\n"
         << "    }\n"
-        << "  }\n";
+        << "  }\n"
+        << "\n";
+
+    generate_schedule_update(out, scalarsets, bounds);
   }
 
   out << "}\n\n";
@@ -747,7 +1165,9 @@ void generate_canonicalise(const Model &m, std::ostream &out) {
     }
   }
 
-  generate_canonicalise_exhaustive(scalarsets, out);
+  generate_canonicalise_exhaustive(m, scalarsets, out);
 
   generate_canonicalise_heuristic(m, scalarsets, out);
+
+  generate_canonicalise_multi(scalarsets, out);
 }
@@ -0,0 +1,24 @@
+-- Similar to assume-statement2.m, but with the assumption inside a start state.
+
+var
+  x: 0 .. 2
+
+startstate begin
+  x := 0;
+end
+
+startstate begin
+  x := 2;
+  assume x != 2;
+end
+
+rule x > 0 ==> begin
+  x := x - 1;
+end
+
+rule x < 1 ==> begin
+  x := x + 1;
+end
+
+-- if the assumption is working correctly, this invariant should pass
+invariant x != 2
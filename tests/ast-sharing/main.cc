@@ -0,0 +1,162 @@
+/// @file
+/// @brief Test and benchmark structural sharing of AST nodes
+///
+/// Copies of `rumur::Ptr` share their target until one of them is modified, and
+/// symbol lookups share the declaration they resolve to rather than copying it.
+/// This tester checks these properties hold and times the front end on a large
+/// synthetic model. It takes an optional argument of how many rules to put in
+/// the model, for use as a benchmark. The default is small enough to run as
+/// part of the test suite.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <rumur/rumur.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rumur;
+
+// number of fields in the record type the synthetic model uses
+static const size_t FIELDS = 64;
+
+/// generate a model with the given number of rules, each of which reference a
+/// large record type through a variable and have a moderately sized body
+static std::string synthesise(size_t rules) {
+  std::ostringstream m;
+
+  m << "const N: 4;\n"
+    << "type index_t: 0 .. N - 1;\n"
+    << "type value_t: 0 .. 7;\n"
+    << "type record_t: record\n";
+  for (size_t i = 0; i < FIELDS; ++i)
+    m << "  f" << i << ": value_t;\n";
+  m << "end;\n"
+    << "var s: array[index_t] of record_t;\n"
+    << "function bump(v: value_t): value_t; begin\n"
+    << "  if v = 7 then return 0; else return v + 1; endif;\n"
+    << "end;\n"
+    << "startstate begin\n"
+    << "  for i: index_t do\n";
+  for (size_t i = 0; i < FIELDS; ++i)
+    m << "    s[i].f" << i << " := 0;\n";
+  m << "  end;\n"
+    << "end;\n";
+
+  for (size_t r = 0; r < rules; ++r) {
+    const size_t f = r % FIELDS;
+    const size_t g = (r * 7 + 3) % FIELDS;
+    m << "ruleset i: index_t; j: index_t do\n"
+      << "  rule \"r" << r << "\" s[i].f" << f << " < 7 & s[j].f" << g
+      << " > 0 ==>\n"
+      << "    var t: value_t;\n"
+      << "  begin\n"
+      << "    t := bump(s[i].f" << f << ");\n"
+      << "    s[i].f" << f << " := t;\n"
+      << "    s[j].f" << g << " := s[j].f" << g << " - 1;\n"
+      << "    if s[i].f" << g << " = s[j].f" << f << " then\n"
+      << "      s[i].f" << g << " := bump(s[j].f" << f << ");\n"
+      << "    endif;\n"
+      << "  end;\n"
+      << "end;\n";
+  }
+
+  return m.str();
+}
+
+// milliseconds since the given time point
+static long long elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+
+  size_t rules = 500;
+  if (argc > 1)
+    rules = strtoul(argv[1], nullptr, 10);
+
+  const std::string src = synthesise(rules);
+
+  auto start = std::chrono::steady_clock::now();
+  std::istringstream in(src);
+  Ptr<Model> m = parse_model(in);
+  std::cout << "parsed " << rules << " rules in " << elapsed(start) << "ms\n";
+
+  start = std::chrono::steady_clock::now();
+  m->reindex();
+  resolve_symbols(*m);
+  validate(*m);
+  std::cout << "resolved and validated in " << elapsed(start) << "ms\n";
+
+  // flattening, as the code generator does repeatedly
+  start = std::chrono::steady_clock::now();
+  size_t flat = 0;
+  for (size_t i = 0; i < 10; ++i) {
+    for (const Ptr<Node> &c : m->children) {
+      if (auto r = dynamic_cast<const Rule *>(c.get()))
+        flat += r->flatten().size();
+    }
+  }
+  std::cout << "flattened 10 times in " << elapsed(start) << "ms\n";
+  // each ruleset contains a single rule, plus there is the start state
+  if (flat != 10 * (rules + 1)) {
+    std::cerr << "expected " << 10 * (rules + 1) << " flattened rules, got "
+              << flat << "\n";
+    return EXIT_FAILURE;
+  }
+
+  const Model &model = *m;
+
+  // a variable's type should share the declaration it refers to
+  const TypeDecl *record_t = nullptr;
+  const VarDecl *s = nullptr;
+  for (const Ptr<Node> &c : model.children) {
+    if (auto t = dynamic_cast<const TypeDecl *>(c.get())) {
+      if (t->name == "record_t")
+        record_t = t;
+    }
+    if (auto v = dynamic_cast<const VarDecl *>(c.get()))
+      s = v;
+  }
+  if (record_t == nullptr || s == nullptr) {
+    std::cerr << "declarations not found in synthesised model\n";
+    return EXIT_FAILURE;
+  }
+  auto array = dynamic_cast<const Array *>(s->type.get());
+  if (array == nullptr) {
+    std::cerr << "unexpected type for s\n";
+    return EXIT_FAILURE;
+  }
+  auto element = dynamic_cast<const TypeExprID *>(array->element_type.get());
+  if (element == nullptr) {
+    std::cerr << "unexpected element type for s\n";
+    return EXIT_FAILURE;
+  }
+  const Ptr<TypeDecl> &referent = element->referent;
+  if (referent.get() != record_t) {
+    std::cerr << "type lookup copied its declaration instead of sharing it\n";
+    return EXIT_FAILURE;
+  }
+
+  // a copy should share until modified, and modifying it should not affect the
+  // original
+  Ptr<Model> copy = m;
+  const Ptr<Model> &const_copy = copy;
+  if (const_copy.get() != &model) {
+    std::cerr << "copying a pointer copied its target\n";
+    return EXIT_FAILURE;
+  }
+  const size_t children = model.children.size();
+  copy->children.pop_back();
+  if (model.children.size() != children ||
+      const_copy->children.size() != children - 1) {
+    std::cerr << "modifying a copy was not isolated from the original\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,31 @@
+-- rumur_flags: ['--auto-undefine', 'on']
+-- checker_output: None if xml else re.compile(r'\b4 states\b')
+
+-- This model exercises automatic resetting of dead state variables. The
+-- variable tmp is always written before it is read, so its value at the end of
+-- a transition is irrelevant. Without resetting it, the model would have 7
+-- states instead of 4.
+
+var
+  x: 0 .. 3;
+  tmp: 0 .. 3;
+
+startstate begin
+  x := 0;
+  tmp := 0;
+end;
+
+rule begin
+  tmp := 3 - x;
+  x := (x + 1) % 4;
+  if tmp = 0 then
+    x := 0;
+  end;
+end;
+
+rule begin
+  tmp := x;
+  if tmp > 0 then
+    x := tmp - 1;
+  end;
+end;
@@ -0,0 +1,29 @@
+-- rumur_flags: ['--symmetry-reduction', 'heuristic', '--canonicalisation-cache', '1024']
+-- checker_output: None if xml else re.compile(r'\b21 states\b.*\bcanonicalisations served from cache\b', re.DOTALL)
+
+-- This model exercises caching of heuristic canonicalisation results. Each
+-- state is generated many times by different rules, so canonicalisations of
+-- repeated states should be served from the cache. The cache must not alter
+-- the reduced state space.
+
+type
+  proc: scalarset(5);
+
+var
+  st: array[proc] of 0 .. 2;
+
+startstate begin
+  for p: proc do
+    st[p] := 0;
+  end;
+end;
+
+ruleset p: proc do
+  rule st[p] < 2 ==> begin
+    st[p] := st[p] + 1;
+  end;
+
+  rule st[p] = 2 ==> begin
+    st[p] := 0;
+  end;
+end;
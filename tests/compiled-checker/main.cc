@@ -0,0 +1,300 @@
+/// @file
+/// @brief Test building a checker in-process and running it repeatedly
+///
+/// This exercises the API used by programs that want to generate and compile a
+/// checker once and then run it many times, checking that the structured
+/// results it returns match what the checker found. Any arguments configure an
+/// SMT solver, as they would for rumur, enabling an extra check that building a
+/// checker with SMT simplification is unaffected by models built before it.
+
+#include <compiled-checker.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <options.h>
+#include <rumur/rumur.h>
+#include <sstream>
+#include <sys/types.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace rumur;
+
+// the process that registered exit_handler
+static pid_t host;
+
+// an exit handler that should only ever run in the host, not in a checker
+static void exit_handler(void) {
+  if (getpid() != host)
+    abort();
+}
+
+// parse a model and build a checker for it
+static std::unique_ptr<CompiledChecker>
+build(const char *src, const Options &opts = Options()) {
+  std::istringstream ss{src};
+  Ptr<Model> m = parse_model(ss);
+  return CompiledChecker::build(m, opts);
+}
+
+int main(int argc, char **argv) {
+
+  Options smt;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--smt-path") == 0 && i + 1 < argc) {
+      smt.smt.path = argv[++i];
+    } else if (strncmp(argv[i], "--smt-arg=", strlen("--smt-arg=")) == 0) {
+      smt.smt.args.emplace_back(argv[i] + strlen("--smt-arg="));
+    } else if (strcmp(argv[i], "--smt-prelude") == 0 && i + 1 < argc) {
+      smt.smt.prelude.emplace_back(argv[++i]);
+    } else {
+      std::cerr << "unrecognised argument " << argv[i] << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  smt.smt.simplification = SmtSimplification::ON;
+
+  // a model that counts up to 10 and back to 0, with 11 reachable states
+  const char passing[] = "\
+  var\
+    x: 0 .. 10;\
+  \
+  startstate begin\
+    x := 0;\
+  end;\
+  \
+  rule x < 10 ==> begin\
+    x := x + 1;\
+  end;\
+  \
+  rule x = 10 ==> begin\
+    x := 0;\
+  end;\
+  \
+  invariant x <= 10;\
+  ";
+
+  // the same, but starting from every value and with an invariant that five of
+  // these violate
+  const char failing[] = "\
+  var\
+    x: 0 .. 10;\
+  \
+  ruleset i: 0 .. 10 do\
+    startstate begin\
+      x := i;\
+    end;\
+  end;\
+  \
+  rule x < 10 ==> begin\
+    x := x + 1;\
+  end;\
+  \
+  rule x = 10 ==> begin\
+    x := 0;\
+  end;\
+  \
+  invariant x <= 5;\
+  ";
+
+  std::unique_ptr<CompiledChecker> ok = build(passing);
+  std::unique_ptr<CompiledChecker> bad = build(failing);
+
+  // run each checker a few times, to make sure a run leaves no trace that
+  // affects the next
+  for (int i = 0; i < 3; ++i) {
+
+    CompiledChecker::Result r = ok->run();
+    std::cout << "passing run " << i << ": status " << r.status << ", "
+              << r.states << " states, " << r.rules_fired << " rules fired, "
+              << r.errors << " errors\n";
+    if (!r.completed || r.status != EXIT_SUCCESS || r.states != 11 ||
+        r.rules_fired != 11 || r.errors != 0) {
+      std::cerr << "unexpected result from passing model\n";
+      return EXIT_FAILURE;
+    }
+
+    r = bad->run();
+    std::cout << "failing run " << i << ": status " << r.status << ", "
+              << r.states << " states, " << r.rules_fired << " rules fired, "
+              << r.errors << " errors\n";
+    if (!r.completed || r.status == EXIT_SUCCESS || r.errors != 1) {
+      std::cerr << "unexpected result from failing model\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // settings given at runtime should take effect without rebuilding
+  {
+    CompiledChecker::Result r = bad->run({"--max-errors", "3", "--threads=1"});
+    std::cout << "failing run with --max-errors 3: status " << r.status << ", "
+              << r.errors << " errors\n";
+    if (!r.completed || r.status == EXIT_SUCCESS || r.errors != 3) {
+      std::cerr << "unexpected result from failing model with --max-errors\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // a multithreaded caller should be able to run checkers from several threads
+  // at once
+  {
+    std::vector<CompiledChecker::Result> results(4);
+    std::vector<std::thread> threads;
+    for (CompiledChecker::Result &r : results)
+      threads.emplace_back([&ok, &r]() { r = ok->run({"--threads=1"}); });
+    for (std::thread &t : threads)
+      t.join();
+    for (const CompiledChecker::Result &r : results) {
+      std::cout << "concurrent run: status " << r.status << ", " << r.states
+                << " states\n";
+      if (!r.completed || r.status != EXIT_SUCCESS || r.states != 11) {
+        std::cerr << "unexpected result from concurrent run\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // an invalid setting should be rejected before checking starts, without
+  // running our exit handlers in the child
+  {
+    host = getpid();
+    if (atexit(exit_handler) != 0) {
+      std::cerr << "failed to register exit handler\n";
+      return EXIT_FAILURE;
+    }
+    CompiledChecker::Result r = ok->run({"--set-expand-threshold", "0"});
+    std::cout << "run with invalid argument: status " << r.status << "\n";
+    if (r.completed || r.status == EXIT_SUCCESS) {
+      std::cerr << "invalid argument was accepted\n";
+      return EXIT_FAILURE;
+    }
+    if (r.status != EXIT_FAILURE) {
+      std::cerr << "checker ran the host's exit handlers\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // variables found dead in one model should not be reset in the next
+  {
+    // two models with the same variables, but where t is only dead in the
+    // first
+    const char dead[] = "\
+    var\
+      x: 0 .. 3;\
+      t: 0 .. 3;\
+    \
+    startstate begin\
+      x := 0;\
+      t := 0;\
+    end;\
+    \
+    rule begin\
+      t := x;\
+      x := (t + 1) % 4;\
+    end;\
+    ";
+    const char live[] = "\
+    var\
+      x: 0 .. 3;\
+      t: 0 .. 3;\
+    \
+    startstate begin\
+      x := 0;\
+      t := 0;\
+    end;\
+    \
+    rule begin\
+      x := (x + 1) % 4;\
+    end;\
+    \
+    invariant t = 0;\
+    ";
+
+    Options auto_undefine;
+    auto_undefine.auto_undefine = true;
+    std::unique_ptr<CompiledChecker> first = build(dead, auto_undefine);
+    CompiledChecker::Result r = first->run();
+    std::cout << "run with --auto-undefine: status " << r.status << ", "
+              << r.states << " states, " << r.errors << " errors\n";
+    if (!r.completed || r.status != EXIT_SUCCESS || r.states != 4) {
+      std::cerr << "unexpected result from model with a dead variable\n";
+      return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<CompiledChecker> second = build(live);
+    r = second->run();
+    std::cout << "run without --auto-undefine: status " << r.status << ", "
+              << r.states << " states, " << r.errors << " errors\n";
+    if (!r.completed || r.status != EXIT_SUCCESS || r.states != 4) {
+      std::cerr << "variable was reset after being found dead in another "
+                   "model\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // what the SMT solver proved about one model should not be applied to the
+  // next
+  if (smt.smt.path != "") {
+
+    // two models that differ only in the bounds of an array, so their nodes
+    // have the same identifiers but only the first's accesses are in bounds
+    const char in_bounds[] = "\
+    var\
+      x: 0 .. 4;\
+      a: array[0 .. 4] of boolean;\
+    \
+    startstate begin\
+      x := 0;\
+      clear a;\
+    end;\
+    \
+    rule x < 4 ==> begin\
+      x := x + 1;\
+    end;\
+    \
+    rule begin\
+      a[x] := !a[x];\
+    end;\
+    ";
+    const char out_of_bounds[] = "\
+    var\
+      x: 0 .. 4;\
+      a: array[0 .. 3] of boolean;\
+    \
+    startstate begin\
+      x := 0;\
+      clear a;\
+    end;\
+    \
+    rule x < 4 ==> begin\
+      x := x + 1;\
+    end;\
+    \
+    rule begin\
+      a[x] := !a[x];\
+    end;\
+    ";
+
+    std::unique_ptr<CompiledChecker> first = build(in_bounds, smt);
+    CompiledChecker::Result r = first->run();
+    std::cout << "in bounds run with SMT: status " << r.status << ", "
+              << r.errors << " errors\n";
+    if (!r.completed || r.status != EXIT_SUCCESS || r.errors != 0) {
+      std::cerr << "unexpected result from in bounds model\n";
+      return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<CompiledChecker> second = build(out_of_bounds, smt);
+    r = second->run();
+    std::cout << "out of bounds run with SMT: status " << r.status << ", "
+              << r.errors << " errors\n";
+    if (!r.completed || r.status == EXIT_SUCCESS || r.errors != 1) {
+      std::cerr << "out of bounds access was not detected\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+-- rumur_flags: ['--bound', '25', '--deepen', '4', '--deadlock-detection', 'off']
+-- checker_output: None if xml else re.compile(r'\bdepth 10 complete: 11 states at this depth, 66 in total\b.*\bdepth 20 complete: 1 states at this depth, 121 in total\b(?:(?!\bdepth 21\b).)*\Z', re.DOTALL)
+
+-- This model exercises iterative deepening. Every path to a given state has the
+-- same length, so the number of states completed at each depth does not depend
+-- on the order in which threads explore them. Exploration should continue
+-- across rounds until all 121 states are found and stop without reaching the
+-- bound.
+
+var
+  x: 0 .. 10;
+  y: 0 .. 10;
+
+startstate begin
+  x := 0;
+  y := 0;
+end;
+
+rule x < 10 ==> begin
+  x := x + 1;
+end;
+
+rule y < 10 ==> begin
+  y := y + 1;
+end;
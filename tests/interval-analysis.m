@@ -0,0 +1,24 @@
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'write of out-of-range value into y\b')
+
+-- This model exercises the interval analysis Rumur uses to omit runtime overflow
+-- and range checks it can prove are unnecessary. The assignment to z is always
+-- in range, so its check can be elided. The assignment to y can exceed the
+-- range of y, so its check must be retained and should fire.
+
+var
+  x: 0 .. 10;
+  y: 0 .. 15;
+  z: 0 .. 20;
+
+startstate begin
+  x := 0;
+  y := 0;
+  z := 0;
+end;
+
+rule x < 10 ==> begin
+  x := x + 1;
+  z := x + x;
+  y := x + x;
+end;
@@ -0,0 +1,83 @@
+/// @file
+/// @brief Benchmark of the librumur parser
+///
+/// This reads each model given on the command line and repeatedly parses it,
+/// reporting the throughput of the parser. It is a benchmark for work on the
+/// front end that all the Rumur tools share. When run as part of the test
+/// suite, it is only used to check that parsing works with the options it uses.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <rumur/rumur.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace rumur;
+
+int main(int argc, char **argv) {
+
+  if (argc < 2 || strcmp(argv[1], "--help") == 0) {
+    std::cerr << "Murphi parser benchmark\n"
+              << " usage: " << argv[0] << " [--iterations N] filename...\n";
+    return EXIT_FAILURE;
+  }
+
+  size_t iterations = 10;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      ++i;
+      iterations = strtoul(argv[i], nullptr, 10);
+      continue;
+    }
+    paths.push_back(argv[i]);
+  }
+
+  // read all the inputs up front so we only time parsing
+  std::vector<std::string> sources;
+  size_t bytes = 0;
+  for (const std::string &path : paths) {
+    std::ifstream in(path);
+    if (!in) {
+      std::cerr << "failed to open " << path << "\n";
+      return EXIT_FAILURE;
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    sources.push_back(buffer.str());
+    bytes += sources.back().size();
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    for (size_t j = 0; j < sources.size(); ++j) {
+      std::istringstream in(sources[j]);
+      try {
+        Ptr<Model> m = parse_model(in);
+      } catch (std::exception &e) {
+        std::cerr << paths[j] << ": " << e.what() << "\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const double seconds =
+      std::chrono::duration_cast<std::chrono::duration<double>>(end - start)
+          .count();
+  const double total = static_cast<double>(bytes) * iterations;
+
+  std::cout << "parsed " << sources.size() << " file(s) totalling " << bytes
+            << " bytes " << iterations << " time(s) in " << seconds << "s\n";
+  if (seconds > 0)
+    std::cout << "throughput: " << (total / seconds / 1024 / 1024)
+              << " MiB/s\n";
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+-- rumur_flags: ['--search', 'best-first']
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'\binvariant "target" failed\b.*\b\d{1,3} states\b', re.DOTALL)
+
+-- This model checks that an error while evaluating the heuristic for one
+-- invariant does not stop the other invariants guiding best-first search. The
+-- distance to violating "guard" indexes out of range in every state, even
+-- though checking the invariant itself never does. Only "target" can give
+-- useful guidance, without which search would explore thousands of states.
+
+var
+  a: array[0 .. 3] of 0 .. 20;
+  i: 0 .. 5;
+
+startstate begin
+  for j: 0 .. 3 do
+    a[j] := 0;
+  end;
+  i := 5;
+end;
+
+ruleset j: 0 .. 3 do
+  rule a[j] < 20 ==> begin
+    a[j] := a[j] + 1;
+  end;
+end;
+
+invariant "guard" i > 3 | a[i] != 20;
+
+invariant "target" a[0] != 20;
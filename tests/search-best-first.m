@@ -0,0 +1,35 @@
+-- rumur_flags: ['--search', 'best-first']
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'\binvariant "target" failed\b.*\b\d{1,3} states\b', re.DOTALL)
+
+-- This model exercises best-first search. The invariant is violated in a
+-- corner of the state space that breadth-first search would reach after
+-- exploring thousands of states. Guided by the distance to the violating
+-- values of x and y, best-first search should get there much sooner.
+
+var
+  x: 0 .. 60;
+  y: 0 .. 60;
+
+startstate begin
+  x := 0;
+  y := 0;
+end;
+
+rule x < 60 ==> begin
+  x := x + 1;
+end;
+
+rule y < 60 ==> begin
+  y := y + 1;
+end;
+
+rule x > 0 ==> begin
+  x := x - 1;
+end;
+
+rule y > 0 ==> begin
+  y := y - 1;
+end;
+
+invariant "target" !(x = 50 & y = 55);
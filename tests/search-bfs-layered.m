@@ -0,0 +1,31 @@
+-- rumur_flags: ['--search', 'bfs-layered']
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'\bStartstate\b((?:(?!\bRule\b).)*\bRule\b){40}(?:(?!\bRule\b).)*\Z', re.DOTALL)
+
+-- This model exercises strict breadth-first exploration. The invariant can be
+-- violated after 40 steps, but many longer paths lead to the same state. The
+-- counterexample trace should be the shortest one, even when multithreaded.
+
+var
+  x: 0 .. 30;
+  y: 0 .. 30;
+
+startstate begin
+  x := 0;
+  y := 0;
+end;
+
+rule x < 30 ==> begin
+  x := x + 1;
+end;
+
+rule y < 30 ==> begin
+  y := y + 1;
+end;
+
+rule x > 0 & y > 0 ==> begin
+  x := x - 1;
+  y := y - 1;
+end;
+
+invariant !(x = 20 & y = 20);
@@ -0,0 +1,28 @@
+-- rumur_flags: ['--search', 'dfs']
+-- checker_output: None if xml else re.compile(r'\b961 states\b')
+
+-- This model exercises depth-first exploration. Every one of the 31 x 31
+-- combinations of x and y is reachable, and all of them should be found even
+-- when threads steal work from each other.
+
+var
+  x: 0 .. 30;
+  y: 0 .. 30;
+
+startstate begin
+  x := 0;
+  y := 0;
+end;
+
+rule x < 30 ==> begin
+  x := x + 1;
+end;
+
+rule y < 30 ==> begin
+  y := y + 1;
+end;
+
+rule x > 0 & y > 0 ==> begin
+  x := x - 1;
+  y := y - 1;
+end;
@@ -0,0 +1,24 @@
+-- rumur_flags: ['--simulate', '1000', '--seed', '1']
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'\binvariant "bounded" failed\b.*\bRule "(one|two)" fired\b.*\bEnd of the error trace\b', re.DOTALL)
+
+-- This model exercises random walk simulation. Whichever rule each step
+-- chooses, x eventually exceeds the invariant's limit, so every walk should
+-- find the violation and print a trace of how it got there.
+
+var
+  x: 0 .. 30;
+
+startstate begin
+  x := 0;
+end;
+
+rule "one" x < 30 ==> begin
+  x := x + 1;
+end;
+
+rule "two" x < 29 ==> begin
+  x := x + 2;
+end;
+
+invariant "bounded" x < 20;
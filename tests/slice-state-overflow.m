@@ -0,0 +1,24 @@
+-- rumur_flags: ['--slice-state', 'on']
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'\bwrite of out-of-range value into c\b')
+
+-- This model checks that state slicing does not remove writes that can fail.
+-- Nothing reads c in a way that influences the model's behaviour, but the
+-- increment of c overflows its range after three steps. This error needs to be
+-- reported, so c and its writes have to be retained.
+
+var
+  x: 0 .. 3;
+  c: 0 .. 3;
+
+startstate begin
+  x := 0;
+  c := 0;
+end;
+
+rule begin
+  x := (x + 1) % 4;
+  c := c + 1;
+end;
+
+invariant x <= 3;
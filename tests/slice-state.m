@@ -0,0 +1,32 @@
+-- rumur_flags: ['--slice-state', 'on']
+-- checker_output: None if xml else re.compile(r'\b4 states\b')
+
+-- This model exercises state slicing. The variables parity and history are only
+-- ever written, never read in a way that influences the model's behaviour, and
+-- none of these writes can fail, so they should be sliced. Without this, they
+-- would double the number of states explored from 4 to 8. The variable y is
+-- written from x and is read by the invariant, so it and x need to be retained.
+
+var
+  x: 0 .. 3;
+  y: 0 .. 3;
+  parity: boolean;
+  history: array [0 .. 3] of boolean;
+
+startstate begin
+  x := 0;
+  y := 0;
+  parity := false;
+  clear history;
+end;
+
+rule begin
+  history[x] := !history[x];
+  if x = 0 then
+    parity := !parity;
+  end;
+  x := (x + 1) % 4;
+  y := x;
+end;
+
+invariant y = x;
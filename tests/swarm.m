@@ -0,0 +1,36 @@
+-- rumur_flags: ['--swarm', '65536', '--seed', '1', '--threads', '2']
+-- checker_output: None if xml else re.compile(r'\b200 states\b')
+
+-- This model exercises swarm verification. Each worker should search the
+-- entire state space independently, so the total number of states seen is
+-- the number of states multiplied by the number of threads. The thread count
+-- is fixed so this total does not depend on the machine.
+
+var
+  x: 0 .. 9;
+  y: 0 .. 9;
+
+startstate begin
+  x := 0;
+  y := 0;
+end;
+
+rule x < 9 ==> begin
+  x := x + 1;
+end;
+
+rule y < 9 ==> begin
+  y := y + 1;
+end;
+
+rule x > 0 & y > 0 ==> begin
+  x := x - 1;
+  y := y - 1;
+end;
+
+rule x = 9 & y = 9 ==> begin
+  x := 0;
+  y := 0;
+end;
+
+invariant x + y <= 18;
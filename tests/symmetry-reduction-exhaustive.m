@@ -0,0 +1,31 @@
+-- rumur_flags: ['--symmetry-reduction', 'exhaustive', '--scalarset-schedules', 'off']
+-- checker_output: None if xml else re.compile(r'\b91 states\b')
+
+-- This model exercises exhaustive symmetry reduction on a scalarset too large
+-- to canonicalise by trying every permutation (12! ≈ 479 million). Elements
+-- are distinguishable by their local state, so only permutations among
+-- elements with identical local state need be considered, and those are all
+-- automorphisms. Exact reduction should leave one state per multiset of local
+-- states, of which there are (12 + 2) choose 2 = 91.
+
+type
+  proc: scalarset(12);
+
+var
+  st: array[proc] of 0 .. 2;
+
+startstate begin
+  for p: proc do
+    st[p] := 0;
+  end;
+end;
+
+ruleset p: proc do
+  rule st[p] < 2 ==> begin
+    st[p] := st[p] + 1;
+  end;
+
+  rule st[p] = 2 ==> begin
+    st[p] := 0;
+  end;
+end;
@@ -0,0 +1,34 @@
+-- rumur_flags: ['--symmetry-reduction', 'multi']
+-- checker_output: None if xml else re.compile(r'\b282 states\b')
+
+-- This model exercises multiple-representative symmetry reduction. Elements
+-- that point at each other cannot be told apart by sorting, so heuristic
+-- symmetry reduction explores 1280 states here. Exhaustive symmetry reduction
+-- finds the 218 equivalence classes. The local search performed by the multi
+-- mode should land in between these.
+
+type
+  proc: scalarset(4);
+
+var
+  next: array[proc] of proc;
+  st: array[proc] of 0 .. 1;
+
+startstate begin
+  for p: proc do
+    next[p] := p;
+    st[p] := 0;
+  end;
+end;
+
+ruleset p: proc; q: proc do
+  rule "link" next[p] != q ==> begin
+    next[p] := q;
+  end;
+end;
+
+ruleset p: proc do
+  rule "flip" st[p] = 0 ==> begin
+    st[p] := 1;
+  end;
+end;
@@ -376,6 +376,7 @@ def smt_bv_args():
             "cvc4",
             "--smt-arg=--lang=smt2",
             "--smt-arg=--rewrite-divk",
+            "--smt-arg=--incremental",
             "--smt-prelude",
             "(set-logic AUFBV)",
             "--smt-bitvectors",
@@ -402,6 +403,7 @@ def smt_args():
             "cvc4",
             "--smt-arg=--lang=smt2",
             "--smt-arg=--rewrite-divk",
+            "--smt-arg=--incremental",
             "--smt-prelude",
             "(set-logic AUFLIA)",
         ]
@@ -1250,6 +1252,82 @@ def test_stdlib(component, tmp_path):
     )
 
 
+def test_split(tmp_path):
+    """
+    a checker emitted as multiple translation units should behave the same as one
+    emitted as a single file
+    """
+
+    model = textwrap.dedent(
+        """
+    const N: 4;
+    type t: 0 .. N;
+    var x: array [0 .. 1] of t;
+    var y: boolean;
+
+    function inc(v: t): t; begin
+      return v + 1;
+    end;
+
+    startstate begin
+      x[0] := 0;
+      x[1] := 0;
+      y := false;
+    end;
+
+    ruleset i: 0 .. 1 do
+      rule "increment" x[i] < N ==> begin
+        x[i] := inc(x[i]);
+      end;
+    end;
+
+    rule "flip" begin
+      y := !y;
+    end;
+
+    invariant "bounded" x[0] + x[1] < 2 * N;
+    """
+    )
+
+    results = []
+    for split in (False, True):
+
+        if split:
+            output = tmp_path / "split"
+            argv = ["rumur", "--split", "1", "--output", output]
+        else:
+            output = tmp_path / "model.c"
+            argv = ["rumur", "--output", output]
+        ret, stdout, stderr = run(argv, model)
+        assert ret == 0, "Rumur failed:\n{}{}".format(stdout, stderr)
+
+        # with one rule per unit, every rule should be in its own file
+        if split:
+            rules = sorted(p.name for p in output.glob("rules-*.c"))
+            assert rules == [f"rules-{i}.c" for i in range(4)]
+            sources = sorted(output.glob("*.c"))
+        else:
+            sources = [output]
+
+        model_bin = tmp_path / "model.exe"
+        args = [cc()] + c_flags() + ["-O3", "-o", model_bin] + sources + ["-lpthread"]
+        if needs_libatomic():
+            args += ["-latomic"]
+        ret, stdout, stderr = run(args)
+        assert ret == 0, "C compilation failed:\n{}{}".format(stdout, stderr)
+
+        # the checker should find the invariant violation and print a trace
+        ret, stdout, stderr = run([model_bin])
+        assert ret != 0, "invariant violation not detected"
+        assert 'invariant "bounded" failed' in stdout
+        results.append(stdout)
+
+    def strip_time(output):
+        return re.sub(r"in \d+s", "", output)
+
+    assert strip_time(results[0]) == strip_time(results[1]), "split checker differs"
+
+
 MODELS = sorted([p.name for p in Path(__file__).parent.iterdir() if p.suffix == ".m"])
 """test cases defined as .m files in this directory"""
 
@@ -1923,6 +2001,63 @@ def test_193():
     assert stderr.count("sorted fields {a, b, c} -> {a, c, b}") == 2
 
 
+def test_interval_analysis():
+    """
+    Running interval-analysis.m only shows that the checks Rumur retains still
+    fire. Check the generated code to confirm the others were really elided.
+    """
+
+    model = Path(__file__).parent / "interval-analysis.m"
+
+    ret, model_c, stderr = run(["rumur", "--output", "/dev/stdout", model])
+    assert ret == 0, f"rumur failed:\n{stderr}"
+
+    # the range check on writes to z should be gone, while that on y stays
+    assert '"z", s,' not in model_c, "range check on z was not elided"
+    assert '"y", s,' in model_c, "range check on y was elided"
+    assert "handle_write_unchecked(s, VALUE_C(0), VALUE_C(20), ru_z," in model_c
+
+
+@pytest.mark.skipif(smt_args() is None, reason="SMT solver not available")
+def test_smt_cache(tmp_path):
+    """
+    A model rebuilt with an SMT cache should be simplified the same way as the
+    first time, without calling the solver.
+    """
+
+    model = textwrap.dedent(
+        """
+    var x: 0 .. 10;
+
+    startstate begin
+      x := 0;
+    end
+
+    rule x < 10 ==> begin
+      if x >= 0 then
+        x := x + 1;
+      end;
+    end
+    """
+    )
+
+    cache = tmp_path / "cache"
+
+    outputs = []
+    for i in range(2):
+        output = tmp_path / f"model{i}.c"
+        argv = ["rumur", "--output", output, "--debug", "--smt-cache", cache]
+        ret, _, stderr = run(argv + smt_args(), model)
+        assert ret == 0, "rumur failed"
+        outputs.append((output.read_text(), stderr))
+
+    assert outputs[0][0] == outputs[1][0], "cached results changed simplification"
+    assert "checking SMT problem" in outputs[0][1], "solver was not called"
+    assert (
+        "checking SMT problem" not in outputs[1][1]
+    ), "solver was called despite cached results"
+
+
 @pytest.mark.parametrize("arch", ("aarch64", "i386", "x86-64"))
 def test_lock_freedom(arch):
     """
@@ -2277,7 +2412,7 @@ def test_murphi2murphi_unicode_to_ascii():
     assert ret == 0
 
 
-def test_rumur_run_model():
+def test_rumur_run_model(monkeypatch, tmp_path):
     """test that rumur-run can check a basic model"""
 
     rumur_run = Path(__file__).absolute().parents[1] / "rumur/src/rumur-run"
@@ -2295,10 +2430,150 @@ def test_rumur_run_model():
     end;
     """
 
+    # keep built checkers out of the user's real cache
+    monkeypatch.setenv("RUMUR_RUN_CACHE", str(tmp_path / "cache"))
+
     ret, _, _ = run([sys.executable, rumur_run], model)
     assert ret == 0
 
 
+def test_rumur_run_cache(monkeypatch, tmp_path):
+    """
+    rumur-run should reuse a previously built checker when the generated code is
+    unchanged, even if the model file itself has been touched
+    """
+
+    rumur_run = Path(__file__).absolute().parents[1] / "rumur/src/rumur-run"
+
+    model = tmp_path / "model.m"
+    model.write_text(
+        textwrap.dedent(
+            """
+    var
+      x: boolean;
+
+    startstate begin
+      x := true;
+    end;
+
+    rule begin
+      x := !x;
+    end;
+    """
+        ),
+        encoding="utf-8",
+    )
+
+    cache = tmp_path / "cache"
+    monkeypatch.setenv("RUMUR_RUN_CACHE", str(cache))
+
+    ret, stdout, _ = run([sys.executable, rumur_run, model])
+    assert ret == 0
+    assert "Compiling the checker" in stdout
+    assert len(list(cache.iterdir())) == 1, "checker was not cached"
+
+    os.utime(model)
+
+    ret, stdout, _ = run([sys.executable, rumur_run, model])
+    assert ret == 0
+    assert "Using the cached checker" in stdout, "cached checker was not used"
+    assert "Compiling the checker" not in stdout
+
+    # a change affecting the generated code should cause a rebuild
+    ret, stdout, _ = run([sys.executable, rumur_run, "--bound", "3", model])
+    assert ret == 0
+    assert "Compiling the checker" in stdout
+    assert len(list(cache.iterdir())) == 2
+
+
+def test_rumur_run_pgo(monkeypatch, tmp_path):
+    """
+    rumur-run should be able to build and run a profile-optimised checker
+    """
+
+    rumur_run = Path(__file__).absolute().parents[1] / "rumur/src/rumur-run"
+
+    model = tmp_path / "model.m"
+    model.write_text(
+        textwrap.dedent(
+            """
+    var
+      x: 0 .. 10;
+
+    startstate begin
+      x := 0;
+    end;
+
+    rule x < 10 ==> begin
+      x := x + 1;
+    end;
+
+    rule x = 10 ==> begin
+      x := 0;
+    end;
+    """
+        ),
+        encoding="utf-8",
+    )
+
+    monkeypatch.setenv("RUMUR_RUN_CACHE", "")
+
+    ret, stdout, stderr = run([sys.executable, rumur_run, "--pgo=1", model])
+    assert ret == 0, f"rumur-run --pgo failed: {stdout}\n{stderr}"
+
+    # if the compiler supports it, we should have been through a training run
+    if "not supported" not in stderr:
+        assert "Training the checker" in stdout
+        assert re.search(r"without profile: (\d+ states/s|unknown)", stdout)
+
+
+def test_rumur_run_runtime_options(monkeypatch, tmp_path):
+    """
+    options the checker accepts at runtime should be passed to it, letting runs
+    that differ only in these share a cached checker
+    """
+
+    rumur_run = Path(__file__).absolute().parents[1] / "rumur/src/rumur-run"
+
+    model = tmp_path / "model.m"
+    model.write_text(
+        textwrap.dedent(
+            """
+    var
+      x: 0 .. 10;
+
+    ruleset i: 0 .. 10 do
+      startstate begin
+        x := i;
+      end;
+    end;
+
+    rule x < 10 ==> begin
+      x := x + 1;
+    end;
+
+    invariant x <= 5;
+    """
+        ),
+        encoding="utf-8",
+    )
+
+    cache = tmp_path / "cache"
+    monkeypatch.setenv("RUMUR_RUN_CACHE", str(cache))
+
+    ret, stdout, _ = run([sys.executable, rumur_run, "--color=off", model])
+    assert ret != 0
+    assert "Compiling the checker" in stdout
+    assert "1 error(s) found" in stdout
+
+    ret, stdout, _ = run(
+        [sys.executable, rumur_run, "--max-errors", "3", "--color=off", model]
+    )
+    assert ret != 0
+    assert "Using the cached checker" in stdout, "runtime option changed checker"
+    assert "3 error(s) found" in stdout
+
+
 def test_rumur_run_version():
     """basic test that rumur-run can execute successfully"""
 
@@ -2535,6 +2810,34 @@ def test_debian_tests(testcase, tmp_path):
     )
 
 
+@pytest.mark.skipif(
+    shutil.which("ast-sharing") is None, reason="tester binary not found"
+)
+def test_ast_sharing():
+    """see ast-sharing/main.cc"""
+    ret = sp.call(["ast-sharing"])
+    assert ret == 0, "AST nodes were copied or shared unexpectedly"
+
+
+@pytest.mark.skipif(
+    shutil.which("compiled-checker") is None, reason="tester binary not found"
+)
+def test_compiled_checker():
+    """see compiled-checker/main.cc"""
+    ret = sp.call(["compiled-checker"])
+    assert ret == 0, "in-process checker returned unexpected results"
+
+
+@pytest.mark.skipif(
+    shutil.which("compiled-checker") is None, reason="tester binary not found"
+)
+@pytest.mark.skipif(smt_args() is None, reason="SMT solver not available")
+def test_compiled_checker_smt():
+    """see compiled-checker/main.cc"""
+    ret = sp.call(["compiled-checker"] + smt_args())
+    assert ret == 0, "in-process checker with SMT returned unexpected results"
+
+
 @pytest.mark.parametrize("arg", ("array", "index"))
 @pytest.mark.skipif(
     shutil.which("element-is-pure") is None, reason="tester binary not found"
@@ -2545,6 +2848,24 @@ def test_element_is_pure(arg):
     assert ret == 0, "impure array indexing expression considered pure"
 
 
+@pytest.mark.skipif(
+    shutil.which("parse-throughput") is None, reason="tester binary not found"
+)
+def test_parse_throughput():
+    """see parse-throughput/main.cc"""
+
+    # the models Rumur is expected to accept
+    models = []
+    for model in MODELS:
+        testcase = Path(__file__).parent / model
+        tweaks = dict(parse_test_options(testcase))
+        if tweaks.get("rumur_exit_code", 0) == 0:
+            models.append(str(testcase))
+
+    ret = sp.call(["parse-throughput", "--iterations", "1"] + models)
+    assert ret == 0, "parser benchmark failed"
+
+
 @pytest.mark.skipif(
     shutil.which("union-array-width") is None, reason="tester binary not found"
 )
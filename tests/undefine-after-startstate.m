@@ -0,0 +1,21 @@
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'read of undefined value in x\b')
+
+-- Rumur omits checks for undefined values when reading state variables that
+-- every start state defines. This model tests that a later undefine of such a
+-- variable is noticed and these checks are retained.
+
+var
+  x: 0 .. 5;
+
+startstate begin
+  x := 0;
+end;
+
+rule x < 5 ==> begin
+  x := x + 1;
+end;
+
+rule "reset" x = 5 ==> begin
+  undefine x;
+end;
@@ -0,0 +1,23 @@
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'read of undefined value in x\b')
+
+-- Rumur omits checks for undefined values when reading state variables that
+-- every start state defines. This model tests that a definition following an
+-- early return from a start state is not counted, as the return accepts the
+-- state with the variable still undefined.
+
+var
+  c: boolean;
+  x: 0 .. 5;
+
+startstate begin
+  c := true;
+  if c then
+    return;
+  endif;
+  x := 0;
+end;
+
+rule x < 5 ==> begin
+  x := x + 1;
+end;
@@ -0,0 +1,27 @@
+-- checker_exit_code: 1
+-- checker_output: None if xml else re.compile(r'read of undefined value in y\b')
+
+-- Rumur omits checks for undefined values when reading state variables that
+-- every start state defines. This model tests that a variable left undefined by
+-- a start state retains these checks.
+
+var
+  x: 0 .. 5;
+  y: 0 .. 5;
+
+startstate begin
+  x := 0;
+end;
+
+startstate begin
+  x := 1;
+  y := 1;
+end;
+
+rule x < 5 ==> begin
+  x := x + 1;
+end;
+
+rule x = 3 ==> begin
+  x := y;
+end;